@@ -0,0 +1,177 @@
+#include "../include/terminal/process.h"
+#include "../include/terminal/output_capture.h"
+#include "../include/terminal/process_reactor.h"
+#include "../include/common/thread_pool.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sys/resource.h>
+
+using namespace NeuroShell;
+using Clock = std::chrono::steady_clock;
+
+// Usage: reactor_benchmark [commands] [command line]
+//
+// Starts every command at once and waits for all of them: with a thread per
+// command blocked in Drain()/WaitForExit(), with the same work queued on a
+// thread pool (the previous backend, where commands wait for a free worker),
+// and through the single reactor thread. Latency runs from the spawn call
+// until the exit is reported with all output read.
+
+struct Result {
+    double totalSeconds;
+    std::vector<double> latenciesMs;
+    size_t outputBytes;
+};
+
+// Tracks outstanding commands so the main thread can wait for the last one
+class Countdown {
+public:
+    explicit Countdown(size_t count) : count_(count) {}
+
+    void Done() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--count_ == 0) done_.notify_all();
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return count_ == 0; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable done_;
+    size_t count_;
+};
+
+Result RunThreads(int commands, const SpawnOptions& options) {
+    Result result;
+    result.latenciesMs.resize(commands);
+    std::atomic<size_t> bytes(0);
+    std::vector<std::thread> threads;
+
+    auto start = Clock::now();
+    for (int i = 0; i < commands; ++i) {
+        auto spawnedAt = Clock::now();
+        ChildProcess child = SpawnProcess(options);
+        threads.emplace_back([&, child, spawnedAt, i]() mutable {
+            OutputCapture::Drain(child, [&bytes](OutputStream, const char*, size_t size) { bytes += size; });
+            WaitForExit(child);
+            std::chrono::duration<double, std::milli> latency = Clock::now() - spawnedAt;
+            result.latenciesMs[i] = latency.count();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> total = Clock::now() - start;
+    result.totalSeconds = total.count();
+    result.outputBytes = bytes;
+    return result;
+}
+
+Result RunPool(int commands, const SpawnOptions& options) {
+    Result result;
+    result.latenciesMs.resize(commands);
+    std::atomic<size_t> bytes(0);
+    Countdown remaining(commands);
+    ThreadPool pool;
+
+    auto start = Clock::now();
+    for (int i = 0; i < commands; ++i) {
+        // As in the previous backend, the worker spawns the command and then waits on it
+        auto spawnedAt = Clock::now();
+        pool.Submit([&, spawnedAt, i]() {
+            ChildProcess child = SpawnProcess(options);
+            OutputCapture::Drain(child, [&bytes](OutputStream, const char*, size_t size) { bytes += size; });
+            WaitForExit(child);
+            std::chrono::duration<double, std::milli> latency = Clock::now() - spawnedAt;
+            result.latenciesMs[i] = latency.count();
+            remaining.Done();
+        });
+    }
+    remaining.Wait();
+    std::chrono::duration<double> total = Clock::now() - start;
+    result.totalSeconds = total.count();
+    pool.Shutdown();
+    result.outputBytes = bytes;
+    return result;
+}
+
+Result RunReactor(int commands, const SpawnOptions& options) {
+    Result result;
+    result.latenciesMs.resize(commands);
+    size_t bytes = 0;                       // Only touched on the reactor thread
+    Countdown remaining(commands);
+    ProcessReactor reactor;
+
+    auto start = Clock::now();
+    for (int i = 0; i < commands; ++i) {
+        auto spawnedAt = Clock::now();
+        ChildProcess child = SpawnProcess(options);
+        reactor.Watch(child,
+            [&bytes](OutputStream, const char*, size_t size) { bytes += size; },
+            [&result, &remaining, spawnedAt, i](const ProcessExit&) {
+                std::chrono::duration<double, std::milli> latency = Clock::now() - spawnedAt;
+                result.latenciesMs[i] = latency.count();
+                remaining.Done();
+            });
+    }
+    remaining.Wait();
+    std::chrono::duration<double> total = Clock::now() - start;
+    result.totalSeconds = total.count();
+    reactor.Shutdown();
+    result.outputBytes = bytes;
+    return result;
+}
+
+double Percentile(std::vector<double> values, double fraction) {
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+void Report(const char* name, const Result& result, int threads) {
+    std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed
+              << std::setw(9) << std::setprecision(0) << result.latenciesMs.size() / result.totalSeconds << " cmd/s"
+              << std::setw(9) << std::setprecision(1) << Percentile(result.latenciesMs, 0.50) << " ms p50"
+              << std::setw(9) << Percentile(result.latenciesMs, 0.99) << " ms p99"
+              << std::setw(9) << Percentile(result.latenciesMs, 1.0) << " ms max"
+              << std::setw(7) << threads << " threads"
+              << std::setw(9) << result.outputBytes << " bytes" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int commands = argc > 1 ? std::atoi(argv[1]) : 1000;
+    std::string command = argc > 2 ? argv[2] : "echo done";
+
+    // Each child in flight holds two pipe ends (and a pidfd with the reactor)
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    SpawnOptions options;
+    options.argv = ShellArgv(command);
+
+    std::cout << "\n=== Reactor benchmark: " << commands << " x \"" << command << "\" at once ===\n" << std::endl;
+    Report("threads", RunThreads(commands, options), commands);
+    {
+        ThreadPool sizing;
+        int workers = static_cast<int>(sizing.GetWorkerCount());
+        sizing.Shutdown();
+        Report("pool", RunPool(commands, options), workers);
+    }
+    Report("reactor", RunReactor(commands, options), 1);
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "../include/terminal/process.h"
+#include "../include/terminal/output_capture.h"
+#include "../include/terminal/spawn_zygote.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+using namespace NeuroShell;
+
+// Usage: spawn_benchmark [iterations] [parent RSS in MiB]
+//
+// Spawns /bin/true repeatedly through each path and reports the mean latency.
+// The RSS argument dirties that much heap in the parent first, to show how
+// each path scales as the UI process grows.
+
+double TimeIt(int iterations, const std::function<void()>& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void Report(const char* name, double micros) {
+    std::cout << "  " << std::left << std::setw(14) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+              << micros << " us/spawn" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 500;
+    size_t bloatMb = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 0;
+
+    // The helper has to fork before the parent grows, just as main() does
+    bool zygote = SpawnZygote::Start();
+
+    std::vector<char> bloat(bloatMb * 1024 * 1024);
+    for (size_t i = 0; i < bloat.size(); i += 4096) {
+        bloat[i] = 1;
+    }
+
+    std::cout << "\n=== Spawn benchmark: " << iterations << " x /bin/true, parent +"
+              << bloatMb << " MiB ===\n" << std::endl;
+
+    Report("popen", TimeIt(iterations, []() {
+        FILE* pipe = popen("/bin/true", "r");
+        if (pipe) pclose(pipe);
+    }));
+
+    SpawnOptions options;
+    options.argv = { "/bin/true" };
+
+    Report("posix_spawn", TimeIt(iterations, [&]() {
+        ChildProcess child = SpawnProcess(options);
+        OutputCapture::Drain(child, nullptr);
+        WaitForExit(child);
+    }));
+
+    if (zygote) {
+        Report("zygote", TimeIt(iterations, [&]() {
+            ChildProcess child = SpawnZygote::Spawn(options);
+            OutputCapture::Drain(child, nullptr);
+            WaitForExit(child);
+        }));
+        SpawnZygote::Stop();
+    } else {
+        std::cout << "  zygote        unavailable" << std::endl;
+    }
+
+    std::cout << std::endl;
+    return 0;
+}
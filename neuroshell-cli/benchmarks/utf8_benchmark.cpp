@@ -0,0 +1,109 @@
+#include "../include/common/utf8_sanitizer.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+
+using namespace NeuroShell;
+using Clock = std::chrono::steady_clock;
+
+// Usage: utf8_benchmark [total MB per run]
+//
+// Streams a 64 MB sample through Utf8Sanitizer in 64 KB chunks, the size the
+// capture loop reads, until the total is reached (4 GB by default). Each input
+// runs with every instruction set the CPU supports, next to a plain copy of
+// the same chunks as the memory bandwidth reference.
+
+constexpr size_t kSampleBytes = 64 * 1024 * 1024;
+constexpr size_t kChunkBytes = 64 * 1024;
+
+std::string MakeAsciiLog(std::mt19937& random) {
+    static const char* words[] = { "GET", "/api/v1/items", "200", "INFO", "worker", "request", "completed",
+                                   "in", "ms", "cache", "miss", "user=42", "\t", "-" };
+    std::string text;
+    text.reserve(kSampleBytes);
+    while (text.size() < kSampleBytes) {
+        text += "2024-05-01T12:00:00Z";
+        for (int i = 0; i < 12; ++i) {
+            text += ' ';
+            text += words[random() % 14];
+        }
+        text += '\n';
+    }
+    text.resize(kSampleBytes);
+    return text;
+}
+
+std::string MakeMixedUtf8(std::mt19937& random) {
+    // About a quarter of the characters are multibyte, as in localized output
+    static const char* pieces[] = { "caf\xC3\xA9 ", "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 ",
+                                    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E ", "\xF0\x9F\x98\x80 ",
+                                    "status ok ", "total 42 files ", "\n" };
+    std::string text;
+    text.reserve(kSampleBytes + 64);
+    while (text.size() < kSampleBytes) {
+        text += pieces[random() % 7];
+    }
+    // Cut at a character boundary
+    while ((static_cast<unsigned char>(text[kSampleBytes]) & 0xC0) == 0x80) text.pop_back();
+    text.resize(std::min(text.size(), kSampleBytes));
+    return text;
+}
+
+std::string MakeBinary(std::mt19937& random) {
+    std::string data(kSampleBytes, '\0');
+    for (char& c : data) c = static_cast<char>(random() & 0xFF);
+    return data;
+}
+
+double Run(const std::string& sample, size_t total, SimdLevel* level) {
+    std::string out;
+    out.reserve(kChunkBytes * 3);
+    Utf8Sanitizer sanitizer(level ? *level : SimdLevel::Scalar);
+    size_t checksum = 0;
+
+    auto start = Clock::now();
+    for (size_t done = 0; done < total; ) {
+        for (size_t i = 0; i < sample.size() && done < total; i += kChunkBytes, done += kChunkBytes) {
+            size_t size = std::min(kChunkBytes, sample.size() - i);
+            out.clear();
+            if (level) {
+                sanitizer.Feed(sample.data() + i, size, out);
+            } else {
+                out.append(sample.data() + i, size);
+            }
+            checksum += out.size();
+        }
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    if (checksum == 0) std::cout << "";    // Keep the loop observable
+    return total / elapsed.count() / 1e9;
+}
+
+void Report(const char* input, const std::string& sample, size_t total) {
+    std::cout << "  " << std::left << std::setw(8) << input << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << Run(sample, total, nullptr) << " GB/s copy";
+    for (SimdLevel level = SimdLevel::Scalar; level <= Utf8Sanitizer::BestLevel();
+         level = static_cast<SimdLevel>(static_cast<int>(level) + 1)) {
+        std::cout << std::setw(8) << Run(sample, total, &level) << " GB/s " << std::left << std::setw(7)
+                  << Utf8Sanitizer::LevelName(level) << std::right;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t totalMb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4096;
+    size_t total = totalMb * 1024 * 1024;
+    std::mt19937 random(1);
+
+    std::cout << "\n=== UTF-8 sanitizer benchmark: " << totalMb << " MB per run in "
+              << kChunkBytes / 1024 << " KB chunks ===\n" << std::endl;
+    Report("ascii", MakeAsciiLog(random), total);
+    Report("utf-8", MakeMixedUtf8(random), total);
+    Report("binary", MakeBinary(random), total);
+    std::cout << std::endl;
+    return 0;
+}
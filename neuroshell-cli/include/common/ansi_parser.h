@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Packed span color: the terminal default, an entry of the 256-color palette
+// (0-15 are the theme's ANSI colors), or 24-bit RGB
+constexpr uint32_t kDefaultColor = 0;
+constexpr uint32_t kPaletteColor = 0x01000000;    // | index
+constexpr uint32_t kRgbColor = 0x02000000;        // | 0xRRGGBB
+
+inline uint32_t PaletteColor(int index) { return kPaletteColor | static_cast<uint32_t>(index & 0xFF); }
+inline uint32_t RgbColor(int r, int g, int b) {
+    return kRgbColor | (static_cast<uint32_t>(r & 0xFF) << 16) | (static_cast<uint32_t>(g & 0xFF) << 8)
+                     | static_cast<uint32_t>(b & 0xFF);
+}
+
+enum StyleFlags : uint8_t {
+    StyleBold = 1 << 0,
+    StyleDim = 1 << 1,
+    StyleItalic = 1 << 2,
+    StyleUnderline = 1 << 3,
+    StyleInverse = 1 << 4
+};
+
+// What SGR escape sequences have set up
+struct TextStyle {
+    uint32_t fg;
+    uint32_t bg;
+    uint8_t flags;
+
+    TextStyle()
+        : fg(kDefaultColor)
+        , bg(kDefaultColor)
+        , flags(0)
+    {}
+
+    bool IsDefault() const { return fg == kDefaultColor && bg == kDefaultColor && flags == 0; }
+    bool operator==(const TextStyle& other) const {
+        return fg == other.fg && bg == other.bg && flags == other.flags;
+    }
+    bool operator!=(const TextStyle& other) const { return !(*this == other); }
+};
+
+// Style in effect from offset (in the visible text) until the next span
+struct StyleSpan {
+    size_t offset;
+    TextStyle style;
+};
+
+// Run of visible text in one style, as produced by one Feed() call
+struct StyleRun {
+    size_t length;
+    TextStyle style;
+};
+
+// Spans kept per command before those of spilled output are dropped
+constexpr size_t kMaxStyleSpans = 16384;
+
+// Drop spans starting in [from, to) and, if more than keep remain after that,
+// the oldest ones after from as well. The last dropped span survives at to, so
+// text from there on keeps its style. Output that spilled to disk is shown
+// unstyled where its spans were dropped.
+void DropStyleSpans(std::vector<StyleSpan>& spans, size_t from, size_t to, size_t keep);
+
+// Incremental parser for terminal output. Escape sequences are removed from
+// the text as it streams in; SGR (ESC [ ... m) updates the current style and
+// every other CSI, OSC or ESC sequence is dropped. A sequence split across
+// chunks is held back until the rest arrives, so chunk boundaries don't matter.
+class AnsiParser {
+public:
+    AnsiParser();
+
+    // Append the visible text of data to text and its styles to runs.
+    // Consecutive runs always differ in style.
+    void Feed(const char* data, size_t size, std::string& text, std::vector<StyleRun>& runs);
+
+    const TextStyle& CurrentStyle() const { return style_; }
+
+    // Forget the style and any half-read sequence
+    void Reset();
+
+private:
+    enum class State : uint8_t {
+        Text,
+        Escape,             // After ESC
+        EscapeIntermediate, // ESC ( B and friends: intermediates until a final byte
+        Csi,                // ESC [ parameters
+        Osc,                // ESC ] ... until BEL or ST
+        OscEscape           // ESC inside an OSC, probably the start of ST
+    };
+
+    State state_;
+    TextStyle style_;
+    std::string params_;    // Parameter and intermediate bytes of the CSI being read
+
+    void ApplySgr(const std::string& params);
+};
+
+} // namespace NeuroShell
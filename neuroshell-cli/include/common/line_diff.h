@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// One step of an edit script: keep, add or drop count lines
+enum class DiffOp : uint8_t {
+    Equal,
+    Insert,
+    Delete
+};
+
+struct DiffRun {
+    DiffOp op;
+    uint32_t count;
+};
+
+// How a command's output differs, line by line, from the previous run of the
+// same command. Kept and inserted lines are only referred to by position in
+// the new output; just the text of deleted lines is stored, so the previous
+// output can be rebuilt from the new one instead of keeping both.
+struct OutputDiff {
+    uint64_t baseBlockId = 0;       // Earlier run this diff is against; 0 = none
+    std::vector<DiffRun> runs;
+    std::string deleted;            // Deleted lines in order, newlines included
+    size_t insertedLines = 0;
+    size_t deletedLines = 0;
+
+    bool Empty() const { return baseBlockId == 0; }
+    bool Changed() const { return insertedLines + deletedLines > 0; }
+    size_t MemoryBytes() const { return runs.capacity() * sizeof(DiffRun) + deleted.capacity(); }
+
+    // The earlier output, given the output this diff belongs to
+    std::string Rebuild(std::string_view current) const;
+};
+
+// Myers' O(ND) difference algorithm over lines, after stripping the common
+// prefix and suffix, which for a polling command is usually nearly all of it.
+// Lines are compared by hash first and by text only when hashes match.
+class LineDiff {
+public:
+    // More edits than this and the outputs are too different to be worth a diff
+    static constexpr size_t kMaxEdits = 1000;
+
+    // Lines of text, each with its newline; an unterminated last line counts
+    static std::vector<std::string_view> SplitLines(std::string_view text);
+
+    // Shortest edit script turning before into after, as runs. Returns false
+    // if it takes more than maxEdits insertions and deletions.
+    static bool Compute(const std::vector<std::string_view>& before, const std::vector<std::string_view>& after,
+                        std::vector<DiffRun>& runs, size_t maxEdits = kMaxEdits);
+
+    // Fill diff (all but baseBlockId) with the changes from before to after
+    static bool Diff(std::string_view before, std::string_view after, OutputDiff& diff,
+                     size_t maxEdits = kMaxEdits);
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "common/output_buffer.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Where each line of a command's output starts, built as the output streams
+// in. Line starts are kept in groups of kGroupLines: the group stores its
+// first start, the rest are varint distances from one start to the next (one
+// byte for lines under 128 characters). A query binary-searches the groups and
+// decodes at most one group, so finding line n or the line at an offset is
+// O(log n).
+//
+// Exact starts cost about 1.25 bytes per line. For output that keeps flooding
+// in, Compact() thins out the part that spilled to disk to one group every
+// kSparseLines lines; queries landing there count the newlines in between
+// from the text itself.
+class LineIndex {
+public:
+    static constexpr size_t kGroupLines = 64;
+    static constexpr size_t kSparseLines = 64 * 1024;
+    static constexpr size_t kMemoryBudget = 16 * 1024 * 1024;
+
+    explicit LineIndex(size_t memoryBudget = kMemoryBudget);
+
+    // Record text appended at the end of the output
+    void Append(const char* data, size_t size);
+    void Clear();
+
+    // Bytes indexed so far
+    size_t Size() const { return size_; }
+
+    // Number of lines; a trailing newline doesn't start another one
+    size_t LineCount() const;
+
+    // Offset where line starts; LineCount() and beyond give Size()
+    size_t LineStart(size_t line, const OutputBuffer& text) const;
+
+    // Line that the byte at offset belongs to
+    size_t LineAt(size_t offset, const OutputBuffer& text) const;
+
+    // Once the index has outgrown its budget, forget the exact starts of
+    // lines wholly inside [from, to) except every kSparseLines-th one.
+    // Another pass waits until the index has doubled again.
+    void Compact(size_t from, size_t to);
+
+    size_t MemoryBytes() const;
+
+private:
+    struct Group {
+        size_t line;            // First line of the group
+        size_t offset;          // Where that line starts
+        size_t position;        // Its deltas in deltas_, or kNoDeltas once dropped
+    };
+
+    // A line start known exactly: the closest one at or before a query
+    struct Known {
+        size_t line;
+        size_t offset;
+        bool last;              // Also known that the next line starts past the query
+    };
+
+    static constexpr size_t kNoDeltas = static_cast<size_t>(-1);
+
+    std::vector<Group> groups_;
+    std::vector<uint8_t> deltas_;
+    size_t size_;
+    size_t lines_;              // Line starts recorded, the one at offset 0 included
+    size_t lastStart_;
+    size_t memoryBudget_;
+    size_t compactAt_;          // MemoryBytes() that triggers the next Compact() pass
+
+    void AddLineStart(size_t offset);
+
+    // Deltas stored for a group that still has them
+    size_t DeltaCount(const Group& group) const;
+
+    // Closest known start at or before line / at or before offset
+    Known NearestByLine(size_t line) const;
+    Known NearestByOffset(size_t offset) const;
+};
+
+} // namespace NeuroShell
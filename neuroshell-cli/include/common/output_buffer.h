@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdio>
+
+namespace NeuroShell {
+
+// Output of one command with a bounded memory footprint. The first headBytes
+// and the last tailBytes stay in memory; everything in between is spilled to
+// an anonymous temporary file as it scrolls out of the tail. Offsets are
+// logical: they count every byte the command produced, wherever it lives now.
+//
+// Copies share the spill file and are read-only snapshots; only the original
+// should keep appending.
+class OutputBuffer {
+public:
+    // Called with consecutive pieces of a range and the logical offset of each;
+    // return false to stop early
+    using ChunkFn = std::function<bool(const char* data, size_t size, size_t offset)>;
+
+    OutputBuffer();
+    OutputBuffer(const std::string& text);
+    OutputBuffer(const char* text);
+
+    OutputBuffer& operator=(const std::string& text);
+    OutputBuffer& operator=(const char* text);
+
+    void Append(const char* data, size_t size);
+    void Clear();
+
+    // Logical size, including the spilled middle
+    size_t Size() const { return head_.size() + spilledBytes_ + tail_.size(); }
+    bool Empty() const { return Size() == 0; }
+
+    // Bytes held in memory right now
+    size_t MemoryBytes() const { return head_.size() + tail_.size(); }
+
+    // In-memory ends; the middle [Head().size(), TailOffset()) lives on disk
+    const std::string& Head() const { return head_; }
+    const std::string& Tail() const { return tail_; }
+    size_t TailOffset() const { return head_.size() + spilledBytes_; }
+    size_t SpilledBytes() const { return spilledBytes_; }
+
+    // Part of the middle was dropped because the spill file couldn't be written
+    bool HasGap() const { return lostBytes_ > 0; }
+
+    // Visit [offset, offset + length) in pieces without loading it all at once
+    void ForEachChunk(size_t offset, size_t length, const ChunkFn& fn) const;
+
+    // Copy of a byte range; spilled bytes are read back from disk
+    std::string Read(size_t offset, size_t length) const;
+
+    // Whole output as one string. Only for callers that know it is small.
+    std::string Str() const { return Read(0, Size()); }
+
+    // First occurrence of needle at or after from, or std::string::npos
+    size_t Find(const std::string& needle, size_t from = 0) const;
+
+    // Budget for buffers created from now on (config output_head_kb / output_tail_kb)
+    static void SetDefaultLimits(size_t headBytes, size_t tailBytes);
+
+private:
+    class SpillFile;
+
+    std::string head_;
+    std::string tail_;
+    std::shared_ptr<SpillFile> spill_;
+    size_t spilledBytes_;               // Logical bytes between head and tail
+    size_t lostBytes_;                  // Of those, how many never reached the file
+    size_t headLimit_;
+    size_t tailLimit_;
+
+    // Move everything but the last tailLimit_ bytes of the tail to the spill file
+    void SpillTail();
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Work lanes; a worker always takes interactive work before background work
+enum class TaskPriority {
+    Interactive,    // Something the user is waiting on (commands, AI queries)
+    Background      // Speculative or periodic work that can wait
+};
+
+// Fixed-size pool shared by everything that used to start a detached thread.
+// Each worker owns a deque per lane; tasks submitted from a worker go to its
+// own deque, others are spread round-robin, and idle workers steal from the
+// back of their neighbours' deques. Shutdown() stops intake, runs what is
+// already queued and joins the workers.
+//
+// A command holds its worker for as long as it runs (spawn, drain, wait), so
+// a few long ones could take every worker and leave background work queued.
+// A quarter of the workers (at least one, when there are two or more) are
+// therefore reserved for the background lane and never take interactive
+// tasks: at most GetInteractiveLimit() commands run at once, and anything
+// past that waits in the interactive lane.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // Queue and timing figures for one lane
+    struct LaneMetrics {
+        size_t queueDepth;          // Tasks waiting right now
+        size_t maxQueueDepth;
+        uint64_t submitted;
+        uint64_t completed;
+        double avgWaitMs;           // Time from Submit() until a worker picked it up
+        double maxWaitMs;
+        double avgRunMs;
+
+        LaneMetrics()
+            : queueDepth(0), maxQueueDepth(0), submitted(0), completed(0)
+            , avgWaitMs(0.0), maxWaitMs(0.0), avgRunMs(0.0)
+        {}
+    };
+
+    // workerCount 0 picks a size from the hardware
+    explicit ThreadPool(size_t workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task. Returns false once Shutdown() has begun.
+    bool Submit(Task task, TaskPriority priority = TaskPriority::Interactive);
+
+    // Stop accepting tasks, finish the queued ones and join the workers
+    void Shutdown();
+
+    size_t GetWorkerCount() const { return workers_.size(); }
+    size_t GetInteractiveLimit() const { return workers_.size() - reserved_; }
+    LaneMetrics GetMetrics(TaskPriority priority) const;
+
+    // Pool used by the terminal, executors and AI clients
+    static ThreadPool& Shared();
+
+private:
+    static constexpr size_t kLaneCount = 2;
+
+    struct QueuedTask {
+        Task task;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<QueuedTask> lanes[kLaneCount];
+        std::thread thread;
+    };
+
+    struct LaneStats {
+        std::atomic<size_t> depth{0};
+        std::atomic<size_t> maxDepth{0};
+        std::atomic<uint64_t> submitted{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> totalWaitUs{0};
+        std::atomic<uint64_t> maxWaitUs{0};
+        std::atomic<uint64_t> totalRunUs{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t reserved_;               // The last reserved_ workers only take background tasks
+    LaneStats stats_[kLaneCount];
+    std::mutex sleepMutex_;         // Guards stopping_ transitions and idle waits
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_;   // Queued tasks across all workers
+    std::atomic<size_t> pendingBackground_;
+    std::atomic<size_t> nextWorker_;
+    std::atomic<bool> stopping_;
+    std::mutex joinMutex_;
+
+    void WorkerLoop(size_t index);
+
+    bool IsReserved(size_t index) const { return index >= workers_.size() - reserved_; }
+
+    // Own deque first, then steal; interactive lane before background.
+    // Reserved workers only look at the background lane.
+    bool TakeTask(size_t index, QueuedTask& task, size_t& lane);
+
+    void RunTask(QueuedTask& task, size_t lane);
+};
+
+} // namespace NeuroShell
@@ -1,10 +1,17 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <vector>
 #include <chrono>
 #include <memory>
+#include <algorithm>
 #include "imgui.h"
+#include "common/output_buffer.h"
+#include "common/ansi_parser.h"
+#include "common/utf8_sanitizer.h"
+#include "common/line_index.h"
+#include "common/line_diff.h"
 
 namespace NeuroShell {
 
@@ -16,23 +23,228 @@ enum class CommandStatus {
     Cancelled
 };
 
+// Which child stream produced a piece of output
+enum class OutputStream {
+    Stdout,
+    Stderr
+};
+
+// Run of output from one stream; segments tile CommandBlock::output in arrival order
+struct OutputSegment {
+    OutputStream stream;
+    size_t offset;
+    size_t length;
+};
+
+// Resources a command consumed, as reported by wait4()
+struct ResourceUsage {
+    double wallSeconds;
+    double userCpuSeconds;
+    double systemCpuSeconds;
+    long maxRssKb;                  // Peak resident set size
+    long blockReads;                // Block input operations
+    long blockWrites;               // Block output operations
+    long voluntarySwitches;         // Gave up the CPU to wait (I/O, sleep)
+    long involuntarySwitches;       // Preempted by the scheduler
+    
+    ResourceUsage()
+        : wallSeconds(0.0)
+        , userCpuSeconds(0.0)
+        , systemCpuSeconds(0.0)
+        , maxRssKb(0)
+        , blockReads(0)
+        , blockWrites(0)
+        , voluntarySwitches(0)
+        , involuntarySwitches(0)
+    {}
+    
+    double CpuSeconds() const { return userCpuSeconds + systemCpuSeconds; }
+};
+
+// Accumulated cost of every run of one command line
+struct CommandCost {
+    std::string command;
+    int runs;
+    double totalWallSeconds;
+    double totalCpuSeconds;
+    long peakRssKb;
+    
+    CommandCost()
+        : runs(0)
+        , totalWallSeconds(0.0)
+        , totalCpuSeconds(0.0)
+        , peakRssKb(0)
+    {}
+};
+
+// One stage of a pipeline the executor started itself, without /bin/sh
+struct PipelineStage {
+    std::string command;            // The stage as typed
+    int exitCode;                   // 128 + signal if it was killed
+    int termSignal;
+    std::string stderrHead;         // Start of what it wrote to stderr
+    
+    PipelineStage()
+        : exitCode(-1)
+        , termSignal(0)
+    {}
+};
+
 // Command block structure (like Warp's command blocks)
 struct CommandBlock {
+    uint64_t id;                    // Unique id, assigned by Terminal
     std::string input;              // User's input command
-    std::string output;             // Command output
+    OutputBuffer output;            // Command output (stdout and stderr interleaved), bounded in memory
+    std::vector<OutputSegment> segments; // Stream tag for each run of output
+    LineIndex lines;                // Where each line of output starts
+    std::vector<StyleSpan> styles;  // Where the color/bold style changes; empty for plain output
+    AnsiParser ansi[2];             // Escape sequence state per stream, across chunks
+    Utf8Sanitizer utf8[2];          // UTF-8 state per stream, across chunks
+    size_t binaryBytes;             // Stdout that looked binary: counted, not kept (0 for text)
     std::string workingDirectory;   // CWD when executed
     CommandStatus status;           // Execution status
     int exitCode;                   // Exit code
+    int termSignal;                 // Signal that killed the command (0 if it exited)
+    ResourceUsage usage;            // Wall/CPU time, memory and I/O of the command
     std::chrono::system_clock::time_point timestamp;
     bool isAIGenerated;            // Was this generated by AI?
     std::string aiPrompt;          // Original NLP prompt if AI-generated
+    bool fromCache;                // Output replayed from the result cache, nothing ran
+    bool speculated;               // Output of a speculative run started before it was asked for
+    bool nativeBuiltin;            // Answered in-process by a native builtin, no process started
+    bool watching;                 // Watch mode: rerun in place when files change
+    OutputDiff diff;               // Line changes since the previous run of the same command
+    uint64_t outputFoldedInto;     // Output dropped, rebuilt from this later run's output and diff (0 = kept)
+    unsigned watchReruns;          // Times watch mode has rerun it
+    std::vector<PipelineStage> pipeline; // Per-stage results (PIPESTATUS) of a pipeline run without the shell
+    int jobNumber;                 // Background job number (0 = foreground)
+    bool stopped;                  // Suspended by job control; status stays Running
+    bool flooding;                 // Output arriving too fast to show it all: only the tail is drawn
+    double outputBytesPerSecond;   // Capture rate measured while running
     
     CommandBlock() 
-        : status(CommandStatus::Running)
+        : id(0)
+        , binaryBytes(0)
+        , status(CommandStatus::Running)
         , exitCode(0)
-        , isAIGenerated(false)
+        , termSignal(0)
         , timestamp(std::chrono::system_clock::now())
+        , isAIGenerated(false)
+        , fromCache(false)
+        , speculated(false)
+        , nativeBuiltin(false)
+        , watching(false)
+        , outputFoldedInto(0)
+        , watchReruns(0)
+        , jobNumber(0)
+        , stopped(false)
+        , flooding(false)
+        , outputBytesPerSecond(0.0)
     {}
+    
+    // Drop all output and parser state, for a command that runs again in this block
+    void ClearOutput() {
+        output.Clear();
+        segments.clear();
+        lines.Clear();
+        styles.clear();
+        for (int index = 0; index < 2; ++index) {
+            ansi[index] = AnsiParser();
+            utf8[index] = Utf8Sanitizer();
+        }
+        binaryBytes = 0;
+        flooding = false;
+        outputBytesPerSecond = 0.0;
+        diff = OutputDiff();
+    }
+    
+    // Append a raw chunk. Invalid UTF-8 and stray control characters are
+    // cleaned up first; stdout that looks binary from its first bytes on is
+    // only counted, so the block can show a placeholder instead.
+    void AppendOutput(OutputStream stream, const char* data, size_t size) {
+        if (size == 0) return;
+        bool isStdout = stream == OutputStream::Stdout;
+        if (isStdout && binaryBytes > 0) {
+            binaryBytes += size;
+            return;
+        }
+        
+        Utf8Sanitizer& sanitizer = utf8[static_cast<int>(stream)];
+        static thread_local std::string clean;
+        clean.clear();
+        sanitizer.Feed(data, size, clean);
+        if (isStdout && sanitizer.LooksBinary()) {
+            binaryBytes = sanitizer.BytesSeen();
+            return;
+        }
+        AppendText(stream, clean.data(), clean.size());
+    }
+    
+    // The command's output ended: flush sequences cut off at the very end
+    void FinishOutput() {
+        std::string rest;
+        for (int index = 0; index < 2; ++index) {
+            rest.clear();
+            utf8[index].Finish(rest);
+            OutputStream stream = static_cast<OutputStream>(index);
+            if (!(stream == OutputStream::Stdout && binaryBytes > 0)) {
+                AppendText(stream, rest.data(), rest.size());
+            }
+        }
+    }
+    
+    // Append clean text, extending the last segment when the stream hasn't changed.
+    // Escape sequences are parsed here, once: output keeps only the visible
+    // text and styles records where SGR changed the style.
+    void AppendText(OutputStream stream, const char* data, size_t size) {
+        if (size == 0) return;
+        static thread_local std::string text;
+        static thread_local std::vector<StyleRun> runs;
+        text.clear();
+        runs.clear();
+        ansi[static_cast<int>(stream)].Feed(data, size, text, runs);
+        if (text.empty()) return;
+        
+        size_t offset = output.Size();
+        for (const auto& run : runs) {
+            if (run.style != (styles.empty() ? TextStyle() : styles.back().style)) {
+                styles.push_back({ offset, run.style });
+            }
+            offset += run.length;
+        }
+        if (styles.size() > kMaxStyleSpans && output.SpilledBytes() > 0) {
+            DropStyleSpans(styles, output.Head().size(), output.TailOffset(), kMaxStyleSpans / 2);
+        }
+        
+        if (!segments.empty() && segments.back().stream == stream) {
+            segments.back().length += text.size();
+        } else {
+            segments.push_back({ stream, output.Size(), text.size() });
+        }
+        output.Append(text.data(), text.size());
+        lines.Append(text.data(), text.size());
+        if (output.SpilledBytes() > 0) {
+            lines.Compact(output.Head().size(), output.TailOffset());
+        }
+    }
+    
+    // Text of lines [first, first + count), newlines included
+    std::string ReadLines(size_t first, size_t count) const {
+        size_t begin = lines.LineStart(first, output);
+        size_t end = lines.LineStart(first + std::min(count, lines.LineCount()), output);
+        return output.Read(begin, end - begin);
+    }
+    
+    // Text of a single stream with the other one filtered out
+    std::string StreamText(OutputStream stream) const {
+        std::string text;
+        for (const auto& segment : segments) {
+            if (segment.stream == stream) {
+                text += output.Read(segment.offset, segment.length);
+            }
+        }
+        return text;
+    }
 };
 
 // AI provider options
@@ -74,6 +286,7 @@ struct ThemeColors {
     ImVec4 accent;
     ImVec4 border;
     ImVec4 scrollbar;
+    ImVec4 ansi[16];                // Palette for colored command output: black..white, then bright
 };
 
 // Application state
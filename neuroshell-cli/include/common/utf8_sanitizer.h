@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Instruction set used to skip over runs of plain ASCII
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Capture-stage filter that turns raw command output into text that is safe
+// to hand to ImGui. Invalid UTF-8 becomes U+FFFD (one per maximal invalid
+// subpart, as Unicode recommends), control characters other than tab,
+// newline, carriage return, BEL and ESC are dropped; the last two are left for
+// AnsiParser. Plain ASCII, by far the common case, is skipped 16 or 32 bytes
+// at a time and valid input is copied in bulk. A sequence split across chunks
+// completes on the next Feed().
+//
+// The first kSniffBytes of the stream also decide whether it looks binary:
+// any NUL, or a large share of invalid bytes and stray control characters.
+class Utf8Sanitizer {
+public:
+    static constexpr size_t kSniffBytes = 8000;
+
+    explicit Utf8Sanitizer(SimdLevel level = BestLevel());
+
+    // Append the sanitized form of data to out
+    void Feed(const char* data, size_t size, std::string& out);
+
+    // The stream ended: a truncated trailing sequence becomes U+FFFD
+    void Finish(std::string& out);
+
+    bool LooksBinary() const;
+
+    size_t BytesSeen() const { return bytesSeen_; }
+    size_t InvalidCount() const { return invalid_; }    // Replacement characters emitted
+    size_t DroppedCount() const { return dropped_; }    // Control characters removed
+    SimdLevel Level() const { return level_; }
+
+    // Widest level this CPU supports (and this build was compiled for)
+    static SimdLevel BestLevel();
+    static const char* LevelName(SimdLevel level);
+
+private:
+    using ScanFunction = size_t (*)(const uint8_t* data, size_t size);
+
+    SimdLevel level_;
+    ScanFunction scan_;         // Length of the leading run of plain ASCII
+    uint8_t pending_[4];        // Start of a sequence cut off by the end of the last chunk
+    size_t pendingSize_;
+    size_t bytesSeen_;
+    size_t invalid_;
+    size_t dropped_;
+    size_t sniffNuls_;          // Within the first kSniffBytes
+    size_t sniffSuspect_;
+
+    // Count a suspicious byte at stream position toward the binary verdict
+    void NoteSuspect(size_t position, bool nul);
+};
+
+} // namespace NeuroShell
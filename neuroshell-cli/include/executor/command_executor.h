@@ -17,6 +17,7 @@ struct ExecutionResult {
     std::string output;         // Standard output
     std::string error;          // Standard error
     double execution_time;      // Execution time in seconds
+    bool timed_out = false;     // Stopped because it ran past its timeout
 };
 
 /**
@@ -68,9 +69,10 @@ private:
     /**
      * @brief Execute system command and capture output
      * @param command Full command string
+     * @param timeout_seconds Stop the command's process group after this long (0 = no limit)
      * @return ExecutionResult
      */
-    ExecutionResult executeSystemCommand(const std::string& command);
+    ExecutionResult executeSystemCommand(const std::string& command, int timeout_seconds = 0);
 
     /**
      * @brief Build full command string from MappedCommand
@@ -19,6 +19,7 @@ struct MappedCommand {
     bool is_dangerous;                // Whether command is potentially dangerous
     std::string description;          // Human-readable description
     float confidence;                 // Mapping confidence score
+    int timeout_seconds;              // Wall-clock limit, 0 for none
 };
 
 /**
@@ -58,6 +59,7 @@ private:
         bool requires_confirmation;
         bool is_dangerous;
         std::vector<std::string> required_params;
+        int timeout_seconds = 0;      // Stop the command after this long (0 = no limit)
     };
 
     // Map of action+target combinations to command templates
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <chrono>
+
+namespace NeuroShell {
+
+// Cancel request and deadline for one running command, shared between the
+// thread draining its output and whoever wants it stopped. Stopping escalates:
+// SIGINT first, SIGTERM after the interrupt grace period, SIGKILL after the
+// terminate grace period. Whoever drives the command calls Advance() from its
+// wait loop, which sends whatever signal is due.
+class CancelToken {
+public:
+    using SignalFn = std::function<void(int signal)>;
+
+    CancelToken();
+    ~CancelToken();
+
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+
+    // Request a stop; safe from any thread
+    void Cancel();
+
+    // Wall-clock limit counted from now; 0 or less means none
+    void SetTimeout(double seconds);
+    double GetTimeout() const { return timeoutSeconds_; }
+
+    // Grace periods between SIGINT -> SIGTERM -> SIGKILL
+    void SetStopSchedule(int interruptGraceMs, int terminateGraceMs);
+
+    // Cancel() was called or the deadline passed
+    bool IsCancelled() const;
+    bool TimedOut() const;
+
+    // Readable once Cancel() is called, so a poll loop can wake for it (-1 on Windows)
+    int GetWakeFd() const { return wakeFds_[0]; }
+
+    // Send any stop signal that is due through sendSignal. Returns milliseconds
+    // until the next step or deadline, or -1 if nothing is scheduled.
+    int Advance(const SignalFn& sendSignal);
+
+    // The command's process group, so others can signal it directly (job
+    // control). Detach() runs before the child is reaped, so Signal() can't
+    // reach a recycled pid.
+    void Attach(int processGroup);
+    void Detach();
+
+    // Send signal to the attached group now; false if there is none
+    bool Signal(int signal);
+
+private:
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::chrono::steady_clock::time_point nextStep_;
+    double timeoutSeconds_;
+    int interruptGraceMs_;
+    int terminateGraceMs_;
+    int stage_;                     // Signals sent so far: 0 none, 1 INT, 2 TERM, 3 KILL
+    int processGroup_;              // Attached group, 0 if none
+    bool hasDeadline_;
+    bool cancelled_;
+    bool timedOut_;
+    int wakeFds_[2];
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "common/types.h"
+#include "utils/safety.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace NeuroShell {
+
+// Output of a cached run, replayed into a fresh block on a hit
+struct CachedResult {
+    std::string output;
+    std::vector<OutputSegment> segments;
+    std::vector<StyleSpan> styles;
+    LineIndex lines;
+    size_t binaryBytes;
+    int exitCode;
+
+    CachedResult() : binaryBytes(0), exitCode(0) {}
+};
+
+// Remembers the output of read-only commands (see SafetyChecker::isCacheable)
+// keyed by normalized command line and working directory. Each entry carries
+// a fingerprint of what the command reads: the working directory's entries
+// and every path argument (mtime, size, type). A lookup recomputes it, so any
+// change there drops the entry instead of serving stale output. Least recently
+// used entries go first once the cache is full.
+class CommandCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t invalidations;     // Entries dropped because what they read changed
+        size_t entries;
+
+        Stats() : hits(0), misses(0), invalidations(0), entries(0) {}
+    };
+
+    // Identity and fingerprint of one run, taken before the command starts
+    struct Ticket {
+        std::string key;
+        uint64_t fingerprint;
+        bool cacheable;
+
+        Ticket() : fingerprint(0), cacheable(false) {}
+    };
+
+    CommandCache();
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    // Maximum number of entries (config cache_size)
+    void SetCapacity(size_t capacity);
+
+    // Take a ticket for command; not cacheable if disabled or the command
+    // isn't read-only or reads too much to fingerprint
+    Ticket Prepare(const std::string& command, const std::string& workingDir) const;
+
+    // Look ticket up; counts a hit, miss or invalidation
+    bool Lookup(const Ticket& ticket, CachedResult& result);
+
+    // Remember a finished run. Only clean exits whose output is fully in memory are kept.
+    void Store(const Ticket& ticket, const CommandBlock& block);
+
+    void Clear();
+    Stats GetStats() const;
+
+    // Entry key: working directory and the words of argv, joined by NUL
+    static std::string Key(const std::vector<std::string>& argv, const std::string& workingDir);
+
+    // Hash of the metadata of everything argv reads; false if too much to check
+    static bool Fingerprint(const std::vector<std::string>& argv, const std::string& workingDir,
+                            uint64_t& fingerprint);
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t fingerprint;
+        std::chrono::steady_clock::time_point storedAt;
+        CachedResult result;
+    };
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;                      // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+    bool enabled_;
+    Stats stats_;
+    neuroshell::utils::SafetyChecker safety_;
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "common/types.h"
+#include "terminal/process_priority.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace NeuroShell {
+
+// Limits for one command; zero means unlimited
+struct ResourceLimits {
+    int cpuWeight;                  // cgroup cpu.weight, 1-10000 (100 = an even share)
+    uint64_t memoryMaxBytes;        // cgroup memory.max
+    int pidsMax;                    // cgroup pids.max
+    ProcessPriority priority;       // Nice, I/O class and SCHED_IDLE; applied in the child, cgroup or not
+
+    ResourceLimits()
+        : cpuWeight(0)
+        , memoryMaxBytes(0)
+        , pidsMax(0)
+    {}
+
+    // Something only a cgroup (or setrlimit()) can enforce; priority alone doesn't need one
+    bool Any() const { return cpuWeight > 0 || memoryMaxBytes > 0 || pidsMax > 0; }
+};
+
+// Nice value closest to a cpu.weight when cgroups aren't available: each nice
+// step is worth about 1.25x CPU, so weight 100 is nice 0. Only ever lowers
+// priority (0-19), since raising it needs privileges.
+int NiceForWeight(int cpuWeight);
+
+// A cgroup v2 leaf holding one command and everything it starts. Needs a
+// delegated hierarchy: the first Create() moves NeuroShell itself into a
+// "ui" leaf so its own cgroup can have children, then enables the cpu,
+// memory and pids controllers for them. Linux only; elsewhere, or when the
+// hierarchy isn't writable, Create() returns null and the caller falls back
+// to setrlimit() and nice in the child.
+class CommandCgroup {
+public:
+    ~CommandCgroup();
+
+    CommandCgroup(const CommandCgroup&) = delete;
+    CommandCgroup& operator=(const CommandCgroup&) = delete;
+
+    // New leaf with limits applied, or null if cgroups can't be used
+    static std::unique_ptr<CommandCgroup> Create(const ResourceLimits& limits);
+
+    // Whether Create() can succeed (checked once, then cached)
+    static bool IsAvailable();
+
+    // cgroup.procs, open for writing; a child writes "0" to it to join before exec
+    int ProcsFd() const { return procsFd_; }
+
+    // CPU time from cpu.stat and peak memory from memory.peak, over everything
+    // that ever ran in the leaf (grandchildren included)
+    void ReadUsage(ResourceUsage& usage) const;
+
+private:
+    CommandCgroup(const std::string& path, int procsFd);
+
+    std::string path_;
+    int procsFd_;
+};
+
+} // namespace NeuroShell
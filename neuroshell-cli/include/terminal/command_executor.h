@@ -1,34 +1,89 @@
 #pragma once
 
 #include "common/types.h"
+#include "terminal/process.h"
+#include "terminal/cancel_token.h"
+#include "terminal/working_directory.h"
 #include <string>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <map>
+#include <cstddef>
 
 namespace NeuroShell {
 
 class CommandExecutor {
 public:
+    // Receives output chunks, tagged by stream, as soon as the child writes them
+    using OutputCallback = std::function<void(OutputStream stream, const char* data, size_t size)>;
+    
     CommandExecutor();
     ~CommandExecutor();
     
-    // Execute a shell command and capture output
-    CommandBlock Execute(const std::string& command, const std::string& workingDir = "");
+    // Execute a shell command and capture output. Commands run in workingDir,
+    // or in this executor's directory if it is empty.
+    CommandBlock Execute(const std::string& command, const WorkingDirectory& workingDir = WorkingDirectory());
+    
+    // Execute a shell command, handing each output chunk to onOutput as it arrives.
+    // The returned block carries the final status, exit code and resource usage;
+    // its output stays empty because the subscriber already received every byte.
+    // Cancelling the token (or reaching its deadline) stops the command's process
+    // group and the block comes back Cancelled. Without a timeout of its own the
+    // token gets the one configured for the command's program. With limits the
+    // command runs in its own cgroup (or under setrlimit() where cgroups aren't
+    // delegated) and its usage covers everything it started.
+    CommandBlock ExecuteStreaming(const std::string& command,
+                                  const OutputCallback& onOutput,
+                                  const WorkingDirectory& workingDir = WorkingDirectory(),
+                                  std::shared_ptr<CancelToken> cancel = nullptr,
+                                  const ResourceLimits& limits = ResourceLimits());
+    
+    // Like ExecuteStreaming, but returns once the command has started. The shared
+    // ProcessReactor then delivers its output and calls onComplete with the
+    // finished block, both on the reactor thread, so no thread waits on the
+    // child. Built-ins, and platforms without a reactor, complete before this
+    // returns.
+    using CompletionCallback = std::function<void(const CommandBlock&)>;
+    void ExecuteReactive(const std::string& command,
+                         const OutputCallback& onOutput,
+                         const CompletionCallback& onComplete,
+                         const WorkingDirectory& workingDir = WorkingDirectory(),
+                         std::shared_ptr<CancelToken> cancel = nullptr,
+                         const ResourceLimits& limits = ResourceLimits());
     
     // Execute command asynchronously with callback
     void ExecuteAsync(const std::string& command, 
                      std::function<void(const CommandBlock&)> callback,
-                     const std::string& workingDir = "");
+                     const WorkingDirectory& workingDir = WorkingDirectory());
     
-    // Cancel running command
+    // Cancel every command this executor is running
     void Cancel();
     
+    // Grace periods between SIGINT, SIGTERM and SIGKILL when stopping a command
+    void SetStopSchedule(int interruptGraceMs, int terminateGraceMs);
+    
+    // Wall-clock limits in seconds (0 = none): a default, and overrides by program name
+    void SetDefaultTimeout(double seconds);
+    void SetCommandTimeout(const std::string& program, double seconds);
+    double GetTimeoutFor(const std::string& command) const;
+    
+    // Give token the stop schedule, and command's timeout unless it has one
+    void ApplyLimits(CancelToken& token, const std::string& command) const;
+    
     // Check if command is currently running
     bool IsRunning() const;
     
     // Get current working directory
     std::string GetWorkingDirectory() const;
     
-    // Change working directory
+    // The same as a handle that stays valid after a later cd; pass it to commands
+    WorkingDirectory GetWorkingDirectoryHandle() const;
+    
+    // Change working directory (relative paths start from the current one).
+    // Only this executor is affected; the process's own directory never changes.
     bool SetWorkingDirectory(const std::string& path);
     
     // Built-in commands (cd, clear, etc.)
@@ -36,19 +91,38 @@ public:
     CommandBlock ExecuteBuiltIn(const std::string& command);
     
 private:
-    std::string currentWorkingDir_;
-    bool isRunning_;
+    WorkingDirectory currentWorkingDir_;
+    mutable std::mutex workingDirMutex_;    // cd on the UI thread vs. commands reading it
+    std::atomic<int> runningCommands_;
     
-    // Platform-specific implementation
-#ifdef _WIN32
-    void* processHandle_;
-#else
-    int processId_;
-#endif
+    // Tokens of commands in flight, so Cancel() can reach them
+    std::set<std::shared_ptr<CancelToken>> activeTokens_;
+    mutable std::mutex settingsMutex_;      // Guards activeTokens_ and the settings below
+    int interruptGraceMs_;
+    int terminateGraceMs_;
+    double defaultTimeout_;
+    std::map<std::string, double> commandTimeouts_;
     
     // Helper methods
-    std::string CaptureOutput(const std::string& command);
+    ProcessExit CaptureOutput(const std::string& command, const WorkingDirectory& workingDir,
+                              const OutputCallback& onOutput, CancelToken* cancel,
+                              const ResourceLimits& limits);
     bool ExecuteCD(const std::string& path);
+    
+    // Shared by the blocking and reactor paths. BeginCommand handles built-ins,
+    // native builtins (see BuiltinRegistry) and commands cancelled while queued
+    // (returning false with block complete);
+    // otherwise it registers the token and the command counts as running until
+    // FinishCommand or FailCommand.
+    bool BeginCommand(const std::string& command, const OutputCallback& onOutput,
+                      const WorkingDirectory& runDir,
+                      std::shared_ptr<CancelToken>& cancel, CommandBlock& block);
+    void FinishCommand(CommandBlock& block, const ProcessExit& exit, const OutputCallback& onOutput,
+                       const std::shared_ptr<CancelToken>& cancel);
+    void FailCommand(CommandBlock& block, const std::string& error, const OutputCallback& onOutput,
+                     const std::shared_ptr<CancelToken>& cancel);
+    void EndCommand(CommandBlock& block, const OutputCallback& onOutput,
+                    const std::shared_ptr<CancelToken>& cancel);
     void InitializeWorkingDirectory();
 };
 
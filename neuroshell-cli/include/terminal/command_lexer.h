@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace NeuroShell {
+
+// Recognizes command lines simple enough to run without a shell: plain words,
+// quoting and backslash escapes only. Anything the shell would expand or
+// interpret (pipes, redirects, globs, variables, command substitution,
+// compound operators, assignments, keywords, state-changing builtins) is
+// rejected so the caller falls back to /bin/sh -c.
+class CommandLexer {
+public:
+    // Split command into argv with quotes and escapes removed. Returns false
+    // if running it without a shell could behave differently.
+    static bool SplitSimple(const std::string& command, std::vector<std::string>& argv);
+
+    // Split a pipeline of two or more simple commands ("ps aux | grep x")
+    // into its stages, each as written. Returns false for anything else,
+    // including ||, |& and a stage SplitSimple() rejects.
+    static bool SplitPipeline(const std::string& command, std::vector<std::string>& stages);
+
+    // Is word a keyword or builtin that must run inside a shell
+    static bool IsShellWord(const std::string& word);
+};
+
+// Caches PATH lookups for programs run without a shell. The table is dropped
+// whenever PATH changes, and a cached hit is re-checked before use so a
+// removed binary falls back to a fresh search.
+class PathCache {
+public:
+    // Absolute path of an executable for program, or empty if none was found.
+    // Programs containing a slash are returned unchanged.
+    std::string Resolve(const std::string& program);
+
+    void Clear();
+
+    // Process-wide cache shared by all executors
+    static PathCache& Instance();
+
+private:
+    std::mutex mutex_;
+    std::string pathVar_;           // PATH the table was built against
+    std::unordered_map<std::string, std::string> entries_;   // Empty value = not found
+};
+
+} // namespace NeuroShell
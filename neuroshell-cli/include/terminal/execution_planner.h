@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// One command of a multi-command AI answer and what it must wait for
+struct PlannedCommand {
+    std::string command;
+    std::vector<size_t> dependsOn;      // Indices of earlier commands that must finish first
+    bool barrier;                       // Changes shell state (cwd, env) or has unknown effects
+    bool readOnly;                      // Only inspects the filesystem
+    std::vector<std::string> reads;     // Paths it reads ("." for the working directory)
+    std::vector<std::string> writes;    // Paths it creates, modifies or removes
+
+    PlannedCommand()
+        : barrier(false)
+        , readOnly(false)
+    {}
+};
+
+// Turns a list of commands into a dependency graph. Commands that change the
+// working directory or environment, or whose effects can't be worked out,
+// are ordered against everything; writers are ordered against earlier and
+// later commands touching overlapping paths; read-only commands that touch
+// nothing in common are left free to run concurrently. The analysis is
+// heuristic and errs towards ordering.
+class ExecutionPlanner {
+public:
+    // Returns one entry per command, in the same order
+    static std::vector<PlannedCommand> Plan(const std::vector<std::string>& commands);
+
+    // Classify a single command; dependsOn is left empty
+    static PlannedCommand Analyze(const std::string& command);
+
+    // Could two paths name the same file or one contain the other
+    static bool PathsOverlap(const std::string& left, const std::string& right);
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Calls back when files change under a set of paths, with one inotify
+// descriptor and one thread for every watch. A burst of changes makes one
+// call: it comes once they have been quiet for debounceMs (or kMaxDelayMs
+// after the first, for a directory that never settles), and never sooner than
+// minIntervalMs after the previous one. A call suspends its watch until
+// Resume(), and changes made in the meantime, including those already queued
+// when Resume() is called, are dropped, so a rerun's own writes can't trigger
+// the next one. Linux only; elsewhere Add() fails.
+class FileWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    static constexpr int kMaxDelayMs = 2000;
+    static constexpr size_t kMaxDirectories = 512;      // Per watch
+
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    static bool IsSupported();
+
+    // Watch each path: a file, or a directory with the directories below it
+    // that aren't hidden. Directories created later are not picked up.
+    // onChange runs on the watcher thread and must not block. Returns an id
+    // for Resume() and Remove(), or 0 if none of the paths could be watched.
+    uint64_t Add(const std::vector<std::string>& paths, Callback onChange, int debounceMs, int minIntervalMs);
+
+    // Let a watch call again, for changes from now on
+    void Resume(uint64_t id);
+
+    // Stop a watch. Once this returns, its callback has finished and won't
+    // run again (unless this is called from the callback itself).
+    void Remove(uint64_t id);
+
+    size_t WatchCount() const;
+
+    // Drop every watch and join the thread
+    void Shutdown();
+
+    // Watcher used by the terminal's watch mode
+    static FileWatcher& Shared();
+
+private:
+    struct Watch;
+
+    mutable std::mutex mutex_;
+    std::condition_variable callbackDone_;
+    std::unordered_map<uint64_t, std::unique_ptr<Watch>> watches_;
+    std::unordered_map<int, std::vector<uint64_t>> owners_;    // inotify watch descriptor -> watches
+    std::thread thread_;
+    std::thread::id threadId_;
+    uint64_t nextId_;
+    uint64_t calling_;              // Watch whose callback is running, or 0
+    bool stopping_;
+    int inotifyFd_;
+    int wakeFd_;                    // eventfd: resumes and shutdown
+
+    void Loop();
+
+    // Read every queued event and mark the watches it concerns
+    void DrainEvents();
+
+    // Watch one directory or file for id; false if it can't be watched
+    bool AddDescriptor(const std::string& path, uint64_t id, std::vector<int>& descriptors);
+
+    // Drop id from the descriptors it used, removing those nobody else uses (caller holds the lock)
+    void ReleaseDescriptors(Watch& watch, uint64_t id);
+
+    void Wake();
+};
+
+} // namespace NeuroShell
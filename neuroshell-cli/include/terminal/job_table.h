@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace NeuroShell {
+
+enum class JobState {
+    Running,
+    Stopped,
+    Done
+};
+
+// A command running in the background, known by its job number
+struct Job {
+    int number;
+    uint64_t blockId;
+    std::string command;            // As typed, without the trailing &
+    JobState state;
+    int exitCode;                   // Once Done
+};
+
+// The terminal's background jobs, numbered from 1 like a shell's. The current
+// job (%+) is the one started, stopped or resumed last, and the previous one
+// (%-) the one before it. Finished jobs stay listed until Reap() reports them.
+// Not thread-safe; Terminal guards it with the history lock.
+class JobTable {
+public:
+    // Add a job for blockId and make it current; returns its number, one past
+    // the highest in use
+    int Add(uint64_t blockId, const std::string& command, JobState state = JobState::Running);
+
+    void Remove(int number);
+    void Clear() { jobs_.clear(); }
+
+    Job* Find(int number);
+    Job* FindByBlock(uint64_t blockId);
+
+    // A job spec: %n or n, %% / %+ / empty (current), %- (previous), %text
+    // (command starts with text) or %?text (command contains text). Null if
+    // nothing, or more than one job, matches.
+    Job* Resolve(const std::string& spec);
+
+    // Set a job's state; stopping or resuming one makes it current
+    void SetState(int number, JobState state);
+    void Finish(uint64_t blockId, int exitCode);
+
+    // Jobs in number order
+    const std::vector<Job>& Jobs() const { return jobs_; }
+    bool Empty() const { return jobs_.empty(); }
+
+    // '+' for the current job, '-' for the previous one, ' ' for the rest
+    char Marker(int number) const;
+
+    // bash-style listing, one line per job ("[1]+ Running  make &"); finished
+    // jobs are listed once and then dropped
+    std::string Reap();
+
+    // If command ends in a lone, unquoted & (not &&, not an escaped or
+    // redirected one), store it without that & in stripped and return true
+    static bool SplitBackground(const std::string& command, std::string& stripped);
+
+    // kill's signal argument: a number, or a name with or without SIG
+    // (TERM, SIGSTOP, ...); -1 if unknown
+    static int SignalNumber(const std::string& name);
+
+private:
+    std::vector<Job> jobs_;
+    std::vector<int> recent_;       // Job numbers, most recently made current last
+
+    void MakeCurrent(int number);
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common/types.h"
+#include "terminal/working_directory.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+
+namespace NeuroShell {
+
+// What a native builtin gets to work with: the command's words with quotes
+// removed, its working directory, and the same output callback a process's
+// output would go to
+struct BuiltinCall {
+    using OutputCallback = std::function<void(OutputStream stream, const char* data, size_t size)>;
+
+    const std::vector<std::string>& argv;
+    const WorkingDirectory& workingDir;
+    const OutputCallback& onOutput;
+
+    void Write(OutputStream stream, const std::string& text) const {
+        if (onOutput && !text.empty()) onOutput(stream, text.data(), text.size());
+    }
+};
+
+// Programs answered in-process instead of by starting a process: echo, true,
+// false, whoami, hostname, date, which, env and printenv. Each one behaves
+// like the program it stands in for would when run without a shell, and
+// declines (before writing anything) when given options or a setting it
+// doesn't reproduce exactly, so the real program runs instead. Only command
+// lines simple enough to run without a shell are considered.
+class BuiltinRegistry {
+public:
+    // Returns the exit code, or kDeclined to have the command run as a process
+    using Handler = std::function<int(const BuiltinCall& call)>;
+    static constexpr int kDeclined = -1;
+
+    BuiltinRegistry();
+
+    // Add or replace the builtin for program name
+    void Register(const std::string& name, Handler handler);
+    bool IsBuiltin(const std::string& name) const;
+
+    // Run command in-process if a builtin takes it. Returns false, having
+    // written nothing, if it has to run as a process after all.
+    bool Run(const std::string& command, const WorkingDirectory& workingDir,
+             const BuiltinCall::OutputCallback& onOutput, int& exitCode) const;
+
+    // Process-wide registry with the standard builtins
+    static BuiltinRegistry& Shared();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Handler> handlers_;
+
+    void RegisterStandard();
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common/types.h"
+#include "terminal/process.h"
+#include "terminal/cancel_token.h"
+#include <functional>
+#include <cstddef>
+
+namespace NeuroShell {
+
+class OutputCapture {
+public:
+    // Receives each chunk tagged with the stream it was read from
+    using ChunkCallback = std::function<void(OutputStream stream, const char* data, size_t size)>;
+
+#ifndef _WIN32
+    // Drain a child's stdout and stderr (and a pipeline's other stderr pipes,
+    // see KeepStageStderr) through one poll loop until all reach EOF, then
+    // close them. Each ready stream gets at most one read per round,
+    // so a flood on one stream can't starve the other, and neither pipe can
+    // fill up and block the child while we wait on its sibling.
+    // With a cancel token, a cancel request or passed deadline starts the
+    // stop sequence on the child's process group while draining continues.
+    static void Drain(ChildProcess& child, const ChunkCallback& onChunk, CancelToken* cancel = nullptr);
+#endif
+};
+
+} // namespace NeuroShell
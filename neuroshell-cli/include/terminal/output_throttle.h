@@ -0,0 +1,91 @@
+#pragma once
+
+#include "common/types.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// Sits between a running command's capture and its block. Chunks are queued
+// here as fast as they are read, without taking the history lock, and handed
+// over in batches: one per frame, each sized so appending it holds the lock
+// for at most kPublishBudget. A backlog is caught up a batch at a time with
+// short gaps for the UI. The incoming byte rate is measured over short
+// windows; above the flood rate the block switches to showing only its tail
+// while capture carries on. Thread-safe.
+class OutputThrottle {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // One frame at 60 Hz: the least time between two batches
+    static constexpr std::chrono::milliseconds kFrameInterval{ 16 };
+    // Least time between batches while catching up a backlog
+    static constexpr std::chrono::milliseconds kCatchUpGap{ 2 };
+    // How long appending one batch should hold the history lock
+    static constexpr std::chrono::milliseconds kPublishBudget{ 4 };
+    // How often the byte rate is measured
+    static constexpr std::chrono::milliseconds kRateWindow{ 250 };
+    // Above this the block shows its tail only; it leaves that mode below half of it
+    static constexpr double kFloodBytesPerSecond = 4.0 * 1024 * 1024;
+    // Batch size bounds, whatever the measured append rate
+    static constexpr size_t kMinBatchBytes = 256 * 1024;
+    static constexpr size_t kMaxBatchBytes = 16 * 1024 * 1024;
+    // Queued this much, a batch can't wait for the lock to come free
+    static constexpr size_t kMaxQueuedBytes = 32 * 1024 * 1024;
+
+    // Output of one stream; queued chunks from the same stream are merged up to kChunkBytes
+    struct Chunk {
+        OutputStream stream;
+        std::string data;
+    };
+    static constexpr size_t kChunkBytes = 256 * 1024;
+
+    explicit OutputThrottle(double floodBytesPerSecond = kFloodBytesPerSecond);
+
+    // Queue a chunk. Returns true if a batch is due: a frame has passed since
+    // the last one, a full batch is waiting and the catch-up gap has passed,
+    // or Full().
+    bool Add(OutputStream stream, const char* data, size_t size, Clock::time_point now = Clock::now());
+
+    // Nothing has arrived for a frame, yet output is queued or the flood
+    // state is still on: no Add() will come to hand over the one or end the
+    // other, so the caller should Take()
+    bool Stranded(Clock::time_point now = Clock::now()) const;
+
+    bool Empty() const;
+    bool Full() const;
+
+    // The next batch, in arrival order: whole chunks up to BatchBytes()
+    std::vector<Chunk> Take(Clock::time_point now = Clock::now());
+
+    // A taken batch of bytes took elapsed to append; sizes the next ones
+    void Published(size_t bytes, Clock::duration elapsed, Clock::time_point now = Clock::now());
+
+    size_t BatchBytes() const;
+
+    // Bytes per second over the last full window, and whether that is a flood
+    double BytesPerSecond() const;
+    bool Flooding() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<Chunk> queued_;
+    size_t queuedBytes_;
+    size_t batchBytes_;
+    double floodBytesPerSecond_;
+    Clock::time_point lastPublish_;
+    Clock::time_point lastChunk_;
+    Clock::time_point windowStart_;
+    size_t windowBytes_;
+    double bytesPerSecond_;
+    bool flooding_;
+
+    // Close the rate window if it has run its length (caller holds mutex_)
+    void UpdateRate(Clock::time_point now);
+};
+
+} // namespace NeuroShell
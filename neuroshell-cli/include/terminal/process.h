@@ -0,0 +1,119 @@
+#pragma once
+
+#include "common/types.h"
+#include "terminal/cancel_token.h"
+#include "terminal/working_directory.h"
+#include "terminal/command_cgroup.h"
+#include <string>
+#include <vector>
+#include <chrono>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace NeuroShell {
+
+// How a child finished and what it consumed
+struct ProcessExit {
+    int exitCode;                   // 128 + signal if the child was killed
+    int termSignal;                 // 0 if the child exited normally
+    ResourceUsage usage;
+    std::vector<PipelineStage> stages;  // Each stage of a pipeline; empty for one process
+    
+    ProcessExit()
+        : exitCode(-1)
+        , termSignal(0)
+    {}
+};
+
+#ifndef _WIN32
+
+// How to launch a child process
+struct SpawnOptions {
+    std::vector<std::string> argv;  // Program and arguments; argv[0] is looked up in PATH
+    std::string workingDir;         // Directory the child starts in (empty = inherit)
+    int workingDirFd = -1;          // Same as an open descriptor; wins over workingDir
+    int cgroupProcsFd = -1;         // Child joins this cgroup (CommandCgroup::ProcsFd) before exec
+    ResourceLimits limits;          // Without a cgroup: applied with setrlimit() and nice instead
+};
+
+// A spawned child and the read ends of its output pipes
+struct ChildProcess {
+    int pid;
+    int stdoutFd;                   // Non-blocking, close-on-exec
+    int stderrFd;                   // Non-blocking, close-on-exec
+    std::chrono::steady_clock::time_point startTime;
+    bool viaZygote;                 // Spawned by the zygote helper, which also reaps it
+    
+    // Pipelines only (see SpawnPipeline). pid is the first stage, which leads
+    // the process group; stdoutFd and stderrFd belong to the last stage, and
+    // the others' stderr arrives on stageStderrFds (stage i on entry i).
+    std::vector<int> stagePids;
+    std::vector<int> stageStderrFds;
+    std::vector<PipelineStage> stages;  // Stderr heads kept by the reader, see KeepStageStderr()
+
+    ChildProcess()
+        : pid(-1)
+        , stdoutFd(-1)
+        , stderrFd(-1)
+        , viaZygote(false)
+    {}
+};
+
+// How much of each pipeline stage's stderr is kept apart
+constexpr size_t kStageStderrBytes = 4096;
+
+// argv that runs a command line through /bin/sh
+std::vector<std::string> ShellArgv(const std::string& command);
+
+// Spawn a child with stdin on /dev/null and separate stdout/stderr pipes. The
+// child leads a new process group, so signals reach everything it starts.
+// With a cgroup or limits the child is forked so it can apply them before
+// exec; otherwise posix_spawn is used. A lowered priority alone doesn't fork
+// the UI process: on Linux the spawn comes from a short-lived thread that took
+// on the priority first, and the child inherits it (elsewhere it forks).
+// Throws std::runtime_error if the pipes or the process can't be created.
+ChildProcess SpawnProcess(const SpawnOptions& options);
+
+// Spawn each stage of a pipeline directly, stdout of one feeding stdin of
+// the next through a pipe that never passes through us, all in one process
+// group. Stages must be simple commands (see CommandLexer::SplitPipeline).
+// Throws std::runtime_error, leaving nothing running, if any stage fails
+// to start.
+ChildProcess SpawnPipeline(const std::vector<std::string>& stages, const SpawnOptions& options);
+
+// Spawn a command line. Simple commands and pipelines of them (see
+// CommandLexer) are resolved through PathCache and started directly;
+// everything else, or a direct start that fails, goes through /bin/sh.
+// Uses the spawn helper when it is running and no limits apply; a lowered
+// priority is applied by the helper. The child starts in workingDir (an
+// empty one inherits ours), inside cgroup if given, else under limits via
+// setrlimit().
+ChildProcess SpawnCommand(const std::string& command, const WorkingDirectory& workingDir,
+                          const ResourceLimits& limits = ResourceLimits(),
+                          const CommandCgroup* cgroup = nullptr);
+
+// Keep the start of pipeline stage's stderr in child.stages, up to kStageStderrBytes.
+// The readers (OutputCapture, ProcessReactor) call it for every stderr chunk.
+void KeepStageStderr(ChildProcess& child, size_t stage, const char* data, size_t size);
+
+// Has the child (every stage of a pipeline) exited; doesn't reap it
+bool HasExited(const ChildProcess& child);
+
+// Reap the child with wait4(), collecting its exit status and resource usage.
+// A pipeline finishes once every stage has exited; it reports the last
+// stage's status, like a shell, with every stage's in stages.
+// With a cancel token the stop sequence keeps advancing while we wait, and
+// the token is detached from the child before it is reaped.
+ProcessExit WaitForExit(const ChildProcess& child, CancelToken* cancel = nullptr);
+
+// Send a signal to the child's whole process group
+void SignalProcessGroup(const ChildProcess& child, int signal);
+
+// Translate a wait status and rusage into a ProcessExit
+ProcessExit MakeProcessExit(int waitStatus, const struct rusage& usage, double wallSeconds);
+
+#endif
+
+} // namespace NeuroShell
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+namespace NeuroShell {
+
+// Who started a command; each origin runs at its own priority class
+enum class CommandOrigin {
+    Interactive,    // Typed by the user, who is waiting on it
+    AIBatch,        // One of the commands of a multi-command AI answer
+    Background,     // Background jobs (&) and watch-mode reruns
+    Speculative     // Started before anyone asked for it (SpeculativeRunner)
+};
+
+// CPU and I/O priority a child starts with. It can only be lowered, since
+// raising either needs privileges.
+struct ProcessPriority {
+    int nice;                       // 0-19
+    int ioClass;                    // ioprio class: 0 leave as is, 2 best-effort, 3 idle
+    int ioLevel;                    // 0 (first served) - 7 (last), within best-effort
+    bool idleScheduling;            // SCHED_IDLE: gets the CPU only when nothing else wants it
+
+    ProcessPriority()
+        : nice(0)
+        , ioClass(0)
+        , ioLevel(4)
+        , idleScheduling(false)
+    {}
+
+    bool Any() const { return nice > 0 || ioClass != 0 || idleScheduling; }
+
+    // Parse "nice:10 io:best-effort:7 sched:idle" (any part may be left out,
+    // io:idle takes no level). Returns false, leaving priority alone, on
+    // anything else.
+    static bool Parse(const std::string& text, ProcessPriority& priority);
+};
+
+// The priority of each origin. Interactive commands are left alone by
+// default and the others step down from there; see neuroshell.conf.
+class PriorityClasses {
+public:
+    PriorityClasses();
+
+    const ProcessPriority& For(CommandOrigin origin) const;
+    void Set(CommandOrigin origin, const ProcessPriority& priority);
+
+    // Origin as named in config keys: interactive, ai, background, speculative
+    static bool FromName(const std::string& name, CommandOrigin& origin);
+
+private:
+    ProcessPriority classes_[4];
+};
+
+#ifndef _WIN32
+// Lower the caller to priority: the calling thread on Linux, where all three
+// are per thread, the whole process elsewhere. Only async-signal-safe calls,
+// so a child can use it between fork and exec. Failures are ignored: the
+// command still runs, at the priority it already had. I/O classes and
+// SCHED_IDLE are Linux only.
+void ApplyPriority(const ProcessPriority& priority);
+#endif
+
+} // namespace NeuroShell
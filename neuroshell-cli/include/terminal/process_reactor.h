@@ -0,0 +1,103 @@
+#pragma once
+
+#include "terminal/process.h"
+#include "terminal/output_capture.h"
+#include "terminal/cancel_token.h"
+#include <functional>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// One thread that owns the output pipes and exit notifications of every child
+// handed to it, instead of a worker blocked in Drain() per command. Pipes are
+// read through edge-triggered epoll, a bounded number of chunks per stream per
+// turn so one flood can't starve the rest, and exits arrive as pidfd
+// readiness. Cancel tokens are advanced from the same loop. Linux only; on
+// other platforms Watch() refuses and callers drain on their own thread.
+class ProcessReactor {
+public:
+    using ChunkCallback = OutputCapture::ChunkCallback;
+    using ExitCallback = std::function<void(const ProcessExit& exit)>;
+
+    ProcessReactor();
+    ~ProcessReactor();
+
+    ProcessReactor(const ProcessReactor&) = delete;
+    ProcessReactor& operator=(const ProcessReactor&) = delete;
+
+    static bool IsSupported();
+
+#ifndef _WIN32
+    // Take over child: output goes to onChunk as it arrives, and once every
+    // pipe reaches EOF and the child (each stage of a pipeline) is reaped,
+    // onExit gets its status. Both
+    // run on the reactor thread and must not block. The reactor thread starts
+    // on first use. Returns false, leaving the child to the caller, if the
+    // reactor is unsupported or shutting down.
+    bool Watch(const ChildProcess& child, ChunkCallback onChunk, ExitCallback onExit,
+               std::shared_ptr<CancelToken> cancel = nullptr);
+#endif
+
+    // Children watched and not yet finished
+    size_t ActiveCount() const { return active_.load(); }
+
+    // Refuse new children, stop the watched ones and join the thread. Each is
+    // cancelled, killed if still there after kShutdownKillMs, and given up on
+    // after kShutdownGiveUpMs: its pipes are closed and it is reported as it
+    // is, reaped if it has exited.
+    void Shutdown();
+    static constexpr int kShutdownKillMs = 2000;
+    static constexpr int kShutdownGiveUpMs = 3000;
+
+    // Reactor used by command executors
+    static ProcessReactor& Shared();
+
+private:
+    struct Watched;
+
+    std::mutex mutex_;                              // Guards pending_, stopping_ and thread start
+    std::vector<std::unique_ptr<Watched>> pending_; // Handed over, not yet registered with epoll
+    std::thread thread_;
+    std::atomic<size_t> active_;
+    bool stopping_;
+    int epollFd_;
+    int wakeFd_;                                    // eventfd: new children or shutdown
+
+    // Owned by the reactor thread
+    std::unordered_map<uint64_t, std::unique_ptr<Watched>> watched_;
+    std::vector<std::pair<uint64_t, int>> readyStreams_;   // (child, stream) not yet read to EAGAIN
+    std::vector<uint64_t> timed_;                           // Cancel tokens with a step or deadline due
+    std::vector<uint64_t> polling_;                         // Children without a pidfd
+    std::chrono::steady_clock::time_point stopStarted_;     // When the loop saw stopping_
+    bool stopSeen_;
+    std::vector<char> buffer_;
+    uint64_t nextId_;
+
+    void Loop();
+    void Register(std::unique_ptr<Watched> entry);
+
+    // Read up to a turn's budget from one stream; false once it would block or closed
+    bool ReadStream(Watched& entry, int stream);
+
+    // Send any stop signal due for entry; returns ms until it needs another look, or -1
+    int AdvanceCancel(Watched& entry);
+
+    // Reap and report entry if its pipes are closed and it has exited
+    bool TryFinish(Watched& entry);
+
+    // Take Shutdown()'s next step for every child; returns ms until the next one, or -1
+    int AdvanceShutdown();
+
+    // Close entry's pipes and report it without waiting for it to exit
+    void Abandon(Watched& entry);
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "terminal/process.h"
+#include "terminal/cancel_token.h"
+#include <string>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+namespace NeuroShell {
+
+// One long-lived interactive shell on a pseudo-terminal. Commands are written
+// to the shell's input and the end of each one is detected from an OSC 133
+// "command finished" marker that the shell prints as its prompt, so exported
+// variables, aliases and the working directory carry over between commands.
+class ShellSession {
+public:
+    using OutputCallback = std::function<void(const char* data, size_t size)>;
+
+    // Empty shellPath picks bash when available, otherwise /bin/sh
+    explicit ShellSession(const std::string& shellPath = "");
+    ~ShellSession();
+
+    // Start the shell in workingDir and wait for its first prompt
+    bool Start(const std::string& workingDir);
+
+    // Terminate the shell
+    void Stop();
+
+    // Is the shell running and able to take commands
+    bool IsAlive() const;
+
+    // Run one command line, streaming its output until the shell prompts again.
+    // stdout and stderr share the terminal, so everything arrives as one stream.
+    // Throws std::runtime_error if the shell dies while the command runs.
+    // A cancel token stops the foreground job, never the shell itself.
+    ProcessExit Run(const std::string& command, const OutputCallback& onOutput, CancelToken* cancel = nullptr);
+
+    // Send Ctrl+C to whatever is running in the foreground
+    void Interrupt();
+
+    // Send a signal to the terminal's foreground process group, unless that is the shell
+    void SignalForeground(int signal);
+
+    // Shell's working directory as of its last prompt
+    std::string GetWorkingDirectory() const;
+
+private:
+    std::string shellPath_;
+    std::string token_;             // Random tag that tells our markers apart from program output
+    std::string pending_;           // Bytes read but not yet handed out (possible partial marker)
+    std::string workingDir_;
+    mutable std::mutex stateMutex_; // Guards workingDir_
+    std::mutex runMutex_;           // One command at a time per shell
+    std::atomic<int> masterFd_;
+    int shellPid_;
+
+    enum class MarkerKind { None, Prompt, Continuation };
+
+    // Read until the next marker, forwarding output before it to onOutput.
+    // Returns None if timeoutMs passes or wakeFd becomes readable first.
+    MarkerKind ReadUntilMarker(const OutputCallback& onOutput, int timeoutMs, int& exitCode, int wakeFd = -1);
+
+    // Look for a complete marker in pending_; output before it goes to onOutput
+    MarkerKind ExtractMarker(const OutputCallback& onOutput, int& exitCode);
+
+    void WriteInput(const std::string& text);
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "terminal/process.h"
+
+namespace NeuroShell {
+
+// A tiny helper process forked at startup, before the UI grows, that spawns
+// children on request. Requests travel over a socketpair and the child's pipe
+// descriptors come back via SCM_RIGHTS, so the cost of creating a process no
+// longer depends on how large the UI's address space has become. The helper
+// is the children's parent, so it also reaps them and reports exit status and
+// resource usage back.
+class SpawnZygote {
+public:
+#ifndef _WIN32
+    // Fork the helper. Call early in main(), while the process is still small
+    // and single-threaded. Returns false if the helper couldn't be created.
+    static bool Start();
+
+    // Shut the helper down; children it already spawned keep running
+    static void Stop();
+
+    static bool IsRunning();
+
+    // Spawn through the helper, at options.limits.priority (other limits are
+    // not passed on). Throws std::runtime_error on failure.
+    static ChildProcess Spawn(const SpawnOptions& options);
+
+    // Block until a child spawned by the helper exits
+    static ProcessExit Wait(const ChildProcess& child);
+    
+    // Has the helper reported this child's exit yet
+    static bool HasExited(const ChildProcess& child);
+#endif
+};
+
+} // namespace NeuroShell
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "terminal/command_cache.h"
+#include "terminal/cancel_token.h"
+#include "terminal/working_directory.h"
+#include "utils/safety.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+namespace NeuroShell {
+
+// Runs the commands the user is likely to type next before they do. It learns
+// from the command history which command tends to follow which (every "cd X"
+// counts as one "cd"), and after a command finishes starts the likely
+// successors that SafetyChecker::isSpeculatable allows, at idle priority. A
+// finished result stays warm for a few seconds; if the same command is then
+// run in the same directory and what it reads is unchanged (the result cache's
+// fingerprint), its output is served at once. Any command that could write
+// drops everything warm. Thread-safe.
+class SpeculativeRunner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // A successor is predicted once seen this often, and at least this share of the time
+    static constexpr unsigned kMinSupport = 2;
+    static constexpr double kMinShare = 0.25;
+    // Counts per context are halved past this, so recent habits outweigh old ones
+    static constexpr unsigned kMaxCount = 64;
+    static constexpr size_t kMaxContexts = 512;
+    // A speculative run taking longer than this is stopped; nobody asked for it
+    static constexpr double kRunTimeoutSeconds = 10.0;
+
+    struct Stats {
+        uint64_t started;           // Speculative runs launched
+        uint64_t hits;              // Commands answered from a warm result
+        uint64_t misses;            // Speculatable commands run with nothing warm for them
+        uint64_t wasted;            // Runs that failed, expired or were dropped unused
+        double cpuSeconds;          // CPU of every finished speculative run
+        double wastedCpuSeconds;    // The part of it spent on wasted runs
+        size_t warm;                // Results waiting right now
+
+        Stats() : started(0), hits(0), misses(0), wasted(0), cpuSeconds(0.0), wastedCpuSeconds(0.0), warm(0) {}
+    };
+
+    // Called when a speculative run ends: whether it exited cleanly with all
+    // its output in memory, that output, and the CPU it used
+    using DoneFn = std::function<void(bool success, CachedResult result, double cpuSeconds)>;
+    // Starts command in dir at idle priority and calls done once, from any thread
+    using RunFn = std::function<void(const std::string& command, const WorkingDirectory& dir,
+                                     std::shared_ptr<CancelToken> cancel, DoneFn done)>;
+
+    SpeculativeRunner();
+    // Stops whatever is still running and waits for it
+    ~SpeculativeRunner();
+
+    SpeculativeRunner(const SpeculativeRunner&) = delete;
+    SpeculativeRunner& operator=(const SpeculativeRunner&) = delete;
+
+    void SetRunner(RunFn run);
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    // How long a result stays warm, and how many successors are run after one command
+    void SetLimits(int ttlMs, int maxPredictions);
+
+    // The user ran command. Learn that it followed the previous one; unless it
+    // is a built-in, which is never predicted, drop every warm result if it
+    // could have changed what they read.
+    void Observe(const std::string& command, bool builtIn = false);
+
+    // Likely successors of command, most likely first
+    std::vector<std::string> Predict(const std::string& command) const;
+
+    // command just finished (or cd'd) with dir as the working directory: start
+    // its likely successors on the background lane
+    void Speculate(const std::string& command, const WorkingDirectory& dir);
+
+    // A warm, still valid result for command in workingDir; counts a hit or miss.
+    // A run of it still in progress is stopped: the user's own run takes over.
+    bool Take(const std::string& command, const std::string& workingDir, CachedResult& result);
+
+    // Drop warm results and stop running ones
+    void Invalidate();
+
+    Stats GetStats() const;
+
+    // git with its lock-taking refresh turned off; other commands as they are
+    static std::string RunnableForm(const std::string& command);
+
+private:
+    struct Entry {
+        std::string command;
+        uint64_t fingerprint;
+        std::shared_ptr<CancelToken> cancel;
+        bool done;
+        Clock::time_point finishedAt;
+        CachedResult result;
+        double cpuSeconds;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::map<std::string, std::map<std::string, unsigned>> followers_;  // Context -> next command -> count
+    std::string previous_;                                              // Context of the last command observed
+    std::map<std::string, Entry> entries_;                              // By cache key: running and warm
+    size_t running_;                                                    // Started and not yet done
+    RunFn run_;
+    bool enabled_;
+    Clock::duration ttl_;
+    size_t maxPredictions_;
+    Stats stats_;
+    neuroshell::utils::SafetyChecker safety_;
+
+    // What a command predicts from: trimmed, with any cd folded into "cd"
+    static std::string Context(const std::string& command);
+
+    // Record how an unused result ended (caller holds mutex_)
+    void Waste(const Entry& entry);
+
+    // Drop expired results (caller holds mutex_)
+    void Sweep(Clock::time_point now);
+
+    // A speculative run of key ended
+    void Finish(const std::string& key, const std::shared_ptr<CancelToken>& cancel, bool success,
+                CachedResult result, double cpuSeconds);
+};
+
+} // namespace NeuroShell
@@ -2,9 +2,19 @@
 
 #include "common/types.h"
 #include "terminal/command_executor.h"
+#include "terminal/shell_session.h"
+#include "terminal/execution_planner.h"
+#include "terminal/command_cache.h"
+#include "terminal/speculative_runner.h"
+#include "terminal/job_table.h"
+#include "terminal/output_throttle.h"
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <functional>
 
 namespace NeuroShell {
 
@@ -16,15 +26,54 @@ public:
     // Initialize terminal
     void Initialize();
     
-    // Execute command and add to history
+    // Execute command and add to history. External commands run in the
+    // background and stream their output into a Running block. A trailing &
+    // makes the command a numbered background job (see ExecuteInBackground).
     void ExecuteCommand(const std::string& command);
     
+    // Start command as a background job. Outside session mode, jobs, fg, bg
+    // and kill %n typed at the prompt act on these jobs; a session shell
+    // keeps its own.
+    void ExecuteInBackground(const std::string& command);
+    
     // Execute AI-generated command with NLP prompt tracking
     void ExecuteAICommand(const std::string& command, const std::string& nlpPrompt);
     
-    // Get command history
+    // Execute a multi-command AI answer. Commands are planned into a dependency
+    // graph; independent read-only ones run concurrently (up to the parallel
+    // limit) while cd, writers and anything unknown keep their order. Blocks
+    // are added to history in the order given.
+    void ExecuteAICommands(const std::vector<std::string>& commands, const std::string& nlpPrompt);
+    
+    // How many commands of one AI answer may run at the same time
+    void SetMaxParallelCommands(int limit);
+    int GetMaxParallelCommands() const { return maxParallelCommands_; }
+    
+    // Stop a Running block: SIGINT, then SIGTERM, then SIGKILL to its process
+    // group. Output so far is kept and the block ends up Cancelled.
+    bool CancelCommand(uint64_t blockId);
+    void CancelAll();
+    
+    // Stop a Running block's process group with SIGSTOP, making it a stopped
+    // job; the block stays Running. Resume continues it, as a background job
+    // or back in the foreground. False if the block has no process to signal.
+    bool SuspendCommand(uint64_t blockId);
+    bool ResumeCommand(uint64_t blockId, bool foreground);
+    
+    // Background jobs, in number order
+    std::vector<Job> GetJobs() const;
+    
+    // Get command history (hold LockHistory() while reading it)
     const std::vector<CommandBlock>& GetHistory() const { return history_; }
     
+    // Lock guarding history against running commands appending output
+    std::unique_lock<std::recursive_mutex> LockHistory() const;
+    
+    // Running commands hand their output to history in batches, at most one
+    // per frame (see OutputThrottle). This hands over what went quiet before
+    // its batch was due; the UI calls it once per frame.
+    void PublishOutput();
+    
     // Clear history
     void ClearHistory();
     
@@ -34,6 +83,12 @@ public:
     // Get current working directory
     std::string GetWorkingDirectory() const;
     
+    // Session mode keeps one shell alive on a PTY and sends every command to it,
+    // so exports, aliases and cd persist. Returns false if the shell can't start.
+    // Commands already running in the old shell keep it alive until they finish.
+    bool SetSessionMode(bool enabled);
+    bool IsSessionMode() const { return GetSession() != nullptr; }
+    
     // Auto-completion suggestions
     std::vector<std::string> GetCompletions(const std::string& partial) const;
     
@@ -48,16 +103,140 @@ public:
     // Search history
     std::vector<CommandBlock> SearchHistory(const std::string& query) const;
     
+    // Resource totals per command line over finished blocks, most CPU first
+    std::vector<CommandCost> GetCommandCosts() const;
+    
+    // Which commands run under resource limits (cgroup v2, else setrlimit)
+    enum class LimitMode { None, AIGenerated, All };
+    void SetResourceLimits(LimitMode mode, const ResourceLimits& limits);
+    
+    // Result cache counters (hits, misses, invalidations)
+    CommandCache::Stats GetCacheStats() const { return cache_.GetStats(); }
+    
+    // Speculative pre-execution counters (hit rate, wasted CPU)
+    SpeculativeRunner::Stats GetSpeculationStats() const { return speculator_.GetStats(); }
+    
+    // Watch mode: rerun a finished block's command on the background lane when
+    // files change in its working directory tree, or under paths (relative to
+    // it), replacing the block's output in place. Returns false for built-ins,
+    // unknown blocks and platforms without inotify.
+    bool StartWatch(uint64_t blockId, const std::vector<std::string>& paths = {});
+    void StopWatch(uint64_t blockId);
+    
+    // Quiet time that ends a burst of changes, and the least time between reruns
+    void SetWatchTiming(int debounceMs, int minIntervalMs);
+    
+    // A finished command is diffed against the previous run of the same command
+    // in the same directory (see CommandBlock::diff). If the earlier output is
+    // plain stdout it is then dropped, to be rebuilt from the later one; this
+    // returns a block's output either way.
+    std::string RebuildOutput(uint64_t blockId);
+    
 private:
     std::unique_ptr<CommandExecutor> executor_;
+    std::shared_ptr<ShellSession> session_;                             // Guarded by historyMutex_; tasks hold a copy
+    CommandCache cache_;
+    SpeculativeRunner speculator_;                                      // Destroyed before executor_, which its runs use
     std::vector<CommandBlock> history_;
+    std::map<uint64_t, std::shared_ptr<CancelToken>> cancelTokens_;    // Running blocks
+    std::map<uint64_t, std::shared_ptr<OutputThrottle>> throttles_;    // Running blocks' queued output, guarded by historyMutex_
+    JobTable jobs_;                                                     // Guarded by historyMutex_
+    mutable std::recursive_mutex historyMutex_;
+    std::condition_variable_any reactorIdle_;                           // Signalled when reactorRuns_ drops to 0
+    int reactorRuns_;                                                   // RunStreaming commands not yet completed, guarded by historyMutex_
+    uint64_t nextBlockId_;
+    int maxParallelCommands_;
+    LimitMode limitMode_;
+    ResourceLimits limits_;
+    PriorityClasses priorities_;                                        // Set once in Initialize()
     int historyNavigationIndex_;
     bool screenCleared_;
     
+    // Watched blocks and the directory their reruns start in
+    struct WatchedBlock {
+        uint64_t watchId;           // FileWatcher id
+        WorkingDirectory workingDir;
+    };
+    std::map<uint64_t, WatchedBlock> watches_;     // By block id, guarded by historyMutex_
+    int watchDebounceMs_;
+    int watchMinIntervalMs_;
+    
+    // Append a Running block and stream the command's output into it
+    void RunCommand(const std::string& command, bool isAIGenerated, const std::string& nlpPrompt,
+                    bool background = false);
+    
+    // Add a Running block for command, with its cancel token; returns its id (caller holds the lock)
+    uint64_t AddRunningBlock(const std::string& command, bool isAIGenerated, const std::string& nlpPrompt);
+    
+    // Start command through the executor at origin's priority, streaming its output
+    // into the block. Returns once it is running; onFinished is called after the
+    // block completes. Unless replay is false, a cached or speculative result is
+    // used instead when there is one.
+    void RunStreaming(const std::string& command, uint64_t blockId, const WorkingDirectory& workingDir,
+                      CommandOrigin origin, std::function<void()> onFinished = nullptr, bool replay = true);
+    
+    // Start the likely successors of command in the current directory (not in a session)
+    void SpeculateAfter(const std::string& command);
+    
+    // Fill a Running block with a result that was ready before it ran
+    void ReplayResult(uint64_t blockId, const CachedResult& result, const WorkingDirectory& workingDir,
+                      bool speculated);
+    
+    // Progress of one multi-command AI answer
+    struct PlanRun;
+    
+    // Submit every command of the plan whose dependencies are done, up to the
+    // limit. Each finished command calls this again, so nothing waits on a worker.
+    void DispatchPlan(const std::shared_ptr<PlanRun>& run);
+    
+    // Clear a watched block and run its command again; the watch resumes once it finishes
+    void RerunWatched(uint64_t blockId);
+    
+    // Diff a finished block against its previous run, on the background lane
+    void DiffWithPreviousRun(uint64_t blockId);
+    
+    // Give blocks folded into blockId their own output back (caller holds the lock)
+    void UnfoldInto(uint64_t blockId);
+    
+    // Queue a running block's output chunk, handing the batch to the block if
+    // one is due and the history lock is free (any thread)
+    void QueueOutput(uint64_t blockId, OutputThrottle& throttle, OutputStream stream, const char* data, size_t size);
+    
+    // Append throttle's queued output to the block (caller holds the lock)
+    void PublishQueued(uint64_t blockId, OutputThrottle& throttle);
+    
+    // Start queuing output for a running block (caller holds the lock)
+    std::shared_ptr<OutputThrottle> StartThrottle(uint64_t blockId);
+    
+    // Once its output has ended, hand over the rest a batch at a time and stop
+    // queuing (takes the lock itself)
+    void FinishThrottle(uint64_t blockId, OutputThrottle& throttle);
+    
+    // The session shell, or null outside session mode (takes the lock itself)
+    std::shared_ptr<ShellSession> GetSession() const;
+    
+    // Run a command in the persistent shell (session mode)
+    void RunInSession(const std::shared_ptr<ShellSession>& session, const std::string& command, uint64_t blockId);
+    
+    // Token for a Running block, or null once it finished
+    std::shared_ptr<CancelToken> GetCancelToken(uint64_t blockId);
+    
+    // Locate a block by id; history is ordered by id (caller holds the lock)
+    CommandBlock* FindBlock(uint64_t id);
+    
     // Built-in commands
     void HandleBuiltInCommand(const std::string& command);
     bool IsBuiltInCommand(const std::string& command) const;
     
+    // jobs, fg, bg, and kill with a %job argument
+    bool IsJobCommand(const std::string& command) const;
+    
+    // Run a job command into block (caller holds the lock)
+    void RunJobCommand(const std::string& command, CommandBlock& block);
+    
+    // Mark blockId's job finished once its command completes (caller holds the lock)
+    void FinishJob(CommandBlock& block);
+    
     // Command completion data
     std::vector<std::string> commonCommands_;
     void InitializeCompletions();
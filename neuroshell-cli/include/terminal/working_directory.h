@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+namespace NeuroShell {
+
+// A working directory held as an open directory descriptor plus the path shown
+// to the user. Children switch into the descriptor between fork and exec and
+// cd is resolved with openat(), so the UI process never calls chdir() and any
+// number of executors can keep their own directory at once. The descriptor
+// keeps pointing at the same directory even if it is renamed. Copies share it
+// and it is closed with the last one. On Windows only the path is kept.
+class WorkingDirectory {
+public:
+    // Empty: callers substitute their own default
+    WorkingDirectory();
+
+    // The process's working directory right now
+    static WorkingDirectory Current();
+
+    // Resolve path (absolute, or relative to this directory) the way cd would.
+    // Returns false if it doesn't name a directory that can be entered.
+    bool Resolve(const std::string& path, WorkingDirectory& result) const;
+
+    bool IsValid() const { return !path_.empty(); }
+    const std::string& Path() const { return path_; }
+
+    // Descriptor for fchdir()/openat(), or -1 if there is none
+    int Fd() const;
+
+private:
+    class Handle;
+
+    std::shared_ptr<Handle> handle_;
+    std::string path_;
+};
+
+} // namespace NeuroShell
@@ -18,6 +18,10 @@ public:
     static ThemeColors GetWarpDarkColors();
     static ThemeColors GetHyperColors();
     
+    // Color for a packed span color (see ansi_parser.h): palette entries 0-15
+    // come from the theme, 16-255 are the xterm cube and grays
+    static ImVec4 AnsiColor(const ThemeColors& colors, uint32_t color, const ImVec4& defaultColor);
+    
     // Setup ImGui style for terminal application
     static void SetupTerminalStyle();
     
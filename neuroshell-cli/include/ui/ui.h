@@ -9,6 +9,8 @@
 #include "imgui.h"
 #include <memory>
 #include <string>
+#include <map>
+#include <set>
 
 namespace NeuroShell {
 
@@ -49,6 +51,14 @@ private:
     bool aiEnabled_;
     std::string statusMessage_;
     bool showWelcomeBanner_;
+    // Spilled output the user asked to see, per block; a watch rerun starts it over
+    struct LoadedMiddle {
+        unsigned run = 0;
+        std::string text;
+    };
+    std::map<uint64_t, LoadedMiddle> loadedMiddle_;
+    std::set<uint64_t> changesOnly_;                // Blocks showing just their diff to the previous run
+    std::map<uint64_t, std::string> rebuiltOutput_; // Folded outputs the user asked to see
     
     // Rendering methods
     void RenderFrame();
@@ -64,6 +74,16 @@ private:
     
     // Command block rendering
     void RenderCommandBlock(const CommandBlock& block, int index);
+    void RenderBlockOutput(const CommandBlock& block, const ImVec4& stdoutColor, const ImVec4& stderrColor);
+    void RenderStyledText(const char* from, const char* to, const TextStyle& style,
+                          const ImVec4& baseColor, bool& lineOpen);
+    void RenderOutputRange(const CommandBlock& block, const char* text, size_t begin, size_t end,
+                           const ImVec4& stdoutColor, const ImVec4& stderrColor);
+    void RenderOutputDiff(const CommandBlock& block);
+    void RenderFoldedOutput(const CommandBlock& block);
+    void RenderFloodTail(const CommandBlock& block, const ImVec4& stdoutColor, const ImVec4& stderrColor);
+    void RenderOutputRegion(const CommandBlock& block, const char* text, size_t begin, size_t end, bool clipped,
+                            const ImVec4& stdoutColor, const ImVec4& stderrColor);
     
     // Input handling
     void HandleCommandInput();
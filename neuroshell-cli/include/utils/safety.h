@@ -56,8 +56,26 @@ public:
      */
     bool hasInjectionRisk(const std::string& input) const;
 
+    /**
+     * @brief Check if a command is safe and its output only depends on the
+     *        files it reads, so a previous result can be reused
+     * @param command Command to check
+     * @return True if command output may be cached
+     */
+    bool isCacheable(const std::string& command) const;
+
+    /**
+     * @brief Check if a command may be run before the user asks for it: it
+     *        only reads, and leaves nothing behind (not even lock files)
+     * @param command Command to check
+     * @return True if command may be run speculatively
+     */
+    bool isSpeculatable(const std::string& command) const;
+
 private:
     std::set<std::string> whitelisted_commands_;
+    std::set<std::string> cacheable_commands_;
+    std::set<std::string> speculatable_git_commands_;
     std::set<std::string> blacklisted_commands_;
     std::vector<std::string> dangerous_patterns_;
     std::vector<std::string> injection_patterns_;
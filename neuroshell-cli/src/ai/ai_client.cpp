@@ -1,7 +1,7 @@
 #include "ai/ai_client.h"
+#include "common/thread_pool.h"
 #include <regex>
 #include <sstream>
-#include <thread>
 
 // For JSON parsing - using simple string manipulation for now
 // In production, use nlohmann/json library
@@ -81,10 +81,10 @@ AIResponse AIClient::TranslateToCommand(const std::string& naturalLanguage) {
 
 void AIClient::TranslateToCommandAsync(const std::string& naturalLanguage,
                                        std::function<void(const AIResponse&)> callback) {
-    std::thread([this, naturalLanguage, callback]() {
+    ThreadPool::Shared().Submit([this, naturalLanguage, callback]() {
         AIResponse response = TranslateToCommand(naturalLanguage);
         callback(response);
-    }).detach();
+    }, TaskPriority::Interactive);
 }
 
 AIResponse AIClient::ExplainCommand(const std::string& shellCommand) {
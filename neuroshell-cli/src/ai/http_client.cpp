@@ -1,7 +1,7 @@
 #include "ai/http_client.h"
+#include "common/thread_pool.h"
 #include <curl/curl.h>
 #include <stdexcept>
-#include <thread>
 
 namespace NeuroShell {
 
@@ -179,10 +179,10 @@ void HttpClient::PostAsync(const std::string& url,
                            const std::string& jsonBody,
                            std::function<void(const HttpResponse&)> callback,
                            const std::map<std::string, std::string>& headers) {
-    std::thread([this, url, jsonBody, callback, headers]() {
+    ThreadPool::Shared().Submit([this, url, jsonBody, callback, headers]() {
         HttpResponse response = Post(url, jsonBody, headers);
         callback(response);
-    }).detach();
+    }, TaskPriority::Background);
 }
 
 } // namespace NeuroShell
@@ -0,0 +1,208 @@
+#include "common/ansi_parser.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace NeuroShell {
+
+namespace {
+
+constexpr char kEsc = '\x1b';
+constexpr char kBel = '\x07';
+
+// Longer CSI sequences are garbage; keep consuming them but don't store more
+constexpr size_t kMaxCsiLength = 128;
+
+// Parameter groups are split by ';', sub-parameters by ':' (38:2::r:g:b)
+std::vector<std::vector<int>> SplitParams(const std::string& params) {
+    std::vector<std::vector<int>> groups(1);
+    std::string number;
+    auto flush = [&]() {
+        groups.back().push_back(number.empty() ? -1 : std::atoi(number.c_str()));
+        number.clear();
+    };
+    for (char c : params) {
+        if (c >= '0' && c <= '9') {
+            if (number.size() < 9) number += c;
+        } else if (c == ':') {
+            flush();
+        } else if (c == ';') {
+            flush();
+            groups.emplace_back();
+        }
+    }
+    flush();
+    return groups;
+}
+
+int Channel(int value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+} // namespace
+
+void DropStyleSpans(std::vector<StyleSpan>& spans, size_t from, size_t to, size_t keep) {
+    auto startsBefore = [](const StyleSpan& span, size_t offset) { return span.offset < offset; };
+    auto first = std::lower_bound(spans.begin(), spans.end(), from, startsBefore);
+    auto last = std::lower_bound(spans.begin(), spans.end(), to, startsBefore);
+    if (static_cast<size_t>(spans.end() - last) > keep) {
+        last = spans.end() - keep;
+    }
+    if (first >= last) return;
+
+    StyleSpan carried = *(last - 1);
+    carried.offset = std::max(carried.offset, to);
+    TextStyle before = first == spans.begin() ? TextStyle() : (first - 1)->style;
+
+    auto next = spans.erase(first, last);
+    if (carried.style != before && (next == spans.end() || next->offset > carried.offset)) {
+        spans.insert(next, carried);
+    }
+}
+
+AnsiParser::AnsiParser()
+    : state_(State::Text)
+{
+}
+
+void AnsiParser::Reset() {
+    state_ = State::Text;
+    style_ = TextStyle();
+    params_.clear();
+}
+
+void AnsiParser::Feed(const char* data, size_t size, std::string& text, std::vector<StyleRun>& runs) {
+    size_t runStart = text.size();
+    TextStyle runStyle = style_;
+
+    // Close the current run before a style change; runs of equal style merge
+    auto closeRun = [&]() {
+        size_t length = text.size() - runStart;
+        if (length > 0) {
+            if (!runs.empty() && runs.back().style == runStyle) {
+                runs.back().length += length;
+            } else {
+                runs.push_back({ length, runStyle });
+            }
+        }
+        runStart = text.size();
+        runStyle = style_;
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        char c = data[i];
+        switch (state_) {
+        case State::Text: {
+            // Copy plain text up to the next escape in one go
+            size_t end = i;
+            while (end < size && data[end] != kEsc && data[end] != kBel) ++end;
+            text.append(data + i, end - i);
+            i = end;
+            if (i < size) {
+                if (data[i] == kEsc) state_ = State::Escape;
+                ++i;
+            }
+            continue;
+        }
+        case State::Escape:
+            if (c == '[') {
+                state_ = State::Csi;
+                params_.clear();
+            } else if (c == ']') {
+                state_ = State::Osc;
+            } else if (c >= 0x20 && c <= 0x2F) {
+                state_ = State::EscapeIntermediate;
+            } else if (c == kEsc) {
+                // ESC ESC: the first one was stray
+            } else {
+                state_ = State::Text;
+            }
+            break;
+        case State::EscapeIntermediate:
+            if (c < 0x20 || c > 0x2F) state_ = State::Text;
+            break;
+        case State::Csi:
+            if (c >= 0x40 && c <= 0x7E) {
+                // Only plain SGR: private (?, >) or intermediate forms aren't colors
+                bool plain = params_.find_first_not_of("0123456789;:") == std::string::npos;
+                if (c == 'm' && plain) {
+                    closeRun();
+                    ApplySgr(params_);
+                    runStyle = style_;
+                }
+                params_.clear();
+                state_ = State::Text;
+            } else if (c == kEsc) {
+                params_.clear();
+                state_ = State::Escape;
+            } else if (params_.size() < kMaxCsiLength) {
+                params_ += c;
+            }
+            break;
+        case State::Osc:
+            if (c == kBel) state_ = State::Text;
+            else if (c == kEsc) state_ = State::OscEscape;
+            break;
+        case State::OscEscape:
+            state_ = c == '\\' ? State::Text : (c == kEsc ? State::OscEscape : State::Osc);
+            break;
+        }
+        ++i;
+    }
+    closeRun();
+}
+
+void AnsiParser::ApplySgr(const std::string& params) {
+    std::vector<std::vector<int>> groups = SplitParams(params);
+
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const std::vector<int>& group = groups[g];
+        int code = group[0] < 0 ? 0 : group[0];
+
+        if (code == 38 || code == 48) {
+            // Extended color, either as sub-parameters or as the following groups
+            std::vector<int> args;
+            if (group.size() > 1) {
+                args.assign(group.begin() + 1, group.end());
+                // 38:2:<colorspace>:r:g:b carries an extra (usually empty) field
+                if (args.size() >= 5 && args[0] == 2) args.erase(args.begin() + 1);
+            } else {
+                size_t needed = (g + 1 < groups.size() && groups[g + 1][0] == 2) ? 4 : 2;
+                for (size_t k = 1; k <= needed && g + k < groups.size(); ++k) {
+                    args.push_back(groups[g + k][0]);
+                }
+                g += args.size();
+            }
+
+            uint32_t color = kDefaultColor;
+            if (args.size() >= 2 && args[0] == 5) {
+                color = PaletteColor(Channel(args[1]));
+            } else if (args.size() >= 4 && args[0] == 2) {
+                color = RgbColor(Channel(args[1]), Channel(args[2]), Channel(args[3]));
+            } else {
+                continue;
+            }
+            (code == 38 ? style_.fg : style_.bg) = color;
+            continue;
+        }
+
+        if (code == 0) style_ = TextStyle();
+        else if (code == 1) style_.flags |= StyleBold;
+        else if (code == 2) style_.flags |= StyleDim;
+        else if (code == 3) style_.flags |= StyleItalic;
+        else if (code == 4) style_.flags |= StyleUnderline;
+        else if (code == 7) style_.flags |= StyleInverse;
+        else if (code == 22) style_.flags &= ~(StyleBold | StyleDim);
+        else if (code == 23) style_.flags &= ~StyleItalic;
+        else if (code == 24) style_.flags &= ~StyleUnderline;
+        else if (code == 27) style_.flags &= ~StyleInverse;
+        else if (code >= 30 && code <= 37) style_.fg = PaletteColor(code - 30);
+        else if (code == 39) style_.fg = kDefaultColor;
+        else if (code >= 40 && code <= 47) style_.bg = PaletteColor(code - 40);
+        else if (code == 49) style_.bg = kDefaultColor;
+        else if (code >= 90 && code <= 97) style_.fg = PaletteColor(code - 90 + 8);
+        else if (code >= 100 && code <= 107) style_.bg = PaletteColor(code - 100 + 8);
+    }
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,180 @@
+#include "common/line_diff.h"
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+namespace NeuroShell {
+
+namespace {
+
+// Builds runs back to front, merging neighbours with the same op
+class RunBuilder {
+public:
+    void Push(DiffOp op, size_t count) {
+        if (count == 0) return;
+        if (!runs_.empty() && runs_.back().op == op) {
+            runs_.back().count += static_cast<uint32_t>(count);
+        } else {
+            runs_.push_back({ op, static_cast<uint32_t>(count) });
+        }
+    }
+
+    void Finish(std::vector<DiffRun>& runs) {
+        runs.assign(runs_.rbegin(), runs_.rend());
+    }
+
+private:
+    std::vector<DiffRun> runs_;
+};
+
+} // namespace
+
+std::vector<std::string_view> LineDiff::SplitLines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    const char* p = text.data();
+    const char* end = text.data() + text.size();
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* next = newline ? newline + 1 : end;
+        lines.emplace_back(p, next - p);
+        p = next;
+    }
+    return lines;
+}
+
+bool LineDiff::Compute(const std::vector<std::string_view>& before, const std::vector<std::string_view>& after,
+                       std::vector<DiffRun>& runs, size_t maxEdits) {
+    size_t prefix = 0;
+    while (prefix < before.size() && prefix < after.size() && before[prefix] == after[prefix]) ++prefix;
+    size_t suffix = 0;
+    while (suffix < before.size() - prefix && suffix < after.size() - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    // Only the middle is left to diff; hashes make most comparisons one integer compare
+    const int n = static_cast<int>(before.size() - prefix - suffix);
+    const int m = static_cast<int>(after.size() - prefix - suffix);
+    std::hash<std::string_view> hasher;
+    std::vector<size_t> beforeHashes(n);
+    std::vector<size_t> afterHashes(m);
+    for (int i = 0; i < n; ++i) beforeHashes[i] = hasher(before[prefix + i]);
+    for (int j = 0; j < m; ++j) afterHashes[j] = hasher(after[prefix + j]);
+    auto equal = [&](int x, int y) {
+        return beforeHashes[x] == afterHashes[y] && before[prefix + x] == after[prefix + y];
+    };
+
+    // Furthest x reached on each diagonal k = x - y. The values from the
+    // previous round are saved at the start of each round, for the way back.
+    const int maxD = static_cast<int>(std::min(static_cast<size_t>(n + m), maxEdits));
+    const int offset = maxD + 1;
+    std::vector<int> furthest(2 * maxD + 3, 0);
+    std::vector<int> trace;
+    std::vector<size_t> traceStart;
+    int edits = -1;
+    for (int d = 0; d <= maxD && edits < 0; ++d) {
+        if (d > 0) {
+            traceStart.push_back(trace.size());
+            trace.insert(trace.end(), furthest.begin() + offset - (d - 1), furthest.begin() + offset + d);
+        }
+        for (int k = -d; k <= d; k += 2) {
+            bool down = k == -d || (k != d && furthest[offset + k - 1] < furthest[offset + k + 1]);
+            int x = down ? furthest[offset + k + 1] : furthest[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && equal(x, y)) {
+                ++x;
+                ++y;
+            }
+            furthest[offset + k] = x;
+            if (x >= n && y >= m) {
+                edits = d;
+                break;
+            }
+        }
+    }
+    if (edits < 0) return false;
+
+    // Walk back from the end: each round was one edit followed by a run of equal lines
+    RunBuilder builder;
+    builder.Push(DiffOp::Equal, suffix);
+    int x = n;
+    int y = m;
+    for (int d = edits; d > 0; --d) {
+        const int* previous = trace.data() + traceStart[d - 1] + (d - 1);
+        int k = x - y;
+        bool down = k == -d || (k != d && previous[k - 1] < previous[k + 1]);
+        int previousK = down ? k + 1 : k - 1;
+        int previousX = previous[previousK];
+        int startX = down ? previousX : previousX + 1;
+        builder.Push(DiffOp::Equal, x - startX);
+        builder.Push(down ? DiffOp::Insert : DiffOp::Delete, 1);
+        x = previousX;
+        y = previousX - previousK;
+    }
+    builder.Push(DiffOp::Equal, x + prefix);
+    builder.Finish(runs);
+    return true;
+}
+
+bool LineDiff::Diff(std::string_view before, std::string_view after, OutputDiff& diff, size_t maxEdits) {
+    std::vector<std::string_view> beforeLines = SplitLines(before);
+    std::vector<std::string_view> afterLines = SplitLines(after);
+    std::vector<DiffRun> runs;
+    if (!Compute(beforeLines, afterLines, runs, maxEdits)) return false;
+
+    diff.runs = std::move(runs);
+    diff.deleted.clear();
+    diff.insertedLines = 0;
+    diff.deletedLines = 0;
+    size_t line = 0;
+    for (const auto& run : diff.runs) {
+        if (run.op == DiffOp::Insert) {
+            diff.insertedLines += run.count;
+            continue;
+        }
+        if (run.op == DiffOp::Delete) {
+            for (size_t i = 0; i < run.count; ++i) {
+                diff.deleted.append(beforeLines[line + i].data(), beforeLines[line + i].size());
+            }
+            diff.deletedLines += run.count;
+        }
+        line += run.count;
+    }
+    diff.runs.shrink_to_fit();
+    diff.deleted.shrink_to_fit();
+    return true;
+}
+
+std::string OutputDiff::Rebuild(std::string_view current) const {
+    std::vector<std::string_view> lines = LineDiff::SplitLines(current);
+    size_t expected = 0;
+    for (const auto& run : runs) {
+        if (run.op != DiffOp::Delete) expected += run.count;
+    }
+    if (expected != lines.size()) return std::string();    // Not the output this diff belongs to
+
+    std::string text;
+    text.reserve(current.size() + deleted.size());
+    size_t line = 0;
+    size_t deletedPos = 0;
+    for (const auto& run : runs) {
+        if (run.op == DiffOp::Equal) {
+            for (size_t i = 0; i < run.count; ++i) {
+                text.append(lines[line + i].data(), lines[line + i].size());
+            }
+            line += run.count;
+        } else if (run.op == DiffOp::Insert) {
+            line += run.count;
+        } else {
+            for (size_t i = 0; i < run.count; ++i) {
+                size_t newline = deleted.find('\n', deletedPos);
+                size_t next = newline == std::string::npos ? deleted.size() : newline + 1;
+                text.append(deleted, deletedPos, next - deletedPos);
+                deletedPos = next;
+            }
+        }
+    }
+    return text;
+}
+
+} // namespace NeuroShell
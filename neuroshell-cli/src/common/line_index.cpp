@@ -0,0 +1,196 @@
+#include "common/line_index.h"
+#include <algorithm>
+#include <cstring>
+
+namespace NeuroShell {
+
+namespace {
+
+void WriteVarint(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+size_t ReadVarint(const uint8_t*& p) {
+    size_t value = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        value |= static_cast<size_t>(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= static_cast<size_t>(*p++) << shift;
+    return value;
+}
+
+// Newlines in text[from, to), stopping early once limit were seen; offset ends
+// up just past the last one counted
+size_t CountNewlines(const OutputBuffer& text, size_t from, size_t to, size_t limit, size_t& offset) {
+    size_t count = 0;
+    offset = from;
+    if (limit == 0 || from >= to) return 0;
+    text.ForEachChunk(from, to - from, [&](const char* data, size_t size, size_t chunkOffset) {
+        const char* p = data;
+        const char* end = data + size;
+        while (count < limit) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!newline) return true;
+            ++count;
+            offset = chunkOffset + (newline - data) + 1;
+            p = newline + 1;
+        }
+        return false;
+    });
+    return count;
+}
+
+} // namespace
+
+LineIndex::LineIndex(size_t memoryBudget)
+    : memoryBudget_(memoryBudget)
+{
+    Clear();
+}
+
+void LineIndex::Clear() {
+    groups_.assign(1, Group{ 0, 0, 0 });
+    deltas_.clear();
+    size_ = 0;
+    lines_ = 1;
+    lastStart_ = 0;
+    compactAt_ = memoryBudget_;
+}
+
+void LineIndex::Append(const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!newline) break;
+        AddLineStart(size_ + (newline - data) + 1);
+        p = newline + 1;
+    }
+    size_ += size;
+}
+
+void LineIndex::AddLineStart(size_t offset) {
+    if (lines_ % kGroupLines == 0) {
+        groups_.push_back(Group{ lines_, offset, deltas_.size() });
+    } else {
+        WriteVarint(deltas_, offset - lastStart_);
+    }
+    lastStart_ = offset;
+    ++lines_;
+}
+
+size_t LineIndex::LineCount() const {
+    if (size_ == 0) return 0;
+    return lastStart_ == size_ ? lines_ - 1 : lines_;
+}
+
+size_t LineIndex::DeltaCount(const Group& group) const {
+    // Every group but the last is full
+    return std::min(kGroupLines - 1, lines_ - 1 - group.line);
+}
+
+LineIndex::Known LineIndex::NearestByLine(size_t line) const {
+    auto group = std::upper_bound(groups_.begin(), groups_.end(), line,
+                                  [](size_t value, const Group& g) { return value < g.line; }) - 1;
+    Known known = { group->line, group->offset, false };
+    if (group->position == kNoDeltas) return known;
+
+    const uint8_t* p = deltas_.data() + group->position;
+    size_t steps = std::min(line - group->line, DeltaCount(*group));
+    for (size_t i = 0; i < steps; ++i) {
+        known.offset += ReadVarint(p);
+        ++known.line;
+    }
+    return known;
+}
+
+LineIndex::Known LineIndex::NearestByOffset(size_t offset) const {
+    auto group = std::upper_bound(groups_.begin(), groups_.end(), offset,
+                                  [](size_t value, const Group& g) { return value < g.offset; }) - 1;
+    Known known = { group->line, group->offset, false };
+    if (group->position == kNoDeltas) return known;
+
+    const uint8_t* p = deltas_.data() + group->position;
+    size_t count = DeltaCount(*group);
+    for (size_t i = 0; i < count; ++i) {
+        size_t next = known.offset + ReadVarint(p);
+        if (next > offset) {
+            known.last = true;
+            return known;
+        }
+        known.offset = next;
+        ++known.line;
+    }
+    // Past the group's deltas: settled only if the next group picks up right after
+    auto next = group + 1;
+    known.last = next == groups_.end() ? known.line + 1 == lines_ : next->line == known.line + 1;
+    return known;
+}
+
+size_t LineIndex::LineStart(size_t line, const OutputBuffer& text) const {
+    if (line >= lines_) return size_;
+    Known known = NearestByLine(line);
+    if (known.line == line) return known.offset;
+
+    // Thinned-out stretch: count the rest in the text
+    size_t offset;
+    CountNewlines(text, known.offset, size_, line - known.line, offset);
+    return offset;
+}
+
+size_t LineIndex::LineAt(size_t offset, const OutputBuffer& text) const {
+    if (offset >= size_) return lines_ - 1;
+    Known known = NearestByOffset(offset);
+    if (known.last) return known.line;
+
+    // Thinned-out stretch: every newline before offset started another line
+    size_t end;
+    return known.line + CountNewlines(text, known.offset, offset, static_cast<size_t>(-1), end);
+}
+
+void LineIndex::Compact(size_t from, size_t to) {
+    if (MemoryBytes() <= compactAt_) return;
+
+    // Move the deltas that stay down over the dropped ones, in place
+    size_t write = 0;
+    size_t kept = 0;
+    for (size_t i = 0; i < groups_.size(); ++i) {
+        Group group = groups_[i];
+        bool last = i + 1 == groups_.size();
+        size_t end = last ? size_ : groups_[i + 1].offset;
+        bool inside = !last && group.offset >= from && end <= to;
+
+        if (group.position != kNoDeltas) {
+            const uint8_t* p = deltas_.data() + group.position;
+            size_t count = DeltaCount(group);
+            for (size_t k = 0; k < count; ++k) ReadVarint(p);
+            size_t length = p - (deltas_.data() + group.position);
+            if (inside) {
+                group.position = kNoDeltas;
+            } else {
+                std::memmove(deltas_.data() + write, deltas_.data() + group.position, length);
+                group.position = write;
+                write += length;
+            }
+        }
+        if (group.position == kNoDeltas && group.line % kSparseLines != 0) continue;
+        groups_[kept++] = group;
+    }
+    groups_.resize(kept);
+    deltas_.resize(write);
+    groups_.shrink_to_fit();
+    deltas_.shrink_to_fit();
+    compactAt_ = std::max(memoryBudget_, 2 * MemoryBytes());
+}
+
+size_t LineIndex::MemoryBytes() const {
+    return groups_.capacity() * sizeof(Group) + deltas_.capacity();
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,203 @@
+#include "common/output_buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace NeuroShell {
+
+namespace {
+
+std::atomic<size_t> gDefaultHeadBytes{256 * 1024};
+std::atomic<size_t> gDefaultTailBytes{256 * 1024};
+
+constexpr size_t kReadChunkBytes = 64 * 1024;
+
+bool SeekTo(std::FILE* file, size_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+} // namespace
+
+// Anonymous temp file holding the spilled middle; removed when the last copy goes
+class OutputBuffer::SpillFile {
+public:
+    SpillFile() : file_(std::tmpfile()), written_(0) {}
+    ~SpillFile() { if (file_) std::fclose(file_); }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    // Append at the end; returns how many bytes made it to the file
+    size_t Write(const char* data, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_ || !SeekTo(file_, written_)) return 0;
+        size_t done = std::fwrite(data, 1, size, file_);
+        written_ += done;
+        if (done < size) {
+            // Disk full or similar; don't try again and leave a hole in the middle
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+        return done;
+    }
+
+    size_t Read(size_t offset, char* out, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_ || !SeekTo(file_, offset)) return 0;
+        // Readers may be behind a writer that left the stream in write mode
+        std::fflush(file_);
+        return std::fread(out, 1, size, file_);
+    }
+
+private:
+    std::FILE* file_;
+    size_t written_;
+    std::mutex mutex_;
+};
+
+OutputBuffer::OutputBuffer()
+    : spilledBytes_(0)
+    , lostBytes_(0)
+    , headLimit_(gDefaultHeadBytes.load())
+    , tailLimit_(gDefaultTailBytes.load())
+{
+}
+
+OutputBuffer::OutputBuffer(const std::string& text)
+    : OutputBuffer()
+{
+    Append(text.data(), text.size());
+}
+
+OutputBuffer::OutputBuffer(const char* text)
+    : OutputBuffer(std::string(text))
+{
+}
+
+OutputBuffer& OutputBuffer::operator=(const std::string& text) {
+    Clear();
+    Append(text.data(), text.size());
+    return *this;
+}
+
+OutputBuffer& OutputBuffer::operator=(const char* text) {
+    return *this = std::string(text);
+}
+
+void OutputBuffer::Append(const char* data, size_t size) {
+    // The head fills first and is never touched again
+    if (spilledBytes_ == 0 && tail_.empty() && head_.size() < headLimit_) {
+        size_t take = std::min(size, headLimit_ - head_.size());
+        head_.append(data, take);
+        data += take;
+        size -= take;
+    }
+    if (size == 0) return;
+
+    tail_.append(data, size);
+    // Let the tail grow to twice its budget so spilling happens in large writes
+    if (tail_.size() > 2 * tailLimit_) {
+        SpillTail();
+    }
+}
+
+void OutputBuffer::SpillTail() {
+    size_t excess = tail_.size() - tailLimit_;
+    if (!spill_ && lostBytes_ == 0) {
+        spill_ = std::make_shared<SpillFile>();
+    }
+
+    size_t written = lostBytes_ == 0 ? spill_->Write(tail_.data(), excess) : 0;
+    lostBytes_ += excess - written;
+    spilledBytes_ += excess;
+    tail_.erase(0, excess);
+}
+
+void OutputBuffer::Clear() {
+    head_.clear();
+    tail_.clear();
+    spill_.reset();
+    spilledBytes_ = 0;
+    lostBytes_ = 0;
+}
+
+void OutputBuffer::ForEachChunk(size_t offset, size_t length, const ChunkFn& fn) const {
+    size_t end = std::min(Size(), offset + std::min(length, Size()));
+    if (offset >= end) return;
+
+    // Head
+    size_t headEnd = head_.size();
+    if (offset < headEnd) {
+        size_t stop = std::min(end, headEnd);
+        if (!fn(head_.data() + offset, stop - offset, offset)) return;
+        offset = stop;
+    }
+
+    // Spilled middle, read back a piece at a time; a lost stretch is skipped
+    size_t fileEnd = headEnd + spilledBytes_ - lostBytes_;
+    if (offset < fileEnd && offset < end && spill_) {
+        std::vector<char> buffer(kReadChunkBytes);
+        size_t stop = std::min(end, fileEnd);
+        while (offset < stop) {
+            size_t want = std::min(buffer.size(), stop - offset);
+            size_t got = spill_->Read(offset - headEnd, buffer.data(), want);
+            if (got == 0) break;
+            if (!fn(buffer.data(), got, offset)) return;
+            offset += got;
+        }
+    }
+
+    // Tail
+    size_t tailStart = TailOffset();
+    offset = std::max(offset, tailStart);
+    if (offset < end) {
+        fn(tail_.data() + (offset - tailStart), end - offset, offset);
+    }
+}
+
+std::string OutputBuffer::Read(size_t offset, size_t length) const {
+    std::string text;
+    ForEachChunk(offset, length, [&text](const char* data, size_t size, size_t) {
+        text.append(data, size);
+        return true;
+    });
+    return text;
+}
+
+size_t OutputBuffer::Find(const std::string& needle, size_t from) const {
+    if (needle.empty()) return from <= Size() ? from : std::string::npos;
+
+    // Carry the last needle.size() - 1 bytes over so matches across chunks are found
+    std::string window;
+    size_t windowStart = from;
+    size_t found = std::string::npos;
+    ForEachChunk(from, Size(), [&](const char* data, size_t size, size_t offset) {
+        if (windowStart + window.size() != offset) {
+            window.clear();
+            windowStart = offset;
+        }
+        window.append(data, size);
+        size_t pos = window.find(needle);
+        if (pos != std::string::npos) {
+            found = windowStart + pos;
+            return false;
+        }
+        size_t keep = std::min(window.size(), needle.size() - 1);
+        windowStart += window.size() - keep;
+        window.erase(0, window.size() - keep);
+        return true;
+    });
+    return found;
+}
+
+void OutputBuffer::SetDefaultLimits(size_t headBytes, size_t tailBytes) {
+    gDefaultHeadBytes = headBytes;
+    gDefaultTailBytes = tailBytes;
+}
+
+} // namespace NeuroShell
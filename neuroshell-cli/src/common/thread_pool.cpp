@@ -0,0 +1,192 @@
+#include "common/thread_pool.h"
+#include <algorithm>
+
+namespace NeuroShell {
+
+namespace {
+
+// Which pool and worker the current thread belongs to, for local submission
+thread_local const void* tCurrentPool = nullptr;
+thread_local size_t tCurrentWorker = 0;
+
+template <typename T>
+void UpdateMax(std::atomic<T>& target, T value) {
+    T current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t MicrosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t workerCount)
+    : reserved_(0)
+    , pending_(0)
+    , pendingBackground_(0)
+    , nextWorker_(0)
+    , stopping_(false)
+{
+    if (workerCount == 0) {
+        // Commands hold a worker for as long as they run, so don't go below 8
+        workerCount = std::max<size_t>(8, std::thread::hardware_concurrency());
+    }
+    if (workerCount >= 2) {
+        reserved_ = std::max<size_t>(1, workerCount / 4);
+    }
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Shutdown();
+}
+
+bool ThreadPool::Submit(Task task, TaskPriority priority) {
+    size_t lane = static_cast<size_t>(priority);
+    size_t target = tCurrentPool == this
+        ? tCurrentWorker
+        : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        if (stopping_) return false;
+
+        // Count it before it becomes visible, so a worker can't finish it first
+        LaneStats& stats = stats_[lane];
+        stats.submitted++;
+        UpdateMax(stats.maxDepth, ++stats.depth);
+
+        Worker& worker = *workers_[target];
+        std::lock_guard<std::mutex> workerLock(worker.mutex);
+        worker.lanes[lane].push_back({ std::move(task), std::chrono::steady_clock::now() });
+        pending_++;
+        if (priority == TaskPriority::Background) pendingBackground_++;
+    }
+
+    // Waking one worker could pick a reserved one, which leaves interactive work alone
+    if (priority == TaskPriority::Background) {
+        wake_.notify_one();
+    } else {
+        wake_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    // A task calling Shutdown() can't join its own worker; it exits after the task
+    std::lock_guard<std::mutex> lock(joinMutex_);
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable() && worker->thread.get_id() != std::this_thread::get_id()) {
+            worker->thread.join();
+        }
+    }
+}
+
+ThreadPool::LaneMetrics ThreadPool::GetMetrics(TaskPriority priority) const {
+    const LaneStats& stats = stats_[static_cast<size_t>(priority)];
+    LaneMetrics metrics;
+    metrics.queueDepth = stats.depth.load();
+    metrics.maxQueueDepth = stats.maxDepth.load();
+    metrics.submitted = stats.submitted.load();
+    metrics.completed = stats.completed.load();
+
+    uint64_t started = metrics.submitted - metrics.queueDepth;
+    if (started > 0) {
+        metrics.avgWaitMs = stats.totalWaitUs.load() / 1000.0 / started;
+    }
+    metrics.maxWaitMs = stats.maxWaitUs.load() / 1000.0;
+    if (metrics.completed > 0) {
+        metrics.avgRunMs = stats.totalRunUs.load() / 1000.0 / metrics.completed;
+    }
+    return metrics;
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    tCurrentPool = this;
+    tCurrentWorker = index;
+
+    for (;;) {
+        QueuedTask task;
+        size_t lane;
+        if (TakeTask(index, task, lane)) {
+            RunTask(task, lane);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        const std::atomic<size_t>& pending = IsReserved(index) ? pendingBackground_ : pending_;
+        wake_.wait(lock, [this, &pending]() { return pending > 0 || stopping_; });
+        if (stopping_ && pending == 0) return;
+    }
+}
+
+bool ThreadPool::TakeTask(size_t index, QueuedTask& task, size_t& lane) {
+    size_t firstLane = IsReserved(index) ? static_cast<size_t>(TaskPriority::Background) : 0;
+    for (lane = firstLane; lane < kLaneCount; ++lane) {
+        // Own work comes off the front so a worker's queue stays in submission order
+        {
+            Worker& own = *workers_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.lanes[lane].empty()) {
+                task = std::move(own.lanes[lane].front());
+                own.lanes[lane].pop_front();
+                pending_--;
+                if (lane == static_cast<size_t>(TaskPriority::Background)) pendingBackground_--;
+                return true;
+            }
+        }
+
+        // Steal the newest task from the first busy neighbour
+        for (size_t offset = 1; offset < workers_.size(); ++offset) {
+            Worker& victim = *workers_[(index + offset) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.lanes[lane].empty()) {
+                task = std::move(victim.lanes[lane].back());
+                victim.lanes[lane].pop_back();
+                pending_--;
+                if (lane == static_cast<size_t>(TaskPriority::Background)) pendingBackground_--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(QueuedTask& task, size_t lane) {
+    LaneStats& stats = stats_[lane];
+    stats.depth--;
+
+    auto started = std::chrono::steady_clock::now();
+    uint64_t waitUs = MicrosBetween(task.queuedAt, started);
+    stats.totalWaitUs += waitUs;
+    UpdateMax(stats.maxWaitUs, waitUs);
+
+    try {
+        task.task();
+    } catch (...) {
+        // A failing task must not take the worker down with it
+    }
+
+    stats.totalRunUs += MicrosBetween(started, std::chrono::steady_clock::now());
+    stats.completed++;
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,406 @@
+#include "common/utf8_sanitizer.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEUROSHELL_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled per function and picked at runtime, so the binary still runs on older CPUs
+#if defined(NEUROSHELL_HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEUROSHELL_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace NeuroShell {
+
+namespace {
+
+const char kReplacement[] = "\xEF\xBF\xBD";     // U+FFFD
+
+// Binary once this many suspicious bytes make up over an eighth of the sniffed ones
+constexpr size_t kMinSuspect = 32;
+
+// Plain bytes go through untouched: printable ASCII, tab, newline, and the
+// controls kept on purpose (rendering skips \r, AnsiParser consumes BEL and ESC)
+struct PlainTable {
+    bool plain[256];
+
+    constexpr PlainTable() : plain() {
+        for (int c = 0; c < 256; ++c) {
+            plain[c] = (c >= 0x20 && c < 0x7F) || c == '\n' || c == '\t' || c == '\r' || c == 0x07 || c == 0x1B;
+        }
+    }
+};
+
+constexpr PlainTable kPlainTable;
+
+inline bool IsPlain(uint8_t c) {
+    return kPlainTable.plain[c];
+}
+
+// The scalar walk hands back to the vector scan after this many plain bytes in a row
+constexpr size_t kPlainRunToScan = 16;
+
+// Total length of the sequence led by c, or 0 if c can't start one
+inline size_t SequenceLength(uint8_t c) {
+    if (c >= 0xC2 && c <= 0xDF) return 2;
+    if (c >= 0xE0 && c <= 0xEF) return 3;
+    if (c >= 0xF0 && c <= 0xF4) return 4;
+    return 0;
+}
+
+// Bytes of p[0..have) that are a valid start of a sequence (at least 1).
+// The second byte's range excludes overlongs, surrogates and code points
+// past U+10FFFF (Unicode table 3-7).
+size_t ValidPrefix(const uint8_t* p, size_t have) {
+    if (have < 2) return 1;
+    uint8_t lo = 0x80;
+    uint8_t hi = 0xBF;
+    if (p[0] == 0xE0) lo = 0xA0;
+    else if (p[0] == 0xED) hi = 0x9F;
+    else if (p[0] == 0xF0) lo = 0x90;
+    else if (p[0] == 0xF4) hi = 0x8F;
+    if (p[1] < lo || p[1] > hi) return 1;
+
+    size_t i = 2;
+    while (i < have && p[i] >= 0x80 && p[i] <= 0xBF) ++i;
+    return i;
+}
+
+inline unsigned CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+size_t ScanScalar(const uint8_t* data, size_t size) {
+    // Eight bytes at a time; a word that has a byte with the high bit set, below
+    // 0x20 or DEL is settled byte by byte and the word loop goes on if it was tabs and such
+    const uint64_t high = 0x8080808080808080ULL;
+    const uint64_t ones = 0x0101010101010101ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        uint64_t below = (word - ones * 0x20) & ~word;
+        uint64_t del = word ^ (ones * 0x7F);
+        del = (del - ones) & ~del;
+        if ((word | below | del) & high) {
+            for (size_t k = 0; k < 8; ++k) {
+                if (!IsPlain(data[i + k])) return i + k;
+            }
+        }
+    }
+    while (i < size && IsPlain(data[i])) ++i;
+    return i;
+}
+
+#ifdef NEUROSHELL_HAVE_SSE2
+inline uint32_t NotPlainMask(__m128i v) {
+    // Signed compare: bytes 0x80 and up are negative, so "below 0x20" also catches non-ASCII
+    __m128i bad = _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x20)), _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+    __m128i allowed = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    allowed = _mm_or_si128(allowed, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    allowed = _mm_or_si128(allowed, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x07)));
+    allowed = _mm_or_si128(allowed, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x1B)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_andnot_si128(allowed, bad)));
+}
+
+// Plain ASCII only: SSE2 has no byte shuffle for the table lookups below
+size_t ScanSse2(const uint8_t* data, size_t size) {
+    size_t i = 0;
+    // 64 bytes per iteration with a single branch; locate the byte only on a hit
+    for (; i + 64 <= size; i += 64) {
+        uint32_t m0 = NotPlainMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        uint32_t m1 = NotPlainMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)));
+        uint32_t m2 = NotPlainMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32)));
+        uint32_t m3 = NotPlainMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48)));
+        if (m0 | m1 | m2 | m3) {
+            if (m0) return i + CountTrailingZeros(m0);
+            if (m1) return i + 16 + CountTrailingZeros(m1);
+            if (m2) return i + 32 + CountTrailingZeros(m2);
+            return i + 48 + CountTrailingZeros(m3);
+        }
+    }
+    for (; i + 16 <= size; i += 16) {
+        uint32_t mask = NotPlainMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        if (mask) return i + CountTrailingZeros(mask);
+    }
+    return i + ScanScalar(data + i, size - i);
+}
+#endif
+
+#ifdef NEUROSHELL_HAVE_AVX2
+// Full UTF-8 validation in the style of Keiser and Lemire, "Validating UTF-8
+// in less than one instruction per byte": three 16-entry lookups on the
+// nibbles of each byte and the one before it flag every bad two-byte pair,
+// and a comparison against the bytes two and three back checks that 3- and
+// 4-byte sequences get all their continuations.
+constexpr uint8_t kTooShort = 1 << 0;       // Lead not followed by a continuation
+constexpr uint8_t kTooLong = 1 << 1;        // ASCII followed by a continuation
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;       // Past U+10FFFF
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;       // Fine only as the 3rd or 4th byte
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+#define NEUROSHELL_TABLE16(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+__attribute__((target("avx2"))) inline __m256i HighNibbles(__m256i v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+// Bytes of (previous block, input) shifted so each lane sees the byte `back` before it
+template <int back>
+__attribute__((target("avx2"))) inline __m256i Previous(__m256i input, __m256i previous) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - back);
+}
+
+__attribute__((target("avx2"))) __m256i Utf8Errors(__m256i input, __m256i previous) {
+    const __m256i byte1HighTable = NEUROSHELL_TABLE16(
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+    const __m256i byte1LowTable = NEUROSHELL_TABLE16(
+        kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+        kCarry | kOverlong2,
+        kCarry,
+        kCarry,
+        kCarry | kTooLarge,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+        kCarry | kTooLarge | kTooLarge1000,
+        kCarry | kTooLarge | kTooLarge1000);
+    const __m256i byte2HighTable = NEUROSHELL_TABLE16(
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+        kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+        kTooShort, kTooShort, kTooShort, kTooShort);
+
+    __m256i prev1 = Previous<1>(input, previous);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(byte1HighTable, HighNibbles(prev1)),
+                         _mm256_shuffle_epi8(byte1LowTable, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+        _mm256_shuffle_epi8(byte2HighTable, HighNibbles(input)));
+
+    // A byte two after a 3/4-byte lead, or three after a 4-byte lead, must be a continuation
+    __m256i third = _mm256_subs_epu8(Previous<2>(input, previous), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(Previous<3>(input, previous), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(mustContinue, special);
+}
+
+// Nonzero lanes hold control characters that get dropped (DEL included)
+__attribute__((target("avx2"))) inline __m256i DroppedControls(__m256i input) {
+    // Rows 0x0_ and 0x1_ by high nibble; for each low nibble, the rows where it is dropped
+    const __m256i rowTable = NEUROSHELL_TABLE16(1, 2, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i columnTable = NEUROSHELL_TABLE16(3, 3, 3, 3, 3, 3, 3, 2, 3, 2, 2, 1, 3, 2, 3, 3 | 4);
+    return _mm256_and_si256(_mm256_shuffle_epi8(rowTable, HighNibbles(input)),
+                            _mm256_shuffle_epi8(columnTable, _mm256_and_si256(input, _mm256_set1_epi8(0x0F))));
+}
+
+__attribute__((target("avx2"))) size_t ScanAvx2(const uint8_t* data, size_t size) {
+    // Set where the last bytes of a block start a sequence the block doesn't finish
+    const __m256i unfinished = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        __m256i bad = _mm256_or_si256(DroppedControls(in0), DroppedControls(in1));
+        if (_mm256_movemask_epi8(_mm256_or_si256(in0, in1)) == 0) {
+            // All ASCII: only a sequence left open by the previous block is wrong
+            bad = _mm256_or_si256(bad, incomplete);
+            incomplete = _mm256_setzero_si256();
+        } else {
+            bad = _mm256_or_si256(bad, _mm256_or_si256(Utf8Errors(in0, previous), Utf8Errors(in1, in0)));
+            incomplete = _mm256_subs_epu8(in1, unfinished);
+        }
+        if (!_mm256_testz_si256(bad, bad)) break;
+        previous = in1;
+    }
+
+    // Everything before i is clean except possibly its last character, which
+    // may continue into the block that failed or wasn't checked: stop before it
+    size_t end = i;
+    while (end > 0 && i - end < 3 && (data[end - 1] & 0xC0) == 0x80) --end;
+    if (end > 0 && data[end - 1] >= 0xC0) --end;
+    return end;
+}
+
+#undef NEUROSHELL_TABLE16
+#endif
+
+} // namespace
+
+Utf8Sanitizer::Utf8Sanitizer(SimdLevel level)
+    : level_(std::min(level, BestLevel()))
+    , scan_(ScanScalar)
+    , pendingSize_(0)
+    , bytesSeen_(0)
+    , invalid_(0)
+    , dropped_(0)
+    , sniffNuls_(0)
+    , sniffSuspect_(0)
+{
+#ifdef NEUROSHELL_HAVE_SSE2
+    if (level_ == SimdLevel::Sse2) scan_ = ScanSse2;
+#endif
+#ifdef NEUROSHELL_HAVE_AVX2
+    if (level_ == SimdLevel::Avx2) scan_ = ScanAvx2;
+#endif
+}
+
+SimdLevel Utf8Sanitizer::BestLevel() {
+#if defined(NEUROSHELL_HAVE_AVX2)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2 ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#elif defined(NEUROSHELL_HAVE_SSE2)
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* Utf8Sanitizer::LevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Avx2: return "avx2";
+    case SimdLevel::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+void Utf8Sanitizer::NoteSuspect(size_t position, bool nul) {
+    if (position >= kSniffBytes) return;
+    if (nul) ++sniffNuls_;
+    ++sniffSuspect_;
+}
+
+bool Utf8Sanitizer::LooksBinary() const {
+    size_t sniffed = std::min(bytesSeen_, kSniffBytes);
+    return sniffNuls_ > 0 || (sniffSuspect_ >= kMinSuspect && sniffSuspect_ * 8 > sniffed);
+}
+
+void Utf8Sanitizer::Feed(const char* data, size_t size, std::string& out) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = begin + size;
+    const uint8_t* p = begin;
+    size_t base = bytesSeen_;
+    bytesSeen_ += size;
+
+    // Complete the sequence the last chunk ended in the middle of
+    if (pendingSize_ > 0) {
+        size_t need = SequenceLength(pending_[0]);
+        while (pendingSize_ < need && p < end) {
+            pending_[pendingSize_++] = *p++;
+            if (ValidPrefix(pending_, pendingSize_) < pendingSize_) {
+                // The byte just taken doesn't continue it; it is looked at again below
+                --p;
+                pendingSize_ = 0;
+                out += kReplacement;
+                ++invalid_;
+                NoteSuspect(base + (p - begin), false);
+                break;
+            }
+        }
+        if (pendingSize_ == need) {
+            out.append(reinterpret_cast<const char*>(pending_), need);
+            pendingSize_ = 0;
+        }
+        if (pendingSize_ > 0) return;
+    }
+
+    out.reserve(out.size() + (end - p));
+
+    // Valid bytes are copied in one go when something has to be dropped or replaced
+    const uint8_t* copyFrom = p;
+    auto flush = [&](const uint8_t* upTo) {
+        out.append(reinterpret_cast<const char*>(copyFrom), upTo - copyFrom);
+    };
+
+    while (p < end) {
+        p += scan_(p, end - p);
+
+        // Walk byte by byte until plain bytes take over again
+        size_t plainRun = 0;
+        while (p < end && plainRun < kPlainRunToScan) {
+            uint8_t c = *p;
+            if (IsPlain(c)) {
+                ++plainRun;
+                ++p;
+                continue;
+            }
+            plainRun = 0;
+            if (c < 0x80) {
+                flush(p);
+                copyFrom = p + 1;
+                ++dropped_;
+                NoteSuspect(base + (p - begin), c == 0);
+                ++p;
+                continue;
+            }
+
+            size_t need = SequenceLength(c);
+            size_t have = std::min<size_t>(need, end - p);
+            size_t valid = need == 0 ? 1 : ValidPrefix(p, have);
+            if (need > 0 && valid == need) {
+                p += need;
+                continue;
+            }
+            flush(p);
+            if (need > 0 && valid == have) {
+                // Cut off by the end of the chunk
+                std::memcpy(pending_, p, have);
+                pendingSize_ = have;
+                p = end;
+            } else {
+                out.append(kReplacement, 3);
+                ++invalid_;
+                NoteSuspect(base + (p - begin), false);
+                p += valid;
+            }
+            copyFrom = p;
+        }
+    }
+    flush(end);
+}
+
+void Utf8Sanitizer::Finish(std::string& out) {
+    if (pendingSize_ > 0) {
+        out += kReplacement;
+        ++invalid_;
+        pendingSize_ = 0;
+    }
+}
+
+} // namespace NeuroShell
@@ -1,6 +1,8 @@
 #include "executor/command_executor.h"
 #include "utils/logger.h"
 #include "utils/safety.h"
+#include "terminal/output_capture.h"
+#include "terminal/process.h"
 #include <iostream>
 #include <chrono>
 #include <array>
@@ -82,7 +84,7 @@ ExecutionResult CommandExecutor::execute(const nlp::MappedCommand& mapped_cmd, b
     
     // Execute command
     LOG_INFO("Executing: " + full_command);
-    result = executeSystemCommand(full_command);
+    result = executeSystemCommand(full_command, mapped_cmd.timeout_seconds);
     
     if (result.success) {
         LOG_INFO("Command completed successfully");
@@ -109,13 +111,17 @@ std::string CommandExecutor::getLastCommand() const {
     return last_command_;
 }
 
-ExecutionResult CommandExecutor::executeSystemCommand(const std::string& command) {
+ExecutionResult CommandExecutor::executeSystemCommand(const std::string& command, int timeout_seconds) {
     ExecutionResult result;
     auto start_time = std::chrono::high_resolution_clock::now();
     
+    std::string output;
+    std::string error_output;
+    int exit_code = -1;
+    
+#ifdef _WIN32
     // Execute command and capture output
     std::array<char, 128> buffer;
-    std::string output;
     
     FILE* pipe = popen(command.c_str(), "r");
     if (!pipe) {
@@ -128,17 +134,46 @@ ExecutionResult CommandExecutor::executeSystemCommand(const std::string& command
         output += buffer.data();
     }
     
-    int exit_code = pclose(pipe);
+    exit_code = pclose(pipe);
+#else
+    // Capture stdout and stderr on separate pipes so neither is lost
+    NeuroShell::CancelToken deadline;
+    deadline.SetTimeout(timeout_seconds);
+    try {
+        NeuroShell::ChildProcess child = NeuroShell::SpawnCommand(command, NeuroShell::WorkingDirectory());
+        NeuroShell::OutputCapture::Drain(child,
+            [&output, &error_output](NeuroShell::OutputStream stream, const char* data, size_t size) {
+                if (stream == NeuroShell::OutputStream::Stderr) {
+                    error_output.append(data, size);
+                } else {
+                    output.append(data, size);
+                }
+            }, &deadline);
+        exit_code = NeuroShell::WaitForExit(child, &deadline).exitCode;
+        result.timed_out = deadline.TimedOut();
+    } catch (const std::exception& e) {
+        result.error = e.what();
+        result.success = false;
+        return result;
+    }
+#endif
     
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
     
     result.output = output;
+    result.error = error_output;
     result.exit_code = exit_code;
     result.success = (exit_code == 0);
     result.execution_time = elapsed.count();
     
-    if (!result.success) {
+    if (result.timed_out) {
+        // On a line of its own, after whatever the command wrote to stderr
+        if (!result.error.empty() && result.error.back() != '\n') {
+            result.error += '\n';
+        }
+        result.error += "Command timed out after " + std::to_string(timeout_seconds) + "s";
+    } else if (!result.success && result.error.empty()) {
         result.error = "Command exited with code " + std::to_string(exit_code);
     }
     
@@ -1,9 +1,13 @@
 #include "ui/ui.h"
+#include "utils/config_loader.h"
+#include "terminal/spawn_zygote.h"
 #include <iostream>
 #include <exception>
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/resource.h>
 #endif
 
 void PrintBanner() {
@@ -31,6 +35,21 @@ int main(int argc, char** argv) {
             SetConsoleMode(hConsole, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
         }
     }
+#else
+    // The spawn helper has to fork now, before the UI allocates anything
+    neuroshell::utils::ConfigLoader config;
+    config.load("config/neuroshell.conf");
+    if (config.getBool("spawn_helper", false) && !NeuroShell::SpawnZygote::Start()) {
+        std::cerr << "Spawn helper unavailable, spawning directly" << std::endl;
+    }
+    
+    // Every running command holds two pipes and a pidfd in the reactor; the
+    // usual soft limit of 1024 descriptors would cap that at a few hundred
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < 4096 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max < 4096 ? files.rlim_max : 4096;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
 #endif
 
     try {
@@ -56,6 +75,9 @@ int main(int argc, char** argv) {
         std::cout << "Shutting down..." << std::endl;
         // Cleanup
         app.Shutdown();
+#ifndef _WIN32
+        NeuroShell::SpawnZygote::Stop();
+#endif
         
         std::cout << "Exit successful" << std::endl;
         return 0;
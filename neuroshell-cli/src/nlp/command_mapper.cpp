@@ -31,12 +31,14 @@ MappedCommand CommandMapper::mapToCommand(const ParsedIntent& intent) {
         
         result.requires_confirmation = tmpl.requires_confirmation;
         result.is_dangerous = tmpl.is_dangerous;
+        result.timeout_seconds = tmpl.timeout_seconds;
         result.description = intent.original_input;
     } else {
         // Unknown command
         result.command = "";
         result.requires_confirmation = true;
         result.is_dangerous = false;
+        result.timeout_seconds = 0;
         result.description = "Unknown command: " + intent.original_input;
         result.confidence = 0.0f;
     }
@@ -74,7 +76,7 @@ void CommandMapper::initializeDefaultMappings() {
         "dir /s",
         "ls -laR",
         "ls -laR",
-        false, false, {}
+        false, false, {}, 60
     };
     
     // Create folder
@@ -122,7 +124,7 @@ void CommandMapper::initializeDefaultMappings() {
         "tasklist",
         "ps aux",
         "ps aux",
-        false, false, {}
+        false, false, {}, 10
     };
     
     // Stop process
@@ -138,7 +140,7 @@ void CommandMapper::initializeDefaultMappings() {
         "ipconfig",
         "ifconfig",
         "ifconfig",
-        false, false, {}
+        false, false, {}, 10
     };
     
     // System info
@@ -146,7 +148,7 @@ void CommandMapper::initializeDefaultMappings() {
         "systeminfo",
         "uname -a",
         "uname -a",
-        false, false, {}
+        false, false, {}, 10
     };
     
     // Current directory
@@ -0,0 +1,150 @@
+#include "terminal/cancel_token.h"
+#include <algorithm>
+#include <climits>
+#include <csignal>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace NeuroShell {
+
+namespace {
+
+#ifdef _WIN32
+// Windows has no SIGKILL; TerminateProcess plays that role
+constexpr int kKillSignal = 9;
+#else
+constexpr int kKillSignal = SIGKILL;
+#endif
+
+int MillisUntil(std::chrono::steady_clock::time_point when) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(when - std::chrono::steady_clock::now()).count();
+    return static_cast<int>(std::max<long long>(1, std::min<long long>(remaining, INT_MAX)));
+}
+
+} // namespace
+
+CancelToken::CancelToken()
+    : timeoutSeconds_(0.0)
+    , interruptGraceMs_(2000)
+    , terminateGraceMs_(3000)
+    , stage_(0)
+    , processGroup_(0)
+    , hasDeadline_(false)
+    , cancelled_(false)
+    , timedOut_(false)
+{
+    wakeFds_[0] = wakeFds_[1] = -1;
+#ifndef _WIN32
+    if (pipe(wakeFds_) == 0) {
+        for (int fd : wakeFds_) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+        }
+    } else {
+        wakeFds_[0] = wakeFds_[1] = -1;
+    }
+#endif
+}
+
+CancelToken::~CancelToken() {
+#ifndef _WIN32
+    if (wakeFds_[0] >= 0) close(wakeFds_[0]);
+    if (wakeFds_[1] >= 0) close(wakeFds_[1]);
+#endif
+}
+
+void CancelToken::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) return;
+        cancelled_ = true;
+    }
+#ifndef _WIN32
+    if (wakeFds_[1] >= 0) {
+        char byte = 1;
+        ssize_t written = write(wakeFds_[1], &byte, 1);
+        (void)written;
+    }
+#endif
+}
+
+void CancelToken::SetTimeout(double seconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeoutSeconds_ = seconds;
+    hasDeadline_ = seconds > 0.0;
+    if (hasDeadline_) {
+        deadline_ = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    }
+}
+
+void CancelToken::SetStopSchedule(int interruptGraceMs, int terminateGraceMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interruptGraceMs_ = std::max(0, interruptGraceMs);
+    terminateGraceMs_ = std::max(0, terminateGraceMs);
+}
+
+bool CancelToken::IsCancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_ || (hasDeadline_ && std::chrono::steady_clock::now() >= deadline_);
+}
+
+bool CancelToken::TimedOut() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timedOut_;
+}
+
+int CancelToken::Advance(const SignalFn& sendSignal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+
+    if (!cancelled_ && hasDeadline_ && now >= deadline_) {
+        cancelled_ = true;
+        timedOut_ = true;
+    }
+
+    if (!cancelled_) {
+        return hasDeadline_ ? MillisUntil(deadline_) : -1;
+    }
+
+    if (stage_ == 0) {
+        stage_ = 1;
+        sendSignal(SIGINT);
+        nextStep_ = now + std::chrono::milliseconds(interruptGraceMs_);
+    } else if (stage_ == 1 && now >= nextStep_) {
+        stage_ = 2;
+        sendSignal(SIGTERM);
+        nextStep_ = now + std::chrono::milliseconds(terminateGraceMs_);
+    } else if (stage_ == 2 && now >= nextStep_) {
+        stage_ = 3;
+        sendSignal(kKillSignal);
+    }
+
+    return stage_ < 3 ? MillisUntil(nextStep_) : -1;
+}
+
+void CancelToken::Attach(int processGroup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    processGroup_ = processGroup;
+}
+
+void CancelToken::Detach() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    processGroup_ = 0;
+}
+
+bool CancelToken::Signal(int signal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (processGroup_ <= 0) return false;
+#ifdef _WIN32
+    (void)signal;
+    return false;
+#else
+    return killpg(processGroup_, signal) == 0;
+#endif
+}
+
+} // namespace NeuroShell
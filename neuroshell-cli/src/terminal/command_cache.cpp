@@ -0,0 +1,221 @@
+#include "terminal/command_cache.h"
+#include "terminal/command_lexer.h"
+#include <filesystem>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace NeuroShell {
+
+namespace {
+
+// Directories with more entries than this cost more to fingerprint than to list
+constexpr size_t kMaxDirEntries = 4096;
+
+// Even with an unchanged fingerprint, rerun after this long (hostname, uname...)
+constexpr auto kMaxAge = std::chrono::minutes(5);
+
+// Cacheable programs that read no files; the working directory alone keys them
+const std::unordered_set<std::string> kNoFiles = {
+    "pwd", "whoami", "hostname", "uname", "systeminfo"
+};
+
+// FNV-1a, folded over metadata as it is collected
+void Fold(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+void Fold(uint64_t& hash, const std::string& text) {
+    Fold(hash, text.data(), text.size() + 1);    // Keep the terminator so "ab","c" != "a","bc"
+}
+
+void Fold(uint64_t& hash, int64_t value) {
+    Fold(hash, &value, sizeof(value));
+}
+
+// Type, mtime and size of one file; the caller folds its name
+void FoldStatus(uint64_t& hash, const fs::directory_entry& entry) {
+    std::error_code ec;
+    fs::file_status status = entry.symlink_status(ec);
+    Fold(hash, static_cast<int64_t>(status.type()));
+    Fold(hash, static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count()));
+    if (status.type() == fs::file_type::regular) {
+        Fold(hash, static_cast<int64_t>(entry.file_size(ec)));
+    }
+}
+
+} // namespace
+
+CommandCache::CommandCache()
+    : capacity_(50)
+    , enabled_(true)
+{
+}
+
+void CommandCache::SetEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    if (!enabled_) {
+        entries_.clear();
+        index_.clear();
+    }
+}
+
+bool CommandCache::IsEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+void CommandCache::SetCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
+
+CommandCache::Ticket CommandCache::Prepare(const std::string& command, const std::string& workingDir) const {
+    Ticket ticket;
+    if (!IsEnabled() || !safety_.isCacheable(command)) {
+        return ticket;
+    }
+
+    // Only plain words: anything the shell would expand could read more than we see
+    std::vector<std::string> argv;
+    if (!CommandLexer::SplitSimple(command, argv) || argv.empty()) {
+        return ticket;
+    }
+    if (!Fingerprint(argv, workingDir, ticket.fingerprint)) {
+        return ticket;
+    }
+
+    ticket.key = Key(argv, workingDir);
+    ticket.cacheable = true;
+    return ticket;
+}
+
+bool CommandCache::Lookup(const Ticket& ticket, CachedResult& result) {
+    if (!ticket.cacheable) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(ticket.key);
+    if (it == index_.end()) {
+        stats_.misses++;
+        return false;
+    }
+
+    Entry& entry = *it->second;
+    if (entry.fingerprint != ticket.fingerprint ||
+        std::chrono::steady_clock::now() - entry.storedAt > kMaxAge) {
+        stats_.invalidations++;
+        stats_.misses++;
+        entries_.erase(it->second);
+        index_.erase(it);
+        return false;
+    }
+
+    entries_.splice(entries_.begin(), entries_, it->second);
+    result = entry.result;
+    stats_.hits++;
+    return true;
+}
+
+void CommandCache::Store(const Ticket& ticket, const CommandBlock& block) {
+    if (!ticket.cacheable || block.status != CommandStatus::Success) return;
+    if (block.output.SpilledBytes() > 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || capacity_ == 0) return;
+
+    auto existing = index_.find(ticket.key);
+    if (existing != index_.end()) {
+        entries_.erase(existing->second);
+        index_.erase(existing);
+    }
+
+    Entry entry;
+    entry.key = ticket.key;
+    entry.fingerprint = ticket.fingerprint;
+    entry.storedAt = std::chrono::steady_clock::now();
+    entry.result.output = block.output.Str();
+    entry.result.segments = block.segments;
+    entry.result.styles = block.styles;
+    entry.result.lines = block.lines;
+    entry.result.binaryBytes = block.binaryBytes;
+    entry.result.exitCode = block.exitCode;
+    entries_.push_front(std::move(entry));
+    index_[ticket.key] = entries_.begin();
+
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+}
+
+void CommandCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+CommandCache::Stats CommandCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.entries = entries_.size();
+    return stats;
+}
+
+std::string CommandCache::Key(const std::vector<std::string>& argv, const std::string& workingDir) {
+    // Normalized: quoting and spacing removed, words joined by NUL
+    std::string key = workingDir;
+    for (const auto& word : argv) {
+        key += '\0';
+        key += word;
+    }
+    return key;
+}
+
+bool CommandCache::Fingerprint(const std::vector<std::string>& argv, const std::string& workingDir,
+                               uint64_t& fingerprint) {
+    fingerprint = 14695981039346656037ULL;
+    if (kNoFiles.count(argv[0])) {
+        return true;
+    }
+
+    // The working directory is always read (ls with no arguments, relative paths)
+    std::vector<fs::path> paths = { fs::path(workingDir) };
+    for (size_t i = 1; i < argv.size(); ++i) {
+        if (argv[i].empty() || argv[i][0] == '-') continue;
+        fs::path path(argv[i]);
+        paths.push_back(path.is_absolute() ? path : fs::path(workingDir) / path);
+    }
+
+    std::error_code ec;
+    for (const auto& path : paths) {
+        Fold(fingerprint, path.string());
+        fs::directory_entry target(path, ec);
+        if (ec || !target.exists(ec)) {
+            Fold(fingerprint, int64_t(-1));
+            continue;
+        }
+        FoldStatus(fingerprint, target);
+        if (!target.is_directory(ec)) continue;
+
+        // A directory's own mtime misses writes to its files, so fold each entry
+        size_t count = 0;
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            if (++count > kMaxDirEntries) return false;
+            Fold(fingerprint, it->path().filename().string());
+            FoldStatus(fingerprint, *it);
+        }
+        if (ec) return false;
+    }
+    return true;
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,222 @@
+#include "terminal/command_cgroup.h"
+#include <algorithm>
+#include <cmath>
+
+namespace NeuroShell {
+
+int NiceForWeight(int cpuWeight) {
+    if (cpuWeight <= 0 || cpuWeight >= 100) return 0;
+    int nice = static_cast<int>(std::lround(std::log(100.0 / cpuWeight) / std::log(1.25)));
+    return std::min(19, std::max(0, nice));
+}
+
+} // namespace NeuroShell
+
+#ifdef __linux__
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cerrno>
+
+namespace NeuroShell {
+
+namespace {
+
+const char* const kCgroupRoot = "/sys/fs/cgroup";
+
+// Our place in the hierarchy once it has been prepared for command leaves
+struct CgroupBase {
+    std::mutex mutex;
+    bool checked = false;
+    bool usable = false;
+    std::string path;                       // NeuroShell's own cgroup, now interior
+    std::vector<std::string> leftovers;     // Leaves still busy when their command ended
+    std::atomic<uint64_t> nextLeaf{1};
+};
+
+CgroupBase& Base() {
+    static CgroupBase base;
+    return base;
+}
+
+bool WriteFile(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return ok;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// "0::/user.slice/..." from /proc/self/cgroup; empty on a pure v1 system
+std::string OwnCgroup() {
+    std::istringstream lines(ReadFile("/proc/self/cgroup"));
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            return std::string(kCgroupRoot) + line.substr(3);
+        }
+    }
+    return "";
+}
+
+// Turn our cgroup into an interior node: processes can only live in leaves
+// once controllers are enabled for children
+bool PrepareBase(CgroupBase& base) {
+    std::string own = OwnCgroup();
+    if (own.empty() || access((own + "/cgroup.procs").c_str(), W_OK) != 0) {
+        return false;
+    }
+
+    std::string controllers = ReadFile(own + "/cgroup.controllers");
+    for (const char* needed : { "cpu", "memory", "pids" }) {
+        std::istringstream words(controllers);
+        std::string word;
+        bool found = false;
+        while (words >> word) found = found || word == needed;
+        if (!found) return false;
+    }
+
+    std::string uiLeaf = own + "/ui";
+    if (mkdir(uiLeaf.c_str(), 0755) != 0 && errno != EEXIST) return false;
+
+    // Only we move; if anything else shares the cgroup it isn't delegated to us,
+    // and enabling controllers below fails because the cgroup still has members
+    if (!WriteFile(uiLeaf + "/cgroup.procs", "0")) return false;
+    if (!WriteFile(own + "/cgroup.subtree_control", "+cpu +memory +pids")) {
+        return false;
+    }
+
+    base.path = own;
+    return true;
+}
+
+uint64_t StatValue(const std::string& text, const std::string& key) {
+    std::istringstream lines(text);
+    std::string name;
+    uint64_t value;
+    while (lines >> name >> value) {
+        if (name == key) return value;
+    }
+    return 0;
+}
+
+} // namespace
+
+bool CommandCgroup::IsAvailable() {
+    CgroupBase& base = Base();
+    std::lock_guard<std::mutex> lock(base.mutex);
+    if (!base.checked) {
+        base.checked = true;
+        base.usable = PrepareBase(base);
+    }
+    return base.usable;
+}
+
+std::unique_ptr<CommandCgroup> CommandCgroup::Create(const ResourceLimits& limits) {
+    if (!IsAvailable()) return nullptr;
+
+    CgroupBase& base = Base();
+    {
+        // Leaves whose background processes have since exited can go now
+        std::lock_guard<std::mutex> lock(base.mutex);
+        base.leftovers.erase(std::remove_if(base.leftovers.begin(), base.leftovers.end(),
+            [](const std::string& path) { return rmdir(path.c_str()) == 0 || errno == ENOENT; }),
+            base.leftovers.end());
+    }
+
+    std::string path = base.path + "/cmd-" + std::to_string(getpid()) + "-" + std::to_string(base.nextLeaf++);
+    if (mkdir(path.c_str(), 0755) != 0) return nullptr;
+
+    bool ok = true;
+    if (limits.cpuWeight > 0) {
+        ok = ok && WriteFile(path + "/cpu.weight", std::to_string(std::min(10000, limits.cpuWeight)));
+    }
+    if (limits.memoryMaxBytes > 0) {
+        ok = ok && WriteFile(path + "/memory.max", std::to_string(limits.memoryMaxBytes));
+        // Don't let the limit push the command into swap instead of stopping it
+        WriteFile(path + "/memory.swap.max", "0");
+    }
+    if (limits.pidsMax > 0) {
+        ok = ok && WriteFile(path + "/pids.max", std::to_string(limits.pidsMax));
+    }
+
+    int procsFd = ok ? open((path + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC) : -1;
+    if (procsFd < 0) {
+        rmdir(path.c_str());
+        return nullptr;
+    }
+    return std::unique_ptr<CommandCgroup>(new CommandCgroup(path, procsFd));
+}
+
+CommandCgroup::CommandCgroup(const std::string& path, int procsFd)
+    : path_(path)
+    , procsFd_(procsFd)
+{
+}
+
+CommandCgroup::~CommandCgroup() {
+    close(procsFd_);
+
+    // Processes the command left running in the background keep the leaf alive
+    if (rmdir(path_.c_str()) != 0 && errno == EBUSY) {
+        CgroupBase& base = Base();
+        std::lock_guard<std::mutex> lock(base.mutex);
+        base.leftovers.push_back(path_);
+    }
+}
+
+void CommandCgroup::ReadUsage(ResourceUsage& usage) const {
+    std::string cpu = ReadFile(path_ + "/cpu.stat");
+    if (!cpu.empty()) {
+        usage.userCpuSeconds = StatValue(cpu, "user_usec") / 1e6;
+        usage.systemCpuSeconds = StatValue(cpu, "system_usec") / 1e6;
+    }
+
+    // memory.peak needs Linux 6.1; keep wait4's figure without it
+    std::string peak = ReadFile(path_ + "/memory.peak");
+    if (!peak.empty()) {
+        usage.maxRssKb = static_cast<long>(std::stoull(peak) / 1024);
+    }
+}
+
+} // namespace NeuroShell
+
+#else
+
+namespace NeuroShell {
+
+bool CommandCgroup::IsAvailable() {
+    return false;
+}
+
+std::unique_ptr<CommandCgroup> CommandCgroup::Create(const ResourceLimits&) {
+    return nullptr;
+}
+
+CommandCgroup::CommandCgroup(const std::string& path, int procsFd)
+    : path_(path)
+    , procsFd_(procsFd)
+{
+}
+
+CommandCgroup::~CommandCgroup() = default;
+
+void CommandCgroup::ReadUsage(ResourceUsage&) const {
+}
+
+} // namespace NeuroShell
+
+#endif // __linux__
@@ -1,14 +1,20 @@
 #include "terminal/command_executor.h"
+#include "terminal/output_capture.h"
+#include "terminal/process.h"
+#include "terminal/process_reactor.h"
+#include "terminal/native_builtins.h"
+#include "common/thread_pool.h"
 #include <cstdlib>
 #include <sstream>
 #include <algorithm>
-#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <chrono>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
-#define getcwd _getcwd
-#define chdir _chdir
+#include <io.h>
 #else
 #include <unistd.h>
 #include <sys/wait.h>
@@ -17,13 +23,20 @@
 
 namespace NeuroShell {
 
-CommandExecutor::CommandExecutor()
-    : isRunning_(false)
 #ifdef _WIN32
-    , processHandle_(nullptr)
-#else
-    , processId_(-1)
+namespace {
+
+// Large enough to drain a full pipe buffer in one read
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+} // namespace
 #endif
+
+CommandExecutor::CommandExecutor()
+    : runningCommands_(0)
+    , interruptGraceMs_(2000)
+    , terminateGraceMs_(3000)
+    , defaultTimeout_(0.0)
 {
     InitializeWorkingDirectory();
 }
@@ -33,26 +46,32 @@ CommandExecutor::~CommandExecutor() {
 }
 
 void CommandExecutor::InitializeWorkingDirectory() {
-    char buffer[1024];
-    if (getcwd(buffer, sizeof(buffer)) != nullptr) {
-        currentWorkingDir_ = buffer;
-    }
+    std::lock_guard<std::mutex> lock(workingDirMutex_);
+    currentWorkingDir_ = WorkingDirectory::Current();
 }
 
 std::string CommandExecutor::GetWorkingDirectory() const {
+    std::lock_guard<std::mutex> lock(workingDirMutex_);
+    return currentWorkingDir_.Path();
+}
+
+WorkingDirectory CommandExecutor::GetWorkingDirectoryHandle() const {
+    std::lock_guard<std::mutex> lock(workingDirMutex_);
     return currentWorkingDir_;
 }
 
 bool CommandExecutor::SetWorkingDirectory(const std::string& path) {
-    if (chdir(path.c_str()) == 0) {
-        InitializeWorkingDirectory();
-        return true;
+    std::lock_guard<std::mutex> lock(workingDirMutex_);
+    WorkingDirectory next;
+    if (!currentWorkingDir_.Resolve(path, next)) {
+        return false;
     }
-    return false;
+    currentWorkingDir_ = next;
+    return true;
 }
 
 bool CommandExecutor::IsRunning() const {
-    return isRunning_;
+    return runningCommands_ > 0;
 }
 
 bool CommandExecutor::IsBuiltInCommand(const std::string& command) const {
@@ -70,7 +89,7 @@ bool CommandExecutor::IsBuiltInCommand(const std::string& command) const {
 CommandBlock CommandExecutor::ExecuteBuiltIn(const std::string& command) {
     CommandBlock block;
     block.input = command;
-    block.workingDirectory = currentWorkingDir_;
+    block.workingDirectory = GetWorkingDirectory();
     
     std::string cmd = command;
     auto spacePos = cmd.find(' ');
@@ -87,7 +106,7 @@ CommandBlock CommandExecutor::ExecuteBuiltIn(const std::string& command) {
         }
         
         if (ExecuteCD(arg)) {
-            block.output = "Changed directory to: " + currentWorkingDir_;
+            block.output = "Changed directory to: " + GetWorkingDirectory();
             block.status = CommandStatus::Success;
             block.exitCode = 0;
         } else {
@@ -97,7 +116,7 @@ CommandBlock CommandExecutor::ExecuteBuiltIn(const std::string& command) {
         }
     }
     else if (cmd == "pwd") {
-        block.output = currentWorkingDir_;
+        block.output = GetWorkingDirectory();
         block.status = CommandStatus::Success;
         block.exitCode = 0;
     }
@@ -119,99 +138,279 @@ bool CommandExecutor::ExecuteCD(const std::string& path) {
     return SetWorkingDirectory(path);
 }
 
-CommandBlock CommandExecutor::Execute(const std::string& command, const std::string& workingDir) {
+CommandBlock CommandExecutor::Execute(const std::string& command, const WorkingDirectory& workingDir) {
+    CommandBlock collected;
+    CommandBlock block = ExecuteStreaming(command, [&collected](OutputStream stream, const char* data, size_t size) {
+        collected.AppendOutput(stream, data, size);
+    }, workingDir);
+    collected.FinishOutput();
+    
+    block.output = std::move(collected.output);
+    block.segments = std::move(collected.segments);
+    block.styles = std::move(collected.styles);
+    block.lines = std::move(collected.lines);
+    block.binaryBytes = collected.binaryBytes;
+    return block;
+}
+
+CommandBlock CommandExecutor::ExecuteStreaming(const std::string& command,
+                                               const OutputCallback& onOutput,
+                                               const WorkingDirectory& workingDir,
+                                               std::shared_ptr<CancelToken> cancel,
+                                               const ResourceLimits& limits) {
+    WorkingDirectory runDir = workingDir.IsValid() ? workingDir : GetWorkingDirectoryHandle();
     CommandBlock block;
-    block.input = command;
-    block.workingDirectory = workingDir.empty() ? currentWorkingDir_ : workingDir;
+    if (!BeginCommand(command, onOutput, runDir, cancel, block)) {
+        return block;
+    }
     
-    // Check if built-in
-    if (IsBuiltInCommand(command)) {
-        return ExecuteBuiltIn(command);
+    try {
+        ProcessExit exit = CaptureOutput(command, runDir, onOutput, cancel.get(), limits);
+        FinishCommand(block, exit, onOutput, cancel);
+    }
+    catch (const std::exception& e) {
+        FailCommand(block, e.what(), onOutput, cancel);
+    }
+    return block;
+}
+
+void CommandExecutor::ExecuteReactive(const std::string& command,
+                                      const OutputCallback& onOutput,
+                                      const CompletionCallback& onComplete,
+                                      const WorkingDirectory& workingDir,
+                                      std::shared_ptr<CancelToken> cancel,
+                                      const ResourceLimits& limits) {
+#ifdef _WIN32
+    onComplete(ExecuteStreaming(command, onOutput, workingDir, cancel, limits));
+#else
+    if (!ProcessReactor::IsSupported()) {
+        onComplete(ExecuteStreaming(command, onOutput, workingDir, cancel, limits));
+        return;
     }
     
-    isRunning_ = true;
+    WorkingDirectory runDir = workingDir.IsValid() ? workingDir : GetWorkingDirectoryHandle();
+    auto block = std::make_shared<CommandBlock>();
+    if (!BeginCommand(command, onOutput, runDir, cancel, *block)) {
+        onComplete(*block);
+        return;
+    }
     
+    std::shared_ptr<CommandCgroup> cgroup = limits.Any() ? CommandCgroup::Create(limits) : nullptr;
+    ChildProcess child;
     try {
-        block.output = CaptureOutput(command);
-        block.status = CommandStatus::Success;
-        block.exitCode = 0;
+        child = SpawnCommand(command, runDir, limits, cgroup.get());
     }
     catch (const std::exception& e) {
-        block.output = std::string("Error: ") + e.what();
-        block.status = CommandStatus::Failed;
-        block.exitCode = 1;
+        FailCommand(*block, e.what(), onOutput, cancel);
+        onComplete(*block);
+        return;
     }
+    cancel->Attach(child.pid);
     
-    isRunning_ = false;
-    return block;
+    // The cgroup stays alive until the exit is reported, then its usage is read back
+    auto onExit = [this, block, onOutput, onComplete, cancel, cgroup](const ProcessExit& exit) {
+        ProcessExit result = exit;
+        if (cgroup) {
+            cgroup->ReadUsage(result.usage);
+        }
+        FinishCommand(*block, result, onOutput, cancel);
+        onComplete(*block);
+    };
+    if (!ProcessReactor::Shared().Watch(child, onOutput, onExit, cancel)) {
+        // Shutting down: drain on this thread instead
+        OutputCapture::Drain(child, onOutput, cancel.get());
+        onExit(WaitForExit(child, cancel.get()));
+    }
+#endif
 }
 
-std::string CommandExecutor::CaptureOutput(const std::string& command) {
-#ifdef _WIN32
-    // Windows implementation using _popen
-    std::string fullCommand = "cd /d \"" + currentWorkingDir_ + "\" && " + command + " 2>&1";
-    FILE* pipe = _popen(fullCommand.c_str(), "r");
+bool CommandExecutor::BeginCommand(const std::string& command, const OutputCallback& onOutput,
+                                   const WorkingDirectory& runDir,
+                                   std::shared_ptr<CancelToken>& cancel, CommandBlock& block) {
+    // Check if built-in
+    if (IsBuiltInCommand(command)) {
+        block = ExecuteBuiltIn(command);
+        if (onOutput && !block.output.Empty()) {
+            std::string text = block.output.Str();
+            onOutput(OutputStream::Stdout, text.data(), text.size());
+        }
+        block.output.Clear();
+        return false;
+    }
     
-    if (!pipe) {
-        throw std::runtime_error("Failed to execute command");
+    block.input = command;
+    block.workingDirectory = runDir.Path();
+    
+    if (!cancel) {
+        cancel = std::make_shared<CancelToken>();
+    }
+    ApplyLimits(*cancel, command);
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        activeTokens_.insert(cancel);
+    }
+    
+    // Cancelled while it was still queued: don't start it at all
+    if (cancel->IsCancelled()) {
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        activeTokens_.erase(cancel);
+        block.status = CommandStatus::Cancelled;
+        block.exitCode = 130;
+        return false;
     }
     
-    std::stringstream result;
-    char buffer[256];
+    runningCommands_++;
     
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result << buffer;
+    // Common read-only commands answer in-process, in microseconds
+    int exitCode;
+    auto start = std::chrono::steady_clock::now();
+    if (BuiltinRegistry::Shared().Run(command, runDir, onOutput, exitCode)) {
+        ProcessExit exit;
+        exit.exitCode = exitCode;
+        exit.usage.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        block.nativeBuiltin = true;
+        FinishCommand(block, exit, onOutput, cancel);
+        return false;
+    }
+    return true;
+}
+
+void CommandExecutor::FinishCommand(CommandBlock& block, const ProcessExit& exit, const OutputCallback& onOutput,
+                                    const std::shared_ptr<CancelToken>& cancel) {
+    block.exitCode = exit.exitCode;
+    block.termSignal = exit.termSignal;
+    block.usage = exit.usage;
+    block.pipeline = exit.stages;
+    block.status = block.exitCode == 0 ? CommandStatus::Success : CommandStatus::Failed;
+    EndCommand(block, onOutput, cancel);
+}
+
+void CommandExecutor::FailCommand(CommandBlock& block, const std::string& error, const OutputCallback& onOutput,
+                                  const std::shared_ptr<CancelToken>& cancel) {
+    std::string message = "Error: " + error;
+    if (onOutput) onOutput(OutputStream::Stderr, message.data(), message.size());
+    block.status = CommandStatus::Failed;
+    block.exitCode = 1;
+    EndCommand(block, onOutput, cancel);
+}
+
+void CommandExecutor::EndCommand(CommandBlock& block, const OutputCallback& onOutput,
+                                 const std::shared_ptr<CancelToken>& cancel) {
+    // Output so far stays with the block; just say why it stopped
+    if (cancel->IsCancelled()) {
+        block.status = CommandStatus::Cancelled;
+        std::ostringstream note;
+        if (cancel->TimedOut()) {
+            note << "\n[Timed out after " << cancel->GetTimeout() << "s]\n";
+        } else {
+            note << "\n[Cancelled]\n";
+        }
+        std::string text = note.str();
+        if (onOutput) onOutput(OutputStream::Stderr, text.data(), text.size());
     }
     
-    int exitCode = _pclose(pipe);
-    return result.str();
-#else
-    // Unix/Linux implementation
-    std::string fullCommand = "cd \"" + currentWorkingDir_ + "\" && " + command + " 2>&1";
-    FILE* pipe = popen(fullCommand.c_str(), "r");
+    runningCommands_--;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex_);
+        activeTokens_.erase(cancel);
+    }
+}
+
+ProcessExit CommandExecutor::CaptureOutput(const std::string& command, const WorkingDirectory& workingDir,
+                                           const OutputCallback& onOutput, CancelToken* cancel,
+                                           const ResourceLimits& limits) {
+#ifdef _WIN32
+    // Windows implementation using _popen; _read returns as soon as any data is available.
+    // _popen only exposes one pipe, so stderr is folded into stdout here.
+    std::string fullCommand = "cd /d \"" + workingDir.Path() + "\" && " + command + " 2>&1";
+    auto startTime = std::chrono::steady_clock::now();
+    FILE* pipe = _popen(fullCommand.c_str(), "rb");
     
     if (!pipe) {
         throw std::runtime_error("Failed to execute command");
     }
     
-    std::stringstream result;
-    char buffer[256];
-    
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result << buffer;
+    std::vector<char> buffer(kReadChunkSize);
+    int bytesRead;
+    while ((bytesRead = _read(_fileno(pipe), buffer.data(), static_cast<unsigned>(buffer.size()))) > 0) {
+        if (onOutput) onOutput(OutputStream::Stdout, buffer.data(), static_cast<size_t>(bytesRead));
+        // _popen hides the child, so cancelling can only stop us listening to it
+        if (cancel && cancel->IsCancelled()) break;
     }
     
-    int exitCode = pclose(pipe);
-    return result.str();
+    // _popen hides the process handle, so only wall time is available here
+    ProcessExit exit;
+    exit.exitCode = _pclose(pipe);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    exit.usage.wallSeconds = elapsed.count();
+    return exit;
+#else
+    // Unix/Linux implementation: separate stdout/stderr pipes, shell only when needed
+    // A cgroup sees grandchildren that wait4() misses; without one, limits fall back to setrlimit()
+    std::unique_ptr<CommandCgroup> cgroup = limits.Any() ? CommandCgroup::Create(limits) : nullptr;
+    ChildProcess child = SpawnCommand(command, workingDir, limits, cgroup.get());
+    if (cancel) cancel->Attach(child.pid);
+    OutputCapture::Drain(child, onOutput, cancel);
+    ProcessExit exit = WaitForExit(child, cancel);
+    if (cgroup) {
+        cgroup->ReadUsage(exit.usage);
+    }
+    return exit;
 #endif
 }
 
 void CommandExecutor::ExecuteAsync(const std::string& command, 
                                    std::function<void(const CommandBlock&)> callback,
-                                   const std::string& workingDir) {
-    // Launch in separate thread
-    std::thread([this, command, callback, workingDir]() {
+                                   const WorkingDirectory& workingDir) {
+    // Run on the shared pool rather than a thread per call
+    ThreadPool::Shared().Submit([this, command, callback, workingDir]() {
         CommandBlock result = Execute(command, workingDir);
         callback(result);
-    }).detach();
+    }, TaskPriority::Interactive);
 }
 
 void CommandExecutor::Cancel() {
-    if (isRunning_) {
-#ifdef _WIN32
-        if (processHandle_) {
-            TerminateProcess(processHandle_, 1);
-            CloseHandle(processHandle_);
-            processHandle_ = nullptr;
-        }
-#else
-        if (processId_ > 0) {
-            kill(processId_, SIGTERM);
-            processId_ = -1;
-        }
-#endif
-        isRunning_ = false;
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    for (const auto& token : activeTokens_) {
+        token->Cancel();
+    }
+}
+
+void CommandExecutor::SetStopSchedule(int interruptGraceMs, int terminateGraceMs) {
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    interruptGraceMs_ = interruptGraceMs;
+    terminateGraceMs_ = terminateGraceMs;
+}
+
+void CommandExecutor::SetDefaultTimeout(double seconds) {
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    defaultTimeout_ = seconds;
+}
+
+void CommandExecutor::SetCommandTimeout(const std::string& program, double seconds) {
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    commandTimeouts_[program] = seconds;
+}
+
+double CommandExecutor::GetTimeoutFor(const std::string& command) const {
+    // Match on the program name: first word, without any directory
+    size_t start = command.find_first_not_of(" \t");
+    size_t end = command.find_first_of(" \t", start);
+    std::string program = start == std::string::npos ? "" : command.substr(start, end - start);
+    size_t slash = program.find_last_of("/\\");
+    if (slash != std::string::npos) program = program.substr(slash + 1);
+    
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    auto it = commandTimeouts_.find(program);
+    return it != commandTimeouts_.end() ? it->second : defaultTimeout_;
+}
+
+void CommandExecutor::ApplyLimits(CancelToken& token, const std::string& command) const {
+    if (token.GetTimeout() <= 0.0) {
+        token.SetTimeout(GetTimeoutFor(command));
     }
+    std::lock_guard<std::mutex> lock(settingsMutex_);
+    token.SetStopSchedule(interruptGraceMs_, terminateGraceMs_);
 }
 
 } // namespace NeuroShell
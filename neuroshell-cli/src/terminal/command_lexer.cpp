@@ -0,0 +1,235 @@
+#include "terminal/command_lexer.h"
+#include <unordered_set>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace NeuroShell {
+
+namespace {
+
+// Unquoted characters that make the shell do something other than split words
+bool IsShellSpecial(char c) {
+    switch (c) {
+        case '|': case '&': case ';': case '<': case '>': case '(': case ')':
+        case '$': case '`': case '*': case '?': case '[': case '{': case '}':
+        case '!': case '\n': case '\r':
+            return true;
+        default:
+            return false;
+    }
+}
+
+#ifndef _WIN32
+bool IsExecutableFile(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode) && access(path.c_str(), X_OK) == 0;
+}
+#endif
+
+} // namespace
+
+bool CommandLexer::SplitSimple(const std::string& command, std::vector<std::string>& argv) {
+    argv.clear();
+    std::string word;
+    bool inWord = false;        // Set by quotes too, so "" yields an empty argument
+    size_t i = 0;
+
+    while (i < command.size()) {
+        char c = command[i];
+
+        if (c == ' ' || c == '\t') {
+            if (inWord) {
+                argv.push_back(word);
+                word.clear();
+                inWord = false;
+            }
+            ++i;
+            continue;
+        }
+
+        // Comments and tilde expansion only happen at the start of a word
+        if (!inWord && (c == '#' || c == '~')) return false;
+
+        if (c == '\\') {
+            if (i + 1 >= command.size() || command[i + 1] == '\n') return false;
+            word += command[i + 1];
+            inWord = true;
+            i += 2;
+            continue;
+        }
+
+        if (c == '\'') {
+            size_t close = command.find('\'', i + 1);
+            if (close == std::string::npos) return false;
+            word.append(command, i + 1, close - i - 1);
+            inWord = true;
+            i = close + 1;
+            continue;
+        }
+
+        if (c == '"') {
+            ++i;
+            bool closed = false;
+            while (i < command.size()) {
+                char q = command[i];
+                if (q == '"') {
+                    closed = true;
+                    ++i;
+                    break;
+                }
+                if (q == '$' || q == '`' || q == '!') return false;
+                if (q == '\\' && i + 1 < command.size()) {
+                    char next = command[i + 1];
+                    if (next == '\n') return false;
+                    if (next == '"' || next == '\\') {
+                        word += next;
+                        i += 2;
+                        continue;
+                    }
+                }
+                word += q;
+                ++i;
+            }
+            if (!closed) return false;
+            inWord = true;
+            continue;
+        }
+
+        if (IsShellSpecial(c)) return false;
+
+        // NAME=value before the program is an assignment, not a word
+        if (c == '=' && argv.empty()) return false;
+
+        word += c;
+        inWord = true;
+        ++i;
+    }
+
+    if (inWord) {
+        argv.push_back(word);
+    }
+
+    return !argv.empty() && !IsShellWord(argv[0]);
+}
+
+bool CommandLexer::SplitPipeline(const std::string& command, std::vector<std::string>& stages) {
+    stages.clear();
+    size_t start = 0;
+    char quote = 0;
+    for (size_t i = 0; i <= command.size(); ++i) {
+        char c = i < command.size() ? command[i] : '|';
+        if (quote == '\'') {
+            if (c == '\'') quote = 0;
+            continue;
+        }
+        if (c == '\\') {
+            ++i;
+            continue;
+        }
+        if (quote == '"') {
+            if (c == '"') quote = 0;
+            continue;
+        }
+        if (c == '\'' || c == '"') {
+            quote = c;
+            continue;
+        }
+        if (c != '|') continue;
+
+        // || and |& are other operators
+        if (i + 1 < command.size() && (command[i + 1] == '|' || command[i + 1] == '&')) return false;
+        stages.push_back(command.substr(start, i - start));
+        start = i + 1;
+    }
+    if (quote != 0 || stages.size() < 2) return false;
+
+    std::vector<std::string> argv;
+    for (auto& stage : stages) {
+        if (!SplitSimple(stage, argv)) return false;
+        size_t first = stage.find_first_not_of(" \t");
+        size_t last = stage.find_last_not_of(" \t");
+        stage = stage.substr(first, last - first + 1);
+    }
+    return true;
+}
+
+bool CommandLexer::IsShellWord(const std::string& word) {
+    static const std::unordered_set<std::string> kShellWords = {
+        // Reserved words
+        "if", "then", "else", "elif", "fi", "case", "esac", "for", "select",
+        "while", "until", "do", "done", "in", "function", "time", "coproc",
+        // Builtins that change or query the shell itself
+        "cd", "pushd", "popd", "dirs", "export", "unset", "alias", "unalias",
+        "source", ".", "exec", "eval", "set", "shopt", "ulimit", "umask",
+        "readonly", "trap", "wait", "declare", "typeset", "local", "let",
+        "hash", "builtin", "command", "type", "read", "shift", "return",
+        "break", "continue", "exit", "logout", "jobs", "fg", "bg", "disown",
+        "enable", "history", "fc", "getopts", "suspend", "help", "bind"
+    };
+    return kShellWords.count(word) > 0;
+}
+
+std::string PathCache::Resolve(const std::string& program) {
+#ifdef _WIN32
+    (void)program;
+    return "";
+#else
+    if (program.empty()) return "";
+    if (program.find('/') != std::string::npos) return program;
+
+    const char* pathEnv = std::getenv("PATH");
+    std::string pathVar = pathEnv ? pathEnv : "/usr/bin:/bin";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pathVar != pathVar_) {
+        entries_.clear();
+        pathVar_ = pathVar;
+    }
+
+    auto it = entries_.find(program);
+    if (it != entries_.end()) {
+        if (it->second.empty() || IsExecutableFile(it->second)) {
+            return it->second;
+        }
+        entries_.erase(it);
+    }
+
+    // Search PATH in order. A relative entry depends on the child's working
+    // directory, so give up there and let the shell do the search.
+    std::string found;
+    size_t start = 0;
+    while (start <= pathVar.size()) {
+        size_t end = pathVar.find(':', start);
+        if (end == std::string::npos) end = pathVar.size();
+        std::string dir = pathVar.substr(start, end - start);
+        start = end + 1;
+
+        if (dir.empty() || dir[0] != '/') break;
+        std::string candidate = dir + "/" + program;
+        if (IsExecutableFile(candidate)) {
+            found = candidate;
+            break;
+        }
+    }
+
+    entries_[program] = found;
+    return found;
+#endif
+}
+
+void PathCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    pathVar_.clear();
+}
+
+PathCache& PathCache::Instance() {
+    static PathCache cache;
+    return cache;
+}
+
+} // namespace NeuroShell
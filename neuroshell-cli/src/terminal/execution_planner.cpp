@@ -0,0 +1,352 @@
+#include "terminal/execution_planner.h"
+#include <unordered_set>
+#include <algorithm>
+#include <cctype>
+
+namespace NeuroShell {
+
+namespace {
+
+enum class TokenKind { Word, Separator, RedirectOut, RedirectIn };
+
+struct Token {
+    TokenKind kind;
+    std::string text;
+};
+
+// Programs whose arguments aren't paths and that touch no files
+const std::unordered_set<std::string> kNoFilesystem = {
+    "echo", "printf", "date", "cal", "whoami", "id", "uname", "hostname",
+    "uptime", "free", "ps", "df", "env", "printenv", "pwd", "sleep", "true",
+    "false", "which", "whereis", "nproc", "w", "who", "lscpu", "lsblk",
+    "ping", "nslookup", "dig", "netstat", "ss", "ifconfig", "basename", "dirname"
+};
+
+// Programs that only read the paths they are given (or the working directory)
+const std::unordered_set<std::string> kReadOnly = {
+    "ls", "ll", "la", "dir", "cat", "head", "tail", "less", "more", "grep",
+    "egrep", "fgrep", "rg", "ag", "find", "wc", "du", "stat", "file", "tree",
+    "sort", "uniq", "diff", "cmp", "md5sum", "sha1sum", "sha256sum", "realpath",
+    "readlink", "jq", "awk", "sed", "cut", "tr", "column", "test", "[", "curl"
+};
+
+// Programs that modify every path argument they are given
+const std::unordered_set<std::string> kWritesArgs = {
+    "rm", "rmdir", "mkdir", "touch", "chmod", "chown", "chgrp", "truncate",
+    "ln", "mv", "tee", "shred", "unlink"
+};
+
+// Programs that change the shell's own state for the commands after them
+const std::unordered_set<std::string> kShellState = {
+    "cd", "pushd", "popd", "export", "unset", "source", ".", "alias",
+    "unalias", "set", "shopt", "umask", "ulimit", "exec", "eval", "hash"
+};
+
+// Wrappers that run the rest of the line as the real command
+const std::unordered_set<std::string> kPrefixes = {
+    "sudo", "time", "nice", "nohup", "command", "builtin"
+};
+
+// Read-only git subcommands
+const std::unordered_set<std::string> kGitReadOnly = {
+    "status", "log", "diff", "show", "rev-parse", "ls-files", "blame",
+    "describe", "shortlog", "grep", "reflog", "whatchanged"
+};
+
+bool IsOption(const std::string& word) {
+    return word.size() > 1 && word[0] == '-';
+}
+
+// Split into words, separators and redirects. Returns false on syntax the
+// planner doesn't model (subshells, substitutions, here-documents).
+bool Tokenize(const std::string& command, std::vector<Token>& tokens) {
+    std::string word;
+    bool inWord = false;
+
+    auto flush = [&]() {
+        if (inWord) {
+            tokens.push_back({ TokenKind::Word, word });
+            word.clear();
+            inWord = false;
+        }
+    };
+
+    for (size_t i = 0; i < command.size(); ++i) {
+        char c = command[i];
+        char next = i + 1 < command.size() ? command[i + 1] : '\0';
+
+        if (c == '\'' || c == '"') {
+            size_t close = command.find(c, i + 1);
+            if (close == std::string::npos) return false;
+            std::string quoted = command.substr(i + 1, close - i - 1);
+            if (c == '"' && (quoted.find("$(") != std::string::npos || quoted.find('`') != std::string::npos)) {
+                return false;
+            }
+            word += quoted;
+            inWord = true;
+            i = close;
+        } else if (c == '\\' && next != '\0') {
+            word += next;
+            inWord = true;
+            ++i;
+        } else if (c == '`' || c == '(' || c == ')' || (c == '$' && next == '(')) {
+            return false;
+        } else if (c == ' ' || c == '\t') {
+            flush();
+        } else if (c == '>' || (c == '&' && next == '>')) {
+            // "2>" and friends: a pure digit word before > is a descriptor number
+            if (inWord && std::all_of(word.begin(), word.end(), ::isdigit)) {
+                word.clear();
+                inWord = false;
+            }
+            flush();
+            if (c == '&') ++i;
+            if (i + 1 < command.size() && command[i + 1] == '>') ++i;
+            if (i + 1 < command.size() && command[i + 1] == '&') {
+                // >&2 duplicates a descriptor; nothing is written to disk
+                ++i;
+                while (i + 1 < command.size() && isdigit(static_cast<unsigned char>(command[i + 1]))) ++i;
+                continue;
+            }
+            tokens.push_back({ TokenKind::RedirectOut, "" });
+        } else if (c == '<') {
+            if (next == '<' || next == '(') return false;
+            flush();
+            tokens.push_back({ TokenKind::RedirectIn, "" });
+        } else if (c == '|' || c == '&' || c == ';') {
+            flush();
+            if ((c == '|' || c == '&') && next == c) ++i;
+            tokens.push_back({ TokenKind::Separator, "" });
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    flush();
+    return true;
+}
+
+// A path that may name more than one file (glob) stands for its directory
+std::string PathFromWord(const std::string& word) {
+    if (word.find('$') != std::string::npos) return "*";
+    if (word.find_first_of("*?[{") == std::string::npos) return word;
+    size_t slash = word.find_last_of('/');
+    return slash == std::string::npos ? "." : word.substr(0, slash);
+}
+
+std::string NormalizePath(std::string path) {
+    while (path.compare(0, 2, "./") == 0) path.erase(0, 2);
+    while (path.size() > 1 && path.back() == '/') path.pop_back();
+    return path.empty() ? "." : path;
+}
+
+bool IsDevicePath(const std::string& path) {
+    return path.compare(0, 5, "/dev/") == 0;
+}
+
+// Classify one pipeline stage; returns false if its effects are unknown
+bool AnalyzeStage(std::vector<std::string> words, PlannedCommand& planned) {
+    // Leading NAME=value assignments only affect this command...
+    while (!words.empty() && words[0].find('=') != std::string::npos && words[0][0] != '=') {
+        words.erase(words.begin());
+    }
+    // ...unless that's all there is, in which case they set shell variables
+    if (words.empty()) return false;
+
+    while (words.size() > 1 && kPrefixes.count(words[0])) {
+        words.erase(words.begin());
+    }
+
+    const std::string& program = words[0];
+    std::vector<std::string> args;
+    for (size_t i = 1; i < words.size(); ++i) {
+        if (IsOption(words[i])) {
+            if (words[i] == "--version" || words[i] == "--help") return true;
+        } else {
+            args.push_back(PathFromWord(words[i]));
+        }
+    }
+
+    if (kShellState.count(program)) return false;
+    if (kNoFilesystem.count(program)) return true;
+
+    auto hasOption = [&words](std::initializer_list<const char*> options) {
+        for (size_t i = 1; i < words.size(); ++i) {
+            for (const char* option : options) {
+                if (words[i] == option || words[i].compare(0, std::string(option).size() + 1, std::string(option) + "=") == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    if (program == "git") {
+        // First non-option word is the subcommand, anything after it its arguments
+        std::vector<std::string> rest;
+        for (size_t i = 1; i < words.size(); ++i) {
+            if (!IsOption(words[i])) rest.push_back(words[i]);
+        }
+        std::string sub = rest.empty() ? "" : rest[0];
+        bool listing = (sub == "branch" || sub == "remote" || sub == "tag") && rest.size() == 1;
+        bool stashQuery = sub == "stash" && rest.size() >= 2 && (rest[1] == "list" || rest[1] == "show");
+        if (kGitReadOnly.count(sub) || listing || stashQuery) {
+            planned.reads.push_back(".");
+            return true;
+        }
+        return false;
+    }
+
+    if (kReadOnly.count(program)) {
+        if (program == "find" && hasOption({ "-delete", "-exec", "-execdir", "-ok", "-okdir", "-fprint", "-fprintf", "-fls" })) return false;
+        if (program == "sed" && (hasOption({ "-i", "--in-place" }) ||
+            std::any_of(words.begin(), words.end(), [](const std::string& w) { return w.compare(0, 2, "-i") == 0; }))) {
+            planned.writes.insert(planned.writes.end(), args.begin(), args.end());
+            return !args.empty();
+        }
+        if (program == "sort" && hasOption({ "-o", "--output" })) return false;
+        if (program == "curl" && hasOption({ "-o", "-O", "--output", "--remote-name", "-T", "--upload-file" })) return false;
+        if (program == "uniq" && args.size() >= 2) {
+            planned.reads.push_back(args[0]);
+            planned.writes.push_back(args[1]);
+            return true;
+        }
+        if (program == "curl") return true;
+
+        if (args.empty()) {
+            planned.reads.push_back(".");
+        } else {
+            planned.reads.insert(planned.reads.end(), args.begin(), args.end());
+        }
+        return true;
+    }
+
+    if (kWritesArgs.count(program)) {
+        if (args.empty()) return program == "tee";
+        planned.writes.insert(planned.writes.end(), args.begin(), args.end());
+        return true;
+    }
+
+    if (program == "cp" || program == "rsync" || program == "install") {
+        if (args.size() < 2) return false;
+        planned.reads.insert(planned.reads.end(), args.begin(), args.end() - 1);
+        planned.writes.push_back(args.back());
+        return true;
+    }
+
+    // Anything else (build tools, interpreters, package managers) may do anything
+    return false;
+}
+
+} // namespace
+
+PlannedCommand ExecutionPlanner::Analyze(const std::string& command) {
+    PlannedCommand planned;
+    planned.command = command;
+
+    std::vector<Token> tokens;
+    if (!Tokenize(command, tokens)) {
+        planned.barrier = true;
+        return planned;
+    }
+
+    bool known = true;
+    std::vector<std::string> stage;
+    bool writesToRedirect = false;
+
+    for (size_t i = 0; i <= tokens.size() && known; ++i) {
+        if (i == tokens.size() || tokens[i].kind == TokenKind::Separator) {
+            if (!stage.empty()) {
+                known = AnalyzeStage(stage, planned);
+            }
+            stage.clear();
+            continue;
+        }
+
+        const Token& token = tokens[i];
+        if (token.kind == TokenKind::Word) {
+            stage.push_back(token.text);
+            continue;
+        }
+
+        // The word after a redirect is its target
+        if (i + 1 >= tokens.size() || tokens[i + 1].kind != TokenKind::Word) {
+            known = false;
+            break;
+        }
+        std::string target = PathFromWord(tokens[++i].text);
+        if (token.kind == TokenKind::RedirectOut) {
+            if (!IsDevicePath(target)) {
+                planned.writes.push_back(target);
+                writesToRedirect = true;
+            }
+        } else {
+            planned.reads.push_back(target);
+        }
+    }
+
+    if (!known) {
+        planned.barrier = true;
+        planned.reads.clear();
+        planned.writes.clear();
+        return planned;
+    }
+
+    for (auto& path : planned.reads) path = NormalizePath(path);
+    for (auto& path : planned.writes) path = NormalizePath(path);
+    planned.readOnly = planned.writes.empty() && !writesToRedirect;
+    return planned;
+}
+
+bool ExecutionPlanner::PathsOverlap(const std::string& left, const std::string& right) {
+    std::string a = NormalizePath(left);
+    std::string b = NormalizePath(right);
+    if (a == "*" || b == "*") return true;
+    if (a.find("..") != std::string::npos || b.find("..") != std::string::npos) return true;
+
+    bool aAbsolute = !a.empty() && (a[0] == '/' || a[0] == '~');
+    bool bAbsolute = !b.empty() && (b[0] == '/' || b[0] == '~');
+    if (aAbsolute != bAbsolute) return true;
+    if (!aAbsolute && (a == "." || b == ".")) return true;
+
+    if (a == b) return true;
+    const std::string& shorter = a.size() < b.size() ? a : b;
+    const std::string& longer = a.size() < b.size() ? b : a;
+    return longer.compare(0, shorter.size(), shorter) == 0 &&
+           (shorter == "/" || longer[shorter.size()] == '/');
+}
+
+std::vector<PlannedCommand> ExecutionPlanner::Plan(const std::vector<std::string>& commands) {
+    std::vector<PlannedCommand> plan;
+    plan.reserve(commands.size());
+    for (const auto& command : commands) {
+        plan.push_back(Analyze(command));
+    }
+
+    auto anyOverlap = [](const std::vector<std::string>& left, const std::vector<std::string>& right) {
+        for (const auto& a : left) {
+            for (const auto& b : right) {
+                if (PathsOverlap(a, b)) return true;
+            }
+        }
+        return false;
+    };
+
+    for (size_t j = 0; j < plan.size(); ++j) {
+        for (size_t i = 0; i < j; ++i) {
+            const PlannedCommand& earlier = plan[i];
+            const PlannedCommand& later = plan[j];
+            bool ordered = earlier.barrier || later.barrier ||
+                           anyOverlap(earlier.writes, later.reads) ||
+                           anyOverlap(earlier.writes, later.writes) ||
+                           anyOverlap(earlier.reads, later.writes);
+            if (ordered) {
+                plan[j].dependsOn.push_back(i);
+            }
+        }
+    }
+
+    return plan;
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,373 @@
+#include "terminal/file_watcher.h"
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <cerrno>
+
+namespace NeuroShell {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Anything that changes what a command would see; reads and opens don't count
+constexpr uint32_t kEventMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+constexpr size_t kEventBufferSize = 16 * 1024;
+
+bool IsDirectory(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// path and the directories below it, breadth-first so the cap leaves out the
+// deepest ones. Hidden directories (.git, .cache, ...) and symlinks are skipped.
+void CollectDirectories(const std::string& path, size_t limit, std::vector<std::string>& directories) {
+    std::deque<std::string> queue = { path };
+    while (!queue.empty() && directories.size() < limit) {
+        std::string directory = queue.front();
+        queue.pop_front();
+        directories.push_back(directory);
+
+        DIR* handle = opendir(directory.c_str());
+        if (!handle) continue;
+        while (struct dirent* entry = readdir(handle)) {
+            if (entry->d_name[0] == '.') continue;
+            std::string child = directory + "/" + entry->d_name;
+            bool isDirectory = entry->d_type == DT_DIR || (entry->d_type == DT_UNKNOWN && IsDirectory(child));
+            if (isDirectory) queue.push_back(child);
+        }
+        closedir(handle);
+    }
+}
+
+} // namespace
+
+struct FileWatcher::Watch {
+    Callback onChange;
+    std::vector<int> descriptors;
+    Clock::duration debounce;
+    Clock::duration minInterval;
+    bool changed = false;           // Changes seen since the last call
+    bool suspended = false;         // Called, waiting for Resume()
+    bool resuming = false;          // Resume() asked, not yet applied
+    Clock::time_point firstChange;
+    Clock::time_point lastChange;
+    Clock::time_point lastCall;
+
+    Clock::time_point Due() const {
+        Clock::time_point settled = std::min(lastChange + debounce,
+                                             firstChange + std::chrono::milliseconds(kMaxDelayMs));
+        return std::max(settled, lastCall + minInterval);
+    }
+
+    void Mark(Clock::time_point now) {
+        if (suspended) return;
+        if (!changed) {
+            changed = true;
+            firstChange = now;
+        }
+        lastChange = now;
+    }
+};
+
+FileWatcher::FileWatcher()
+    : nextId_(1)
+    , calling_(0)
+    , stopping_(false)
+    , inotifyFd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+    , wakeFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+}
+
+FileWatcher::~FileWatcher() {
+    Shutdown();
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+}
+
+bool FileWatcher::IsSupported() {
+    return true;
+}
+
+FileWatcher& FileWatcher::Shared() {
+    static FileWatcher watcher;
+    return watcher;
+}
+
+uint64_t FileWatcher::Add(const std::vector<std::string>& paths, Callback onChange, int debounceMs,
+                          int minIntervalMs) {
+    if (inotifyFd_ < 0 || wakeFd_ < 0) return 0;
+
+    // Walk the trees before taking the lock
+    std::vector<std::string> targets;
+    for (const auto& path : paths) {
+        if (IsDirectory(path)) {
+            CollectDirectories(path, kMaxDirectories - std::min(kMaxDirectories, targets.size()), targets);
+        } else {
+            targets.push_back(path);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) return 0;
+    uint64_t id = nextId_++;
+    auto watch = std::make_unique<Watch>();
+    for (const auto& target : targets) {
+        AddDescriptor(target, id, watch->descriptors);
+    }
+    if (watch->descriptors.empty()) return 0;
+
+    watch->onChange = std::move(onChange);
+    watch->debounce = std::chrono::milliseconds(std::max(0, debounceMs));
+    watch->minInterval = std::chrono::milliseconds(std::max(0, minIntervalMs));
+    watches_[id] = std::move(watch);
+
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&FileWatcher::Loop, this);
+        threadId_ = thread_.get_id();
+    }
+    return id;
+}
+
+bool FileWatcher::AddDescriptor(const std::string& path, uint64_t id, std::vector<int>& descriptors) {
+    int descriptor = inotify_add_watch(inotifyFd_, path.c_str(), kEventMask);
+    if (descriptor < 0) return false;
+
+    // The same directory named twice gives the same descriptor
+    std::vector<uint64_t>& owners = owners_[descriptor];
+    if (std::find(owners.begin(), owners.end(), id) == owners.end()) {
+        owners.push_back(id);
+        descriptors.push_back(descriptor);
+    }
+    return true;
+}
+
+void FileWatcher::ReleaseDescriptors(Watch& watch, uint64_t id) {
+    for (int descriptor : watch.descriptors) {
+        auto it = owners_.find(descriptor);
+        if (it == owners_.end()) continue;
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), id), it->second.end());
+        if (it->second.empty()) {
+            inotify_rm_watch(inotifyFd_, descriptor);
+            owners_.erase(it);
+        }
+    }
+    watch.descriptors.clear();
+}
+
+void FileWatcher::Resume(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = watches_.find(id);
+    if (it == watches_.end() || !it->second->suspended) return;
+    it->second->resuming = true;
+    Wake();
+}
+
+void FileWatcher::Remove(uint64_t id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = watches_.find(id);
+    if (it == watches_.end()) return;
+    ReleaseDescriptors(*it->second, id);
+    watches_.erase(it);
+
+    if (std::this_thread::get_id() != threadId_) {
+        callbackDone_.wait(lock, [this, id]() { return calling_ != id; });
+    }
+}
+
+size_t FileWatcher::WatchCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return watches_.size();
+}
+
+void FileWatcher::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        for (auto& entry : watches_) {
+            ReleaseDescriptors(*entry.second, entry.first);
+        }
+        watches_.clear();
+        if (wakeFd_ >= 0) Wake();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void FileWatcher::Wake() {
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+    (void)ignored;
+}
+
+void FileWatcher::DrainEvents() {
+    alignas(struct inotify_event) char buffer[kEventBufferSize];
+    while (true) {
+        ssize_t bytesRead = read(inotifyFd_, buffer, sizeof(buffer));
+        if (bytesRead < 0 && errno == EINTR) continue;
+        if (bytesRead <= 0) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        for (char* p = buffer; p < buffer + bytesRead; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            // Events were lost; any watch could be affected
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (auto& entry : watches_) entry.second->Mark(now);
+                continue;
+            }
+
+            auto owners = owners_.find(event->wd);
+            if (owners == owners_.end()) continue;
+            for (uint64_t id : owners->second) {
+                auto it = watches_.find(id);
+                if (it == watches_.end()) continue;
+                it->second->Mark(now);
+                // The directory or file itself is gone along with its descriptor
+                if (event->mask & IN_IGNORED) {
+                    auto& descriptors = it->second->descriptors;
+                    descriptors.erase(std::remove(descriptors.begin(), descriptors.end(), event->wd),
+                                      descriptors.end());
+                }
+            }
+            if (event->mask & IN_IGNORED) owners_.erase(owners);
+        }
+    }
+}
+
+void FileWatcher::Loop() {
+    struct pollfd fds[2] = { { inotifyFd_, POLLIN, 0 }, { wakeFd_, POLLIN, 0 } };
+    std::vector<uint64_t> resuming;
+    std::vector<uint64_t> due;
+
+    while (true) {
+        int timeoutMs = -1;
+        resuming.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            Clock::time_point now = Clock::now();
+            for (const auto& entry : watches_) {
+                const Watch& watch = *entry.second;
+                if (watch.resuming) {
+                    resuming.push_back(entry.first);
+                } else if (watch.changed && !watch.suspended) {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(watch.Due() - now).count();
+                    int waitMs = static_cast<int>(std::max<long long>(0, wait));
+                    timeoutMs = timeoutMs < 0 ? waitMs : std::min(timeoutMs, waitMs);
+                }
+            }
+        }
+        if (!resuming.empty()) timeoutMs = 0;
+
+        if (poll(fds, 2, timeoutMs) < 0 && errno != EINTR) return;
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            ssize_t ignored = read(wakeFd_, &count, sizeof(count));
+            (void)ignored;
+        }
+
+        // Everything queued before Resume() was called is read here, while
+        // the watch is still suspended, and dropped
+        DrainEvents();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (uint64_t id : resuming) {
+            auto it = watches_.find(id);
+            if (it == watches_.end()) continue;
+            it->second->resuming = false;
+            it->second->suspended = false;
+            it->second->changed = false;
+        }
+
+        Clock::time_point now = Clock::now();
+        due.clear();
+        for (const auto& entry : watches_) {
+            const Watch& watch = *entry.second;
+            if (watch.changed && !watch.suspended && !watch.resuming && watch.Due() <= now) {
+                due.push_back(entry.first);
+            }
+        }
+
+        // One callback at a time, without the lock, so Remove() can wait for it
+        for (uint64_t id : due) {
+            auto it = watches_.find(id);
+            if (it == watches_.end()) continue;
+            Watch& watch = *it->second;
+            watch.changed = false;
+            watch.suspended = true;
+            watch.lastCall = now;
+            Callback onChange = watch.onChange;
+            calling_ = id;
+            lock.unlock();
+            onChange();
+            lock.lock();
+            calling_ = 0;
+            callbackDone_.notify_all();
+        }
+    }
+}
+
+} // namespace NeuroShell
+
+#else
+
+namespace NeuroShell {
+
+struct FileWatcher::Watch {};
+
+FileWatcher::FileWatcher()
+    : nextId_(1)
+    , calling_(0)
+    , stopping_(false)
+    , inotifyFd_(-1)
+    , wakeFd_(-1)
+{
+}
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::IsSupported() {
+    return false;
+}
+
+FileWatcher& FileWatcher::Shared() {
+    static FileWatcher watcher;
+    return watcher;
+}
+
+uint64_t FileWatcher::Add(const std::vector<std::string>&, Callback, int, int) {
+    return 0;
+}
+
+void FileWatcher::Resume(uint64_t) {
+}
+
+void FileWatcher::Remove(uint64_t) {
+}
+
+size_t FileWatcher::WatchCount() const {
+    return 0;
+}
+
+void FileWatcher::Shutdown() {
+}
+
+} // namespace NeuroShell
+
+#endif // __linux__
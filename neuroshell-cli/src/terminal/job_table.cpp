@@ -0,0 +1,162 @@
+#include "terminal/job_table.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <iomanip>
+#include <csignal>
+
+namespace NeuroShell {
+
+int JobTable::Add(uint64_t blockId, const std::string& command, JobState state) {
+    int number = jobs_.empty() ? 1 : jobs_.back().number + 1;
+    jobs_.push_back(Job{ number, blockId, command, state, 0 });
+    MakeCurrent(number);
+    return number;
+}
+
+void JobTable::Remove(int number) {
+    jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+        [number](const Job& job) { return job.number == number; }), jobs_.end());
+    recent_.erase(std::remove(recent_.begin(), recent_.end(), number), recent_.end());
+}
+
+Job* JobTable::Find(int number) {
+    for (auto& job : jobs_) {
+        if (job.number == number) return &job;
+    }
+    return nullptr;
+}
+
+Job* JobTable::FindByBlock(uint64_t blockId) {
+    for (auto& job : jobs_) {
+        if (job.blockId == blockId) return &job;
+    }
+    return nullptr;
+}
+
+Job* JobTable::Resolve(const std::string& spec) {
+    bool percent = !spec.empty() && spec[0] == '%';
+    std::string name = percent ? spec.substr(1) : spec;
+
+    if (name.empty() || name == "%" || name == "+") {
+        return recent_.empty() ? nullptr : Find(recent_.back());
+    }
+    if (name == "-") {
+        return recent_.size() < 2 ? nullptr : Find(recent_[recent_.size() - 2]);
+    }
+    if (std::all_of(name.begin(), name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+        return name.size() > 9 ? nullptr : Find(std::stoi(name));
+    }
+    // Only a bare number works without the %
+    if (!percent) return nullptr;
+
+    bool contains = name[0] == '?';
+    std::string text = contains ? name.substr(1) : name;
+    Job* match = nullptr;
+    for (auto& job : jobs_) {
+        bool matches = contains ? job.command.find(text) != std::string::npos
+                                : job.command.compare(0, text.size(), text) == 0;
+        if (!matches) continue;
+        if (match) return nullptr;
+        match = &job;
+    }
+    return match;
+}
+
+void JobTable::SetState(int number, JobState state) {
+    Job* job = Find(number);
+    if (!job) return;
+    job->state = state;
+    if (state == JobState::Done) {
+        recent_.erase(std::remove(recent_.begin(), recent_.end(), number), recent_.end());
+    } else {
+        MakeCurrent(number);
+    }
+}
+
+void JobTable::Finish(uint64_t blockId, int exitCode) {
+    Job* job = FindByBlock(blockId);
+    if (!job) return;
+    job->exitCode = exitCode;
+    SetState(job->number, JobState::Done);
+}
+
+char JobTable::Marker(int number) const {
+    if (!recent_.empty() && recent_.back() == number) return '+';
+    if (recent_.size() >= 2 && recent_[recent_.size() - 2] == number) return '-';
+    return ' ';
+}
+
+std::string JobTable::Reap() {
+    std::ostringstream listing;
+    for (const auto& job : jobs_) {
+        std::string state = job.state == JobState::Running ? "Running"
+                          : job.state == JobState::Stopped ? "Stopped"
+                          : job.exitCode == 0 ? "Done" : "Exit " + std::to_string(job.exitCode);
+        listing << "[" << job.number << "]" << Marker(job.number) << "  "
+                << std::left << std::setw(24) << state << job.command
+                << (job.state == JobState::Running ? " &" : "") << "\n";
+    }
+    jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+        [](const Job& job) { return job.state == JobState::Done; }), jobs_.end());
+    return listing.str();
+}
+
+bool JobTable::SplitBackground(const std::string& command, std::string& stripped) {
+    size_t end = command.find_last_not_of(" \t\r\n");
+    if (end == std::string::npos || end == 0 || command[end] != '&') return false;
+
+    // Skip quoted text and escapes to see whether that & is an operator
+    char quote = 0;
+    for (size_t i = 0; i < end; ++i) {
+        char c = command[i];
+        if (quote == '\'') {
+            if (c == '\'') quote = 0;
+        } else if (c == '\\') {
+            if (i + 1 == end) return false;
+            ++i;
+        } else if (quote == '"') {
+            if (c == '"') quote = 0;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        }
+    }
+    if (quote != 0) return false;
+
+    // &&, >&, <& and |& are other operators
+    if (std::string("&><|").find(command[end - 1]) != std::string::npos) return false;
+
+    size_t last = command.find_last_not_of(" \t\r\n", end - 1);
+    if (last == std::string::npos) return false;
+    stripped = command.substr(0, last + 1);
+    return true;
+}
+
+int JobTable::SignalNumber(const std::string& name) {
+    if (!name.empty() && name.size() <= 2 &&
+        std::all_of(name.begin(), name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+        return std::stoi(name);
+    }
+
+    static const std::pair<const char*, int> kSignals[] = {
+        { "INT", SIGINT }, { "TERM", SIGTERM },
+#ifndef _WIN32
+        { "HUP", SIGHUP }, { "QUIT", SIGQUIT }, { "KILL", SIGKILL }, { "USR1", SIGUSR1 },
+        { "USR2", SIGUSR2 }, { "CONT", SIGCONT }, { "STOP", SIGSTOP }, { "TSTP", SIGTSTP },
+#endif
+    };
+    std::string upper;
+    for (char c : name) upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    if (upper.compare(0, 3, "SIG") == 0) upper.erase(0, 3);
+    for (const auto& entry : kSignals) {
+        if (upper == entry.first) return entry.second;
+    }
+    return -1;
+}
+
+void JobTable::MakeCurrent(int number) {
+    recent_.erase(std::remove(recent_.begin(), recent_.end(), number), recent_.end());
+    recent_.push_back(number);
+}
+
+} // namespace NeuroShell
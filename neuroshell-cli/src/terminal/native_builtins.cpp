@@ -0,0 +1,237 @@
+#include "terminal/native_builtins.h"
+#include "terminal/command_lexer.h"
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <pwd.h>
+#include <limits.h>
+
+extern char** environ;
+#endif
+
+namespace NeuroShell {
+
+#ifndef _WIN32
+namespace {
+
+// Output that depends on the locale only matches in the C locale, which is
+// what the builtins produce
+bool UsesCLocale() {
+    const char* names[] = { "LC_ALL", "LC_TIME", "LANG" };
+    for (const char* name : names) {
+        const char* value = std::getenv(name);
+        if (value && *value) {
+            return std::strcmp(value, "C") == 0 || std::strcmp(value, "POSIX") == 0 ||
+                   std::strncmp(value, "C.", 2) == 0;
+        }
+    }
+    return true;
+}
+
+// --help and --version alone are answered by the real program
+bool AsksForHelp(const std::vector<std::string>& argv) {
+    return argv.size() == 2 && (argv[1] == "--help" || argv[1] == "--version");
+}
+
+// GNU echo run as a program: leading words made only of -n, -e and -E are
+// options; backslash escapes (-e) are left to the real one
+int Echo(const BuiltinCall& call) {
+    const auto& argv = call.argv;
+    if (AsksForHelp(argv) || std::getenv("POSIXLY_CORRECT")) return BuiltinRegistry::kDeclined;
+
+    size_t i = 1;
+    bool newline = true;
+    for (; i < argv.size(); ++i) {
+        const std::string& word = argv[i];
+        if (word.size() < 2 || word[0] != '-' || word.find_first_not_of("neE", 1) != std::string::npos) break;
+        if (word.find('e') != std::string::npos) return BuiltinRegistry::kDeclined;
+        if (word.find('n') != std::string::npos) newline = false;
+    }
+
+    std::string text;
+    for (size_t first = i; i < argv.size(); ++i) {
+        if (i > first) text += ' ';
+        text += argv[i];
+    }
+    if (newline) text += '\n';
+    call.Write(OutputStream::Stdout, text);
+    return 0;
+}
+
+int Whoami(const BuiltinCall& call) {
+    if (call.argv.size() > 1) return BuiltinRegistry::kDeclined;
+    struct passwd entry;
+    struct passwd* found = nullptr;
+    char buffer[4096];
+    if (getpwuid_r(geteuid(), &entry, buffer, sizeof(buffer), &found) != 0 || !found) {
+        return BuiltinRegistry::kDeclined;
+    }
+    call.Write(OutputStream::Stdout, std::string(found->pw_name) + "\n");
+    return 0;
+}
+
+int Hostname(const BuiltinCall& call) {
+    if (call.argv.size() > 1) return BuiltinRegistry::kDeclined;
+    char name[HOST_NAME_MAX + 1] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0) return BuiltinRegistry::kDeclined;
+    call.Write(OutputStream::Stdout, std::string(name) + "\n");
+    return 0;
+}
+
+// date and date +FORMAT, for formats strftime() expands the same way
+int Date(const BuiltinCall& call) {
+    const auto& argv = call.argv;
+    if (argv.size() > 2 || !UsesCLocale()) return BuiltinRegistry::kDeclined;
+
+    std::string format = "%a %b %e %H:%M:%S %Z %Y";
+    if (argv.size() == 2) {
+        if (argv[1].empty() || argv[1][0] != '+') return BuiltinRegistry::kDeclined;
+        format = argv[1].substr(1);
+        // GNU-only conversions: nanoseconds, numeric zones with colons, quarters
+        if (format.find("%N") != std::string::npos || format.find("%:") != std::string::npos ||
+            format.find("%q") != std::string::npos) {
+            return BuiltinRegistry::kDeclined;
+        }
+    }
+
+    time_t now = std::time(nullptr);
+    struct tm local;
+    if (!localtime_r(&now, &local)) return BuiltinRegistry::kDeclined;
+
+    // A trailing space tells an empty result from a buffer that was too small
+    format += ' ';
+    std::string text(format.size() + 64, '\0');
+    size_t length;
+    while ((length = std::strftime(&text[0], text.size(), format.c_str(), &local)) == 0) {
+        if (text.size() > 64 * 1024) return BuiltinRegistry::kDeclined;
+        text.resize(text.size() * 2);
+    }
+    text.resize(length - 1);
+    call.Write(OutputStream::Stdout, text + "\n");
+    return 0;
+}
+
+// which without options, for programs found through an absolute PATH entry
+int Which(const BuiltinCall& call) {
+    const auto& argv = call.argv;
+    if (argv.size() < 2) return BuiltinRegistry::kDeclined;
+
+    std::string text;
+    for (size_t i = 1; i < argv.size(); ++i) {
+        const std::string& program = argv[i];
+        if (program.empty() || program[0] == '-' || program.find('/') != std::string::npos) {
+            return BuiltinRegistry::kDeclined;
+        }
+        // Not found might just mean a relative PATH entry stopped the search
+        std::string path = PathCache::Instance().Resolve(program);
+        if (path.empty()) return BuiltinRegistry::kDeclined;
+        text += path + "\n";
+    }
+    call.Write(OutputStream::Stdout, text);
+    return 0;
+}
+
+std::string Environment() {
+    std::string text;
+    for (char** entry = environ; *entry != nullptr; ++entry) {
+        text += *entry;
+        text += '\n';
+    }
+    return text;
+}
+
+// env without arguments; with any it would run another program
+int Env(const BuiltinCall& call) {
+    if (call.argv.size() > 1) return BuiltinRegistry::kDeclined;
+    call.Write(OutputStream::Stdout, Environment());
+    return 0;
+}
+
+int Printenv(const BuiltinCall& call) {
+    const auto& argv = call.argv;
+    if (argv.size() == 1) {
+        call.Write(OutputStream::Stdout, Environment());
+        return 0;
+    }
+
+    std::string text;
+    int exitCode = 0;
+    for (size_t i = 1; i < argv.size(); ++i) {
+        const std::string& name = argv[i];
+        if (name.empty() || name[0] == '-') return BuiltinRegistry::kDeclined;
+        const char* value = name.find('=') == std::string::npos ? std::getenv(name.c_str()) : nullptr;
+        if (value) {
+            text += value;
+            text += '\n';
+        } else {
+            exitCode = 1;
+        }
+    }
+    call.Write(OutputStream::Stdout, text);
+    return exitCode;
+}
+
+} // namespace
+#endif
+
+BuiltinRegistry::BuiltinRegistry() {
+    RegisterStandard();
+}
+
+void BuiltinRegistry::RegisterStandard() {
+#ifndef _WIN32
+    // cmd.exe has its own idea of these, so Windows keeps running them for real
+    Register("echo", Echo);
+    Register("true", [](const BuiltinCall& call) { return AsksForHelp(call.argv) ? kDeclined : 0; });
+    Register("false", [](const BuiltinCall& call) { return AsksForHelp(call.argv) ? kDeclined : 1; });
+    Register("whoami", Whoami);
+    Register("hostname", Hostname);
+    Register("date", Date);
+    Register("which", Which);
+    Register("env", Env);
+    Register("printenv", Printenv);
+#endif
+}
+
+void BuiltinRegistry::Register(const std::string& name, Handler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_[name] = std::move(handler);
+}
+
+bool BuiltinRegistry::IsBuiltin(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return handlers_.count(name) > 0;
+}
+
+bool BuiltinRegistry::Run(const std::string& command, const WorkingDirectory& workingDir,
+                          const BuiltinCall::OutputCallback& onOutput, int& exitCode) const {
+    // Anything the shell would interpret still goes to the shell
+    std::vector<std::string> argv;
+    if (!CommandLexer::SplitSimple(command, argv) || argv.empty()) {
+        return false;
+    }
+
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = handlers_.find(argv[0]);
+        if (it == handlers_.end()) return false;
+        handler = it->second;
+    }
+
+    BuiltinCall call = { argv, workingDir, onOutput };
+    int result = handler(call);
+    if (result == kDeclined) return false;
+    exitCode = result;
+    return true;
+}
+
+BuiltinRegistry& BuiltinRegistry::Shared() {
+    static BuiltinRegistry registry;
+    return registry;
+}
+
+} // namespace NeuroShell
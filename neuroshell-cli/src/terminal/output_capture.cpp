@@ -0,0 +1,83 @@
+#include "terminal/output_capture.h"
+
+#ifndef _WIN32
+
+#include <vector>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+
+namespace NeuroShell {
+
+namespace {
+
+// Large enough to drain a full pipe buffer in one read
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+} // namespace
+
+void OutputCapture::Drain(ChildProcess& child, const ChunkCallback& onChunk, CancelToken* cancel) {
+    std::vector<char> buffer(kReadChunkSize);
+
+    // stdout, stderr, the stderr of a pipeline's earlier stages, and last a
+    // slot that wakes us for a cancel request until one has been seen
+    std::vector<struct pollfd> fds = { { child.stdoutFd, POLLIN, 0 }, { child.stderrFd, POLLIN, 0 } };
+    for (int fd : child.stageStderrFds) {
+        fds.push_back({ fd, POLLIN, 0 });
+    }
+    fds.push_back({ cancel ? cancel->GetWakeFd() : -1, POLLIN, 0 });
+    const size_t streamCount = fds.size() - 1;
+    auto signalGroup = [&child](int signal) { SignalProcessGroup(child, signal); };
+
+    // poll() ignores negative descriptors, so a closed stream simply drops out
+    size_t open = 0;
+    for (size_t i = 0; i < streamCount; ++i) {
+        if (fds[i].fd >= 0) open++;
+    }
+
+    while (open > 0) {
+        int timeoutMs = -1;
+        if (cancel) {
+            timeoutMs = cancel->Advance(signalGroup);
+            if (cancel->IsCancelled()) fds[streamCount].fd = -1;
+        }
+
+        if (poll(fds.data(), fds.size(), timeoutMs) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (size_t i = 0; i < streamCount; ++i) {
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+
+            ssize_t bytesRead = read(fds[i].fd, buffer.data(), buffer.size());
+            if (bytesRead > 0) {
+                size_t size = static_cast<size_t>(bytesRead);
+                if (i > 0 && !child.stages.empty()) {
+                    KeepStageStderr(child, i == 1 ? child.stages.size() - 1 : i - 2, buffer.data(), size);
+                }
+                if (onChunk) onChunk(i == 0 ? OutputStream::Stdout : OutputStream::Stderr, buffer.data(), size);
+                continue;
+            }
+            if (bytesRead < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                continue;
+            }
+
+            // EOF (every writer has exited) or a hard error
+            close(fds[i].fd);
+            fds[i].fd = -1;
+            open--;
+        }
+    }
+
+    for (size_t i = 0; i < streamCount; ++i) {
+        if (fds[i].fd >= 0) close(fds[i].fd);
+    }
+    child.stdoutFd = -1;
+    child.stderrFd = -1;
+    child.stageStderrFds.clear();
+}
+
+} // namespace NeuroShell
+
+#endif // _WIN32
@@ -0,0 +1,110 @@
+#include "terminal/output_throttle.h"
+#include <algorithm>
+
+namespace NeuroShell {
+
+OutputThrottle::OutputThrottle(double floodBytesPerSecond)
+    : queuedBytes_(0)
+    , batchBytes_(1024 * 1024)
+    , floodBytesPerSecond_(floodBytesPerSecond)
+    , lastPublish_()
+    , lastChunk_()
+    , windowStart_(Clock::now())
+    , windowBytes_(0)
+    , bytesPerSecond_(0.0)
+    , flooding_(false)
+{}
+
+bool OutputThrottle::Add(OutputStream stream, const char* data, size_t size, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size > 0) {
+        if (!queued_.empty() && queued_.back().stream == stream && queued_.back().data.size() < kChunkBytes) {
+            queued_.back().data.append(data, size);
+        } else {
+            queued_.push_back({ stream, std::string(data, size) });
+        }
+        queuedBytes_ += size;
+        windowBytes_ += size;
+        lastChunk_ = now;
+    }
+    UpdateRate(now);
+
+    if (queued_.empty()) return false;
+    auto sincePublish = now - lastPublish_;
+    return sincePublish >= kFrameInterval ||
+           (queuedBytes_ >= batchBytes_ && sincePublish >= kCatchUpGap) ||
+           queuedBytes_ >= kMaxQueuedBytes;
+}
+
+bool OutputThrottle::Stranded(Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (!queued_.empty() || flooding_) && now - lastChunk_ >= kFrameInterval;
+}
+
+bool OutputThrottle::Empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_.empty();
+}
+
+bool OutputThrottle::Full() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queuedBytes_ >= kMaxQueuedBytes;
+}
+
+std::vector<OutputThrottle::Chunk> OutputThrottle::Take(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Chunk> batch;
+    size_t bytes = 0;
+    while (!queued_.empty() && (batch.empty() || bytes + queued_.front().data.size() <= batchBytes_)) {
+        bytes += queued_.front().data.size();
+        batch.push_back(std::move(queued_.front()));
+        queued_.pop_front();
+    }
+    queuedBytes_ -= bytes;
+    lastPublish_ = now;
+    UpdateRate(now);
+    return batch;
+}
+
+void OutputThrottle::Published(size_t bytes, Clock::duration elapsed, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lastPublish_ = now;
+
+    // Small batches time mostly overhead; leave the size alone
+    if (bytes < kMinBatchBytes) return;
+    double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-6);
+    double target = bytes / seconds * std::chrono::duration<double>(kPublishBudget).count();
+    target = std::min(std::max(target, static_cast<double>(kMinBatchBytes)), static_cast<double>(kMaxBatchBytes));
+    batchBytes_ = (batchBytes_ + static_cast<size_t>(target)) / 2;
+}
+
+size_t OutputThrottle::BatchBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batchBytes_;
+}
+
+double OutputThrottle::BytesPerSecond() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesPerSecond_;
+}
+
+bool OutputThrottle::Flooding() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flooding_;
+}
+
+void OutputThrottle::UpdateRate(Clock::time_point now) {
+    auto elapsed = now - windowStart_;
+    if (elapsed < kRateWindow) return;
+
+    bytesPerSecond_ = windowBytes_ / std::chrono::duration<double>(elapsed).count();
+    if (bytesPerSecond_ >= floodBytesPerSecond_) {
+        flooding_ = true;
+    } else if (bytesPerSecond_ < floodBytesPerSecond_ / 2) {
+        flooding_ = false;
+    }
+    windowStart_ = now;
+    windowBytes_ = 0;
+}
+
+} // namespace NeuroShell
@@ -0,0 +1,538 @@
+#include "terminal/process.h"
+#include "terminal/spawn_zygote.h"
+#include "terminal/command_lexer.h"
+
+#ifndef _WIN32
+
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#ifdef __linux__
+#include <thread>
+#include <sys/syscall.h>
+#endif
+
+extern char** environ;
+
+namespace NeuroShell {
+
+namespace {
+
+// Create a pipe whose ends are close-on-exec, so concurrent spawns don't inherit them
+bool MakePipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+void SetNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// How often a cancellable wait checks whether a child it has no pidfd for has gone
+constexpr int kExitPollMs = 50;
+
+// pidfd_open() arrived in Linux 5.3; older kernels (and other systems) fall back to polling
+int OpenPidFd(int pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+void ClosePipe(int fds[2]) {
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Child side of ForkChild: only async-signal-safe calls between fork and exec.
+// Failures are reported as an errno through statusFd.
+[[noreturn]] void RunChild(const SpawnOptions& options, const char* path, char* const argv[],
+                           int inFd, int outFd, int errFd, int processGroup, int statusFd,
+                           const ProcessPriority& priority) {
+    int error = 0;
+    if (options.cgroupProcsFd >= 0) {
+        // "0" moves the writer, so everything exec'd from here starts inside the leaf
+        if (write(options.cgroupProcsFd, "0", 1) != 1) error = errno;
+    } else {
+        if (options.limits.memoryMaxBytes > 0) {
+            struct rlimit limit;
+            limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(options.limits.memoryMaxBytes);
+            setrlimit(RLIMIT_AS, &limit);
+        }
+    }
+
+    if (error == 0) {
+        ApplyPriority(priority);
+        setpgid(0, processGroup);
+        sigset_t emptyMask;
+        sigemptyset(&emptyMask);
+        sigprocmask(SIG_SETMASK, &emptyMask, nullptr);
+        struct sigaction action = {};
+        action.sa_handler = SIG_DFL;
+        sigaction(SIGPIPE, &action, nullptr);
+
+        int nullFd = inFd >= 0 ? inFd : open("/dev/null", O_RDONLY);
+        if (nullFd < 0 || dup2(nullFd, STDIN_FILENO) < 0 ||
+            dup2(outFd, STDOUT_FILENO) < 0 || dup2(errFd, STDERR_FILENO) < 0) {
+            error = errno;
+        } else if (options.workingDirFd >= 0 ? fchdir(options.workingDirFd) != 0
+                   : !options.workingDir.empty() && chdir(options.workingDir.c_str()) != 0) {
+            error = errno;
+        } else {
+            execve(path, argv, environ);
+            error = errno;
+        }
+    }
+
+    ssize_t ignored = write(statusFd, &error, sizeof(error));
+    (void)ignored;
+    _exit(127);
+}
+
+// fork() and exec with limits and priority applied in between, which posix_spawn can't do.
+// Returns 0 or the errno of whatever failed in the child.
+int ForkChild(const SpawnOptions& options, char* const argv[], int inFd, int outFd, int errFd,
+              pid_t processGroup, pid_t& pid) {
+    // Everything that allocates happens before the fork
+    std::string path = PathCache::Instance().Resolve(options.argv[0]);
+    if (path.empty()) return ENOENT;
+    // Without a cgroup the CPU weight becomes a nice value; the lower priority wins
+    ProcessPriority priority = options.limits.priority;
+    if (options.cgroupProcsFd < 0) {
+        priority.nice = std::max(priority.nice, NiceForWeight(options.limits.cpuWeight));
+    }
+
+    // Closed by a successful exec, so EOF with nothing read means the child is running
+    int statusPipe[2];
+    if (!MakePipe(statusPipe)) return errno;
+
+    pid = fork();
+    if (pid == 0) {
+        close(statusPipe[0]);
+        RunChild(options, path.c_str(), argv, inFd, outFd, errFd, processGroup, statusPipe[1], priority);
+    }
+    int forkError = pid < 0 ? errno : 0;
+    close(statusPipe[1]);
+    if (forkError != 0) {
+        close(statusPipe[0]);
+        return forkError;
+    }
+
+    int childError = 0;
+    ssize_t got;
+    while ((got = read(statusPipe[0], &childError, sizeof(childError))) < 0 && errno == EINTR) {}
+    close(statusPipe[0]);
+    if (got == static_cast<ssize_t>(sizeof(childError))) {
+        waitpid(pid, nullptr, 0);
+        return childError != 0 ? childError : ECHILD;
+    }
+    return 0;
+}
+
+// posix_spawn() half of StartChild. Returns 0 or an errno.
+int PosixSpawnChild(const SpawnOptions& options, char* const argv[], int inFd, int outFd, int errFd,
+                    pid_t processGroup, pid_t& pid) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (inFd >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, inFd, STDIN_FILENO);
+    } else {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+    posix_spawn_file_actions_adddup2(&actions, outFd, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, errFd, STDERR_FILENO);
+    // Switch directories in the child; ours never changes
+    if (options.workingDirFd >= 0) {
+        posix_spawn_file_actions_addfchdir_np(&actions, options.workingDirFd);
+    } else if (!options.workingDir.empty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, options.workingDir.c_str());
+    }
+
+    // Children start with default signal handling regardless of what the UI process ignores
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t emptyMask, defaultSignals;
+    sigemptyset(&emptyMask);
+    sigemptyset(&defaultSignals);
+    sigaddset(&defaultSignals, SIGPIPE);
+    posix_spawnattr_setsigmask(&attr, &emptyMask);
+    posix_spawnattr_setsigdefault(&attr, &defaultSignals);
+    posix_spawnattr_setpgroup(&attr, processGroup);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    int error = posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return error;
+}
+
+// Start options.argv with inFd (-1 = /dev/null), outFd and errFd as its standard
+// streams, in processGroup (0 = lead a new one). Returns 0 or an errno.
+int StartChild(const SpawnOptions& options, char* const argv[], int inFd, int outFd, int errFd,
+               pid_t processGroup, pid_t& pid) {
+    if (options.cgroupProcsFd >= 0 || options.limits.Any()) {
+        return ForkChild(options, argv, inFd, outFd, errFd, processGroup, pid);
+    }
+    if (!options.limits.priority.Any()) {
+        return PosixSpawnChild(options, argv, inFd, outFd, errFd, processGroup, pid);
+    }
+
+#ifdef __linux__
+    // Nice value, I/O priority and scheduling policy are per thread on Linux and
+    // a spawned child inherits the calling thread's. So a short-lived thread
+    // lowers itself and spawns: the child runs lowered from its first
+    // instruction, and nothing the size of the UI process is forked.
+    int error = 0;
+    std::thread spawner([&]() {
+        ApplyPriority(options.limits.priority);
+        error = PosixSpawnChild(options, argv, inFd, outFd, errFd, processGroup, pid);
+    });
+    spawner.join();
+    return error;
+#else
+    // Elsewhere nice applies to the whole process, so only a child can take it
+    return ForkChild(options, argv, inFd, outFd, errFd, processGroup, pid);
+#endif
+}
+
+std::vector<char*> ArgvPointers(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    return argv;
+}
+
+bool HasPidExited(int pid) {
+    siginfo_t info = {};
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid != 0;
+}
+
+// Block until pid exits and collect it
+ProcessExit ReapChild(int pid, std::chrono::steady_clock::time_point startTime) {
+    int status = 0;
+    struct rusage usage = {};
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) return ProcessExit();
+    }
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    return MakeProcessExit(status, usage, elapsed.count());
+}
+
+} // namespace
+
+std::vector<std::string> ShellArgv(const std::string& command) {
+    return { "/bin/sh", "-c", command };
+}
+
+ChildProcess SpawnProcess(const SpawnOptions& options) {
+    if (options.argv.empty()) {
+        throw std::runtime_error("No program to execute");
+    }
+
+    int outPipe[2];
+    int errPipe[2];
+    if (!MakePipe(outPipe)) {
+        throw std::runtime_error("Failed to create output pipe");
+    }
+    if (!MakePipe(errPipe)) {
+        ClosePipe(outPipe);
+        throw std::runtime_error("Failed to create error pipe");
+    }
+
+    std::vector<char*> argv = ArgvPointers(options.argv);
+    pid_t pid = -1;
+    int spawnError = StartChild(options, argv.data(), -1, outPipe[1], errPipe[1], 0, pid);
+
+    close(outPipe[1]);
+    close(errPipe[1]);
+
+    if (spawnError != 0) {
+        close(outPipe[0]);
+        close(errPipe[0]);
+        throw std::runtime_error("Failed to execute command");
+    }
+
+    ChildProcess child;
+    child.pid = pid;
+    child.startTime = std::chrono::steady_clock::now();
+    child.stdoutFd = outPipe[0];
+    child.stderrFd = errPipe[0];
+    SetNonBlocking(child.stdoutFd);
+    SetNonBlocking(child.stderrFd);
+    return child;
+}
+
+ChildProcess SpawnPipeline(const std::vector<std::string>& stages, const SpawnOptions& options) {
+    std::vector<std::vector<std::string>> stageArgs;
+    for (const auto& stage : stages) {
+        std::vector<std::string> args;
+        if (!CommandLexer::SplitSimple(stage, args)) {
+            throw std::runtime_error("Not a simple command: " + stage);
+        }
+        std::string program = PathCache::Instance().Resolve(args[0]);
+        if (program.empty()) {
+            throw std::runtime_error("Command not found: " + args[0]);
+        }
+        args[0] = program;
+        stageArgs.push_back(std::move(args));
+    }
+    if (stageArgs.size() < 2) {
+        throw std::runtime_error("Not a pipeline");
+    }
+
+    // Each stage reads the previous one's stdout pipe directly; we only hold
+    // the read end until the next stage has it
+    ChildProcess child;
+    child.startTime = std::chrono::steady_clock::now();
+    std::vector<int> stderrFds;
+    int input = -1;
+    std::string failure;
+    for (size_t i = 0; i < stageArgs.size() && failure.empty(); ++i) {
+        int outPipe[2];
+        int errPipe[2];
+        if (!MakePipe(outPipe)) {
+            failure = "Failed to create output pipe";
+            break;
+        }
+        if (!MakePipe(errPipe)) {
+            ClosePipe(outPipe);
+            failure = "Failed to create error pipe";
+            break;
+        }
+
+        SpawnOptions stageOptions = options;
+        stageOptions.argv = stageArgs[i];
+        std::vector<char*> argv = ArgvPointers(stageOptions.argv);
+        pid_t pid = -1;
+        int error = StartChild(stageOptions, argv.data(), input, outPipe[1], errPipe[1],
+                               child.stagePids.empty() ? 0 : child.stagePids[0], pid);
+        close(outPipe[1]);
+        close(errPipe[1]);
+        if (input >= 0) close(input);
+        input = outPipe[0];
+        stderrFds.push_back(errPipe[0]);
+        if (error != 0) {
+            failure = "Failed to execute " + stages[i];
+            break;
+        }
+        child.stagePids.push_back(pid);
+    }
+
+    if (!failure.empty()) {
+        // Don't leave the stages already started waiting on a pipe nobody feeds
+        if (!child.stagePids.empty()) killpg(child.stagePids[0], SIGKILL);
+        for (int pid : child.stagePids) {
+            ReapChild(pid, child.startTime);
+        }
+        if (input >= 0) close(input);
+        for (int fd : stderrFds) {
+            close(fd);
+        }
+        throw std::runtime_error(failure);
+    }
+
+    child.pid = child.stagePids[0];
+    child.stdoutFd = input;
+    child.stderrFd = stderrFds.back();
+    child.stageStderrFds.assign(stderrFds.begin(), stderrFds.end() - 1);
+    SetNonBlocking(child.stdoutFd);
+    for (int fd : stderrFds) {
+        SetNonBlocking(fd);
+    }
+    child.stages.resize(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+        child.stages[i].command = stages[i];
+    }
+    return child;
+}
+
+ChildProcess SpawnCommand(const std::string& command, const WorkingDirectory& workingDir,
+                          const ResourceLimits& limits, const CommandCgroup* cgroup) {
+    SpawnOptions options;
+    options.workingDir = workingDir.Path();
+    options.workingDirFd = workingDir.Fd();
+    options.limits = limits;
+    options.cgroupProcsFd = cgroup ? cgroup->ProcsFd() : -1;
+    // The zygote's children are forked from it, where our limits can't reach;
+    // a priority travels with the request and the zygote applies it
+    bool useZygote = SpawnZygote::IsRunning() && options.cgroupProcsFd < 0 && !limits.Any();
+    
+    // Skip the shell when it would only have split the words
+    std::vector<std::string> argv;
+    if (CommandLexer::SplitSimple(command, argv)) {
+        std::string program = PathCache::Instance().Resolve(argv[0]);
+        if (!program.empty()) {
+            argv[0] = program;
+            options.argv = argv;
+            try {
+                return useZygote ? SpawnZygote::Spawn(options) : SpawnProcess(options);
+            } catch (const std::exception&) {
+                // Let the shell report why it can't run (bad interpreter, permissions, ...)
+            }
+        }
+    }
+    
+    // Or when it would only have connected simple commands with pipes
+    std::vector<std::string> stages;
+    if (CommandLexer::SplitPipeline(command, stages)) {
+        try {
+            return SpawnPipeline(stages, options);
+        } catch (const std::exception&) {
+            // As above: a missing program is for the shell to report
+        }
+    }
+    
+    options.argv = ShellArgv(command);
+    return useZygote ? SpawnZygote::Spawn(options) : SpawnProcess(options);
+}
+
+void KeepStageStderr(ChildProcess& child, size_t stage, const char* data, size_t size) {
+    if (stage >= child.stages.size()) return;
+    std::string& head = child.stages[stage].stderrHead;
+    head.append(data, std::min(size, kStageStderrBytes - std::min(kStageStderrBytes, head.size())));
+}
+
+bool HasExited(const ChildProcess& child) {
+    if (child.viaZygote) {
+        return SpawnZygote::HasExited(child);
+    }
+    if (!child.stagePids.empty()) {
+        return std::all_of(child.stagePids.begin(), child.stagePids.end(), HasPidExited);
+    }
+    return HasPidExited(child.pid);
+}
+
+ProcessExit WaitForExit(const ChildProcess& child, CancelToken* cancel) {
+    // A child can close its output and keep running; keep escalating until it exits
+    if (cancel) {
+        auto signalGroup = [&child](int signal) { SignalProcessGroup(child, signal); };
+        
+        // Sleep on the token's wake fd and a pidfd per process, so an exit or a
+        // cancel wakes us at once; without pidfds, check back every kExitPollMs
+        std::vector<int> pids = child.stagePids.empty() ? std::vector<int>{ child.pid } : child.stagePids;
+        std::vector<int> pidFds;
+        for (int pid : pids) {
+            pidFds.push_back(OpenPidFd(pid));
+        }
+        bool exitFds = std::find(pidFds.begin(), pidFds.end(), -1) == pidFds.end();
+        
+        for (;;) {
+            if (HasExited(child)) break;
+            
+            int waitMs = cancel->Advance(signalGroup);
+            bool cancelled = cancel->IsCancelled();
+            // SIGKILL is out and nothing is left to escalate: the reap below blocks
+            if (cancelled && waitMs < 0) break;
+            if (!exitFds && (waitMs < 0 || waitMs > kExitPollMs)) {
+                waitMs = kExitPollMs;
+            }
+            
+            std::vector<struct pollfd> fds;
+            // It stays readable once cancelled, and Advance() has the schedule from then on
+            if (!cancelled && cancel->GetWakeFd() >= 0) {
+                fds.push_back({ cancel->GetWakeFd(), POLLIN, 0 });
+            }
+            size_t watching = 0;
+            for (size_t i = 0; i < pidFds.size(); ++i) {
+                // A pipeline's finished stages would keep waking us
+                if (pidFds[i] < 0 || (pids.size() > 1 && HasPidExited(pids[i]))) continue;
+                fds.push_back({ pidFds[i], POLLIN, 0 });
+                watching++;
+            }
+            // Every stage exited since HasExited() looked
+            if (exitFds && watching == 0) continue;
+            
+            while (poll(fds.data(), fds.size(), waitMs) < 0 && errno == EINTR) {}
+            // A zygote child exits before the zygote reports it; its Wait() blocks for that
+            if (pids.size() == 1 && watching == 1 && (fds.back().revents & POLLIN)) break;
+        }
+        for (int fd : pidFds) {
+            if (fd >= 0) close(fd);
+        }
+        // Still a zombie, so its pid can't have been reused yet
+        cancel->Detach();
+    }
+    
+    if (child.viaZygote) {
+        return SpawnZygote::Wait(child);
+    }
+    if (child.stagePids.empty()) {
+        return ReapChild(child.pid, child.startTime);
+    }
+    
+    // A pipeline reports its last stage, like a shell, and uses what all of them did
+    ProcessExit result;
+    result.stages = child.stages;
+    result.stages.resize(child.stagePids.size());
+    for (size_t i = 0; i < child.stagePids.size(); ++i) {
+        ProcessExit stage = ReapChild(child.stagePids[i], child.startTime);
+        result.stages[i].exitCode = stage.exitCode;
+        result.stages[i].termSignal = stage.termSignal;
+        result.exitCode = stage.exitCode;
+        result.termSignal = stage.termSignal;
+        result.usage.userCpuSeconds += stage.usage.userCpuSeconds;
+        result.usage.systemCpuSeconds += stage.usage.systemCpuSeconds;
+        result.usage.maxRssKb = std::max(result.usage.maxRssKb, stage.usage.maxRssKb);
+        result.usage.blockReads += stage.usage.blockReads;
+        result.usage.blockWrites += stage.usage.blockWrites;
+        result.usage.voluntarySwitches += stage.usage.voluntarySwitches;
+        result.usage.involuntarySwitches += stage.usage.involuntarySwitches;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - child.startTime;
+    result.usage.wallSeconds = elapsed.count();
+    return result;
+}
+
+void SignalProcessGroup(const ChildProcess& child, int signal) {
+    if (child.pid > 0) {
+        killpg(child.pid, signal);
+    }
+}
+
+ProcessExit MakeProcessExit(int waitStatus, const struct rusage& usage, double wallSeconds) {
+    ProcessExit result;
+    result.usage.wallSeconds = wallSeconds;
+    result.usage.userCpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+    result.usage.systemCpuSeconds = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    result.usage.maxRssKb = usage.ru_maxrss / 1024;    // bytes on macOS
+#else
+    result.usage.maxRssKb = usage.ru_maxrss;
+#endif
+    result.usage.blockReads = usage.ru_inblock;
+    result.usage.blockWrites = usage.ru_oublock;
+    result.usage.voluntarySwitches = usage.ru_nvcsw;
+    result.usage.involuntarySwitches = usage.ru_nivcsw;
+    
+    if (WIFEXITED(waitStatus)) {
+        result.exitCode = WEXITSTATUS(waitStatus);
+    } else if (WIFSIGNALED(waitStatus)) {
+        result.termSignal = WTERMSIG(waitStatus);
+        result.exitCode = 128 + result.termSignal;
+    }
+    return result;
+}
+
+} // namespace NeuroShell
+
+#endif // _WIN32
@@ -0,0 +1,125 @@
+#include "terminal/process_priority.h"
+#include <sstream>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace NeuroShell {
+
+namespace {
+
+// From linux/ioprio.h, which not every libc ships
+constexpr int kIoprioClassShift = 13;
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassBestEffort = 2;
+constexpr int kIoprioClassIdle = 3;
+
+// Whole-string integer in [low, high]
+bool ParseNumber(const std::string& text, int low, int high, int& value) {
+    if (text.empty() || text.size() > 2) return false;
+    char* end = nullptr;
+    long number = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || number < low || number > high) return false;
+    value = static_cast<int>(number);
+    return true;
+}
+
+} // namespace
+
+bool ProcessPriority::Parse(const std::string& text, ProcessPriority& priority) {
+    ProcessPriority parsed;
+    std::istringstream words(text);
+    std::string word;
+    while (words >> word) {
+        size_t colon = word.find(':');
+        if (colon == std::string::npos) return false;
+        std::string name = word.substr(0, colon);
+        std::string value = word.substr(colon + 1);
+
+        if (name == "nice") {
+            if (!ParseNumber(value, 0, 19, parsed.nice)) return false;
+        } else if (name == "io") {
+            size_t level = value.find(':');
+            std::string ioClass = value.substr(0, level);
+            if (ioClass == "best-effort") {
+                parsed.ioClass = kIoprioClassBestEffort;
+                if (level != std::string::npos && !ParseNumber(value.substr(level + 1), 0, 7, parsed.ioLevel)) {
+                    return false;
+                }
+            } else if (ioClass == "idle" && level == std::string::npos) {
+                parsed.ioClass = kIoprioClassIdle;
+                parsed.ioLevel = 0;
+            } else if (ioClass != "none" || level != std::string::npos) {
+                return false;
+            }
+        } else if (name == "sched") {
+            if (value != "idle" && value != "normal") return false;
+            parsed.idleScheduling = value == "idle";
+        } else {
+            return false;
+        }
+    }
+    priority = parsed;
+    return true;
+}
+
+PriorityClasses::PriorityClasses() {
+    ProcessPriority& ai = classes_[static_cast<int>(CommandOrigin::AIBatch)];
+    ai.nice = 5;
+    ai.ioClass = kIoprioClassBestEffort;
+    ai.ioLevel = 5;
+
+    ProcessPriority& background = classes_[static_cast<int>(CommandOrigin::Background)];
+    background.nice = 10;
+    background.ioClass = kIoprioClassBestEffort;
+    background.ioLevel = 7;
+
+    ProcessPriority& speculative = classes_[static_cast<int>(CommandOrigin::Speculative)];
+    speculative.nice = 19;
+    speculative.ioClass = kIoprioClassIdle;
+    speculative.ioLevel = 0;
+    speculative.idleScheduling = true;
+}
+
+const ProcessPriority& PriorityClasses::For(CommandOrigin origin) const {
+    return classes_[static_cast<int>(origin)];
+}
+
+void PriorityClasses::Set(CommandOrigin origin, const ProcessPriority& priority) {
+    classes_[static_cast<int>(origin)] = priority;
+}
+
+bool PriorityClasses::FromName(const std::string& name, CommandOrigin& origin) {
+    if (name == "interactive") origin = CommandOrigin::Interactive;
+    else if (name == "ai") origin = CommandOrigin::AIBatch;
+    else if (name == "background") origin = CommandOrigin::Background;
+    else if (name == "speculative") origin = CommandOrigin::Speculative;
+    else return false;
+    return true;
+}
+
+#ifndef _WIN32
+void ApplyPriority(const ProcessPriority& priority) {
+    if (priority.nice > 0) {
+        setpriority(PRIO_PROCESS, 0, priority.nice);
+    }
+#ifdef __linux__
+    if (priority.ioClass != 0) {
+        syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, (priority.ioClass << kIoprioClassShift) | priority.ioLevel);
+    }
+    if (priority.idleScheduling) {
+        struct sched_param param = {};
+        sched_setscheduler(0, SCHED_IDLE, &param);
+    }
+#endif
+}
+#endif
+
+} // namespace NeuroShell
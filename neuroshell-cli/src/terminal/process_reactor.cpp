@@ -0,0 +1,476 @@
+#include "terminal/process_reactor.h"
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+
+namespace NeuroShell {
+
+namespace {
+
+// Event tags: child id in the high bits, what became ready in the low eight:
+// a stream (stdout, stderr, then the stderr of a pipeline's earlier stages),
+// the exit or a cancel request. Id 0 is the wake eventfd.
+constexpr int kTagBits = 8;
+constexpr int kStdout = 0;
+constexpr int kStderr = 1;
+constexpr int kExit = 254;
+constexpr int kCancel = 255;
+constexpr size_t kMaxStreams = kExit;
+
+uint64_t Tag(uint64_t id, int kind) {
+    return (id << kTagBits) | static_cast<uint64_t>(kind);
+}
+
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+// Chunks read from one stream before moving on to the next ready one
+constexpr int kReadsPerTurn = 4;
+
+constexpr int kMaxEvents = 256;
+
+// Exit polling interval for children we couldn't get a pidfd for
+constexpr int kExitPollMs = 50;
+
+// pidfd_open() arrived in Linux 5.3; older kernels fall back to polling
+int OpenPidFd(int pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+} // namespace
+
+struct ProcessReactor::Watched {
+    uint64_t id = 0;
+    ChildProcess child;
+    ChunkCallback onChunk;
+    ExitCallback onExit;
+    std::shared_ptr<CancelToken> cancel;
+    std::vector<int> fds;           // Streams by index, see Tag(); -1 once at EOF
+    std::vector<bool> ready;
+    int pidFd = -1;
+    bool exited = false;
+    bool watchingCancel = false;    // Cancel token's wake fd is registered
+    bool timed = false;             // Listed in timed_
+    int shutdownStep = 0;           // Shutdown() steps taken: 1 cancelled, 2 killed
+};
+
+ProcessReactor::ProcessReactor()
+    : active_(0)
+    , stopping_(false)
+    , epollFd_(epoll_create1(EPOLL_CLOEXEC))
+    , wakeFd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , stopSeen_(false)
+    , buffer_(kReadChunkSize)
+    , nextId_(1)
+{
+    if (epollFd_ >= 0 && wakeFd_ >= 0) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = Tag(0, 0);
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+    }
+}
+
+ProcessReactor::~ProcessReactor() {
+    Shutdown();
+    if (epollFd_ >= 0) close(epollFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+}
+
+bool ProcessReactor::IsSupported() {
+    return true;
+}
+
+ProcessReactor& ProcessReactor::Shared() {
+    static ProcessReactor reactor;
+    return reactor;
+}
+
+bool ProcessReactor::Watch(const ChildProcess& child, ChunkCallback onChunk, ExitCallback onExit,
+                           std::shared_ptr<CancelToken> cancel) {
+    if (epollFd_ < 0 || wakeFd_ < 0) return false;
+    if (child.stageStderrFds.size() + 2 > kMaxStreams) return false;
+
+    auto entry = std::make_unique<Watched>();
+    entry->child = child;
+    entry->onChunk = std::move(onChunk);
+    entry->onExit = std::move(onExit);
+    entry->cancel = std::move(cancel);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return false;
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ProcessReactor::Loop, this);
+        }
+        pending_.push_back(std::move(entry));
+        active_++;
+    }
+
+    uint64_t one = 1;
+    ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+    (void)ignored;
+    return true;
+}
+
+void ProcessReactor::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ProcessReactor::Register(std::unique_ptr<Watched> entry) {
+    entry->id = nextId_++;
+    entry->fds = { entry->child.stdoutFd, entry->child.stderrFd };
+    entry->fds.insert(entry->fds.end(), entry->child.stageStderrFds.begin(), entry->child.stageStderrFds.end());
+    entry->ready.assign(entry->fds.size(), false);
+
+    struct epoll_event event = {};
+    for (int stream = 0; stream < static_cast<int>(entry->fds.size()); ++stream) {
+        if (entry->fds[stream] < 0) continue;
+        event.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
+        event.data.u64 = Tag(entry->id, stream);
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, entry->fds[stream], &event);
+        // Output written before registration produces no edge; read once to find out
+        entry->ready[stream] = true;
+        readyStreams_.push_back({ entry->id, stream });
+    }
+
+    entry->pidFd = OpenPidFd(entry->child.pid);
+    if (entry->pidFd >= 0) {
+        event.events = EPOLLIN;
+        event.data.u64 = Tag(entry->id, kExit);
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, entry->pidFd, &event) != 0) {
+            close(entry->pidFd);
+            entry->pidFd = -1;
+        }
+    }
+
+    if (entry->cancel && entry->cancel->GetWakeFd() >= 0 && !entry->cancel->IsCancelled()) {
+        event.events = EPOLLIN;
+        event.data.u64 = Tag(entry->id, kCancel);
+        entry->watchingCancel = epoll_ctl(epollFd_, EPOLL_CTL_ADD, entry->cancel->GetWakeFd(), &event) == 0;
+    }
+
+    // The first Advance() starts any deadline; after that only wakes and due steps need one
+    uint64_t id = entry->id;
+    if (entry->cancel) {
+        entry->timed = true;
+        timed_.push_back(id);
+    }
+    if (entry->pidFd < 0) {
+        polling_.push_back(id);
+    }
+    watched_[id] = std::move(entry);
+}
+
+bool ProcessReactor::ReadStream(Watched& entry, int stream) {
+    OutputStream tag = stream == kStdout ? OutputStream::Stdout : OutputStream::Stderr;
+    ChildProcess& child = entry.child;
+    int& fd = entry.fds[stream];
+
+    for (int turn = 0; turn < kReadsPerTurn && fd >= 0; ++turn) {
+        ssize_t bytesRead = read(fd, buffer_.data(), buffer_.size());
+        if (bytesRead > 0) {
+            size_t size = static_cast<size_t>(bytesRead);
+            if (stream != kStdout && !child.stages.empty()) {
+                KeepStageStderr(child, stream == kStderr ? child.stages.size() - 1 : stream - 2, buffer_.data(), size);
+            }
+            if (entry.onChunk) entry.onChunk(tag, buffer_.data(), size);
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) continue;
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+
+        // EOF (every writer has exited) or a hard error; closing also unregisters it
+        close(fd);
+        fd = -1;
+    }
+    return fd >= 0;
+}
+
+int ProcessReactor::AdvanceCancel(Watched& entry) {
+    const ChildProcess& child = entry.child;
+    int waitMs = entry.cancel->Advance([&child](int signal) { SignalProcessGroup(child, signal); });
+
+    if (entry.cancel->IsCancelled()) {
+        if (entry.watchingCancel) {
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, entry.cancel->GetWakeFd(), nullptr);
+            entry.watchingCancel = false;
+        }
+    } else if (!entry.watchingCancel && (waitMs < 0 || waitMs > kExitPollMs)) {
+        // No wake fd to tell us about Cancel(), so check for it regularly
+        waitMs = kExitPollMs;
+    }
+    return waitMs;
+}
+
+bool ProcessReactor::TryFinish(Watched& entry) {
+    if (std::any_of(entry.fds.begin(), entry.fds.end(), [](int fd) { return fd >= 0; })) return false;
+
+    if (!entry.exited) {
+        if (entry.pidFd >= 0) return false;
+        entry.exited = HasExited(entry.child);
+        if (!entry.exited) return false;
+    }
+    // The pidfd only covers a pipeline's first stage; poll for the rest
+    if (!entry.child.stagePids.empty() && !HasExited(entry.child)) {
+        if (std::find(polling_.begin(), polling_.end(), entry.id) == polling_.end()) {
+            polling_.push_back(entry.id);
+        }
+        return false;
+    }
+
+    if (entry.pidFd >= 0) close(entry.pidFd);
+    if (entry.watchingCancel) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, entry.cancel->GetWakeFd(), nullptr);
+    }
+
+    // Already exited, so this doesn't block
+    entry.child.stdoutFd = -1;
+    entry.child.stderrFd = -1;
+    entry.child.stageStderrFds.clear();
+    ProcessExit exit = WaitForExit(entry.child, entry.cancel.get());
+    if (entry.onExit) entry.onExit(exit);
+    return true;
+}
+
+int ProcessReactor::AdvanceShutdown() {
+    auto now = std::chrono::steady_clock::now();
+    if (!stopSeen_) {
+        stopSeen_ = true;
+        stopStarted_ = now;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - stopStarted_).count();
+
+    if (elapsed >= kShutdownGiveUpMs) {
+        for (auto& item : watched_) {
+            Abandon(*item.second);
+            active_--;
+        }
+        watched_.clear();
+        return -1;
+    }
+
+    // Children handed over after the first step catch up on the ones they missed
+    int step = elapsed >= kShutdownKillMs ? 2 : 1;
+    for (auto& item : watched_) {
+        Watched& entry = *item.second;
+        if (entry.shutdownStep < 1) {
+            if (entry.cancel) {
+                entry.cancel->Cancel();
+                if (!entry.timed) {
+                    entry.timed = true;
+                    timed_.push_back(entry.id);
+                }
+            } else {
+                SignalProcessGroup(entry.child, SIGTERM);
+            }
+        }
+        if (entry.shutdownStep < 2 && step == 2) {
+            SignalProcessGroup(entry.child, SIGKILL);
+        }
+        entry.shutdownStep = step;
+    }
+    return static_cast<int>((step == 1 ? kShutdownKillMs : kShutdownGiveUpMs) - elapsed);
+}
+
+void ProcessReactor::Abandon(Watched& entry) {
+    // Closing also unregisters them; a grandchild may still hold the other ends
+    for (int& fd : entry.fds) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    if (entry.pidFd >= 0) close(entry.pidFd);
+    if (entry.watchingCancel) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, entry.cancel->GetWakeFd(), nullptr);
+    }
+
+    entry.child.stdoutFd = -1;
+    entry.child.stderrFd = -1;
+    entry.child.stageStderrFds.clear();
+    ProcessExit exit;
+    if (HasExited(entry.child)) {
+        exit = WaitForExit(entry.child, entry.cancel.get());
+    } else if (entry.cancel) {
+        // Left unreaped; nothing may signal its pid once it could be reused
+        entry.cancel->Detach();
+    }
+    if (entry.onExit) entry.onExit(exit);
+}
+
+void ProcessReactor::Loop() {
+    struct epoll_event events[kMaxEvents];
+    std::vector<std::unique_ptr<Watched>> incoming;
+    std::vector<uint64_t> candidates;
+
+    for (;;) {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incoming.swap(pending_);
+            stopping = stopping_;
+        }
+        for (auto& entry : incoming) {
+            Register(std::move(entry));
+        }
+        incoming.clear();
+        if (stopping && watched_.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty()) break;
+            continue;
+        }
+
+        // Send due stop signals and sleep no longer than the next one
+        int timeoutMs = -1;
+        auto wakeWithin = [&timeoutMs](int ms) {
+            if (ms >= 0 && (timeoutMs < 0 || ms < timeoutMs)) timeoutMs = ms;
+        };
+        if (stopping) {
+            wakeWithin(AdvanceShutdown());
+            if (watched_.empty()) continue;
+        }
+        size_t kept = 0;
+        for (uint64_t id : timed_) {
+            auto it = watched_.find(id);
+            if (it == watched_.end()) continue;
+            int waitMs = AdvanceCancel(*it->second);
+            if (waitMs >= 0) {
+                wakeWithin(waitMs);
+                timed_[kept++] = id;
+            } else {
+                it->second->timed = false;
+            }
+        }
+        timed_.resize(kept);
+        if (!polling_.empty()) {
+            wakeWithin(kExitPollMs);
+        }
+        if (!readyStreams_.empty()) {
+            timeoutMs = 0;
+        }
+
+        int count = epoll_wait(epollFd_, events, kMaxEvents, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            uint64_t id = events[i].data.u64 >> kTagBits;
+            int kind = static_cast<int>(events[i].data.u64 & ((1u << kTagBits) - 1));
+            if (id == 0) {
+                uint64_t value;
+                ssize_t ignored = read(wakeFd_, &value, sizeof(value));
+                (void)ignored;
+                continue;
+            }
+
+            auto it = watched_.find(id);
+            if (it == watched_.end()) continue;
+            Watched& entry = *it->second;
+            if (kind < kExit) {
+                if (!entry.ready[kind]) {
+                    entry.ready[kind] = true;
+                    readyStreams_.push_back({ id, kind });
+                }
+            } else if (kind == kExit) {
+                entry.exited = true;
+                close(entry.pidFd);
+                entry.pidFd = -1;
+                candidates.push_back(id);
+            } else if (!entry.timed) {
+                // Cancel() was called: start the stop sequence next turn
+                entry.timed = true;
+                timed_.push_back(id);
+            }
+        }
+
+        // One budget per ready stream, round-robin; streams with more left stay queued
+        kept = 0;
+        for (size_t i = 0; i < readyStreams_.size(); ++i) {
+            auto it = watched_.find(readyStreams_[i].first);
+            if (it == watched_.end()) continue;
+            Watched& entry = *it->second;
+            int stream = readyStreams_[i].second;
+            if (ReadStream(entry, stream)) {
+                readyStreams_[kept++] = readyStreams_[i];
+            } else {
+                entry.ready[stream] = false;
+                if (entry.fds[stream] < 0) candidates.push_back(entry.id);
+            }
+        }
+        readyStreams_.resize(kept);
+
+        // Only children that just hit EOF or exited can be done, plus those we poll
+        candidates.insert(candidates.end(), polling_.begin(), polling_.end());
+        for (uint64_t id : candidates) {
+            auto it = watched_.find(id);
+            if (it != watched_.end() && TryFinish(*it->second)) {
+                watched_.erase(it);
+                active_--;
+            }
+        }
+        candidates.clear();
+        polling_.erase(std::remove_if(polling_.begin(), polling_.end(),
+            [this](uint64_t id) { return watched_.count(id) == 0; }), polling_.end());
+    }
+}
+
+} // namespace NeuroShell
+
+#else
+
+namespace NeuroShell {
+
+struct ProcessReactor::Watched {};
+
+ProcessReactor::ProcessReactor()
+    : active_(0)
+    , stopping_(false)
+    , epollFd_(-1)
+    , wakeFd_(-1)
+    , stopSeen_(false)
+    , nextId_(1)
+{
+}
+
+ProcessReactor::~ProcessReactor() = default;
+
+bool ProcessReactor::IsSupported() {
+    return false;
+}
+
+ProcessReactor& ProcessReactor::Shared() {
+    static ProcessReactor reactor;
+    return reactor;
+}
+
+#ifndef _WIN32
+bool ProcessReactor::Watch(const ChildProcess&, ChunkCallback, ExitCallback, std::shared_ptr<CancelToken>) {
+    return false;
+}
+#endif
+
+void ProcessReactor::Shutdown() {
+}
+
+} // namespace NeuroShell
+
+#endif // __linux__
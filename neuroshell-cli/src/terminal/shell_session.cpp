@@ -0,0 +1,415 @@
+#include "terminal/shell_session.h"
+#include <stdexcept>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <cerrno>
+
+extern char** environ;
+#endif
+
+namespace NeuroShell {
+
+namespace {
+
+// OSC 133 prefix; the shell prompt is "ESC]133;D;<status>;<cwd>;<token>BEL" and
+// the continuation prompt is "ESC]133;X;<token>BEL"
+const std::string kMarkerPrefix = "\033]133;";
+
+// A marker longer than this can't be ours (cwd is bounded by PATH_MAX)
+constexpr size_t kMaxMarkerLength = 8192;
+
+// Time allowed for rc files to load before the first prompt
+constexpr int kStartupTimeoutMs = 10000;
+
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+std::string RandomToken() {
+    std::random_device device;
+    std::mt19937_64 generator(device());
+    const char* hex = "0123456789abcdef";
+    std::string token = "ns";
+    for (int i = 0; i < 16; ++i) {
+        token += hex[generator() % 16];
+    }
+    return token;
+}
+
+} // namespace
+
+ShellSession::ShellSession(const std::string& shellPath)
+    : shellPath_(shellPath)
+    , token_(RandomToken())
+    , masterFd_(-1)
+    , shellPid_(-1)
+{
+#ifndef _WIN32
+    if (shellPath_.empty()) {
+        shellPath_ = access("/bin/bash", X_OK) == 0 ? "/bin/bash" : "/bin/sh";
+    }
+#endif
+}
+
+ShellSession::~ShellSession() {
+    Stop();
+}
+
+bool ShellSession::IsAlive() const {
+    return masterFd_ >= 0;
+}
+
+std::string ShellSession::GetWorkingDirectory() const {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    return workingDir_;
+}
+
+#ifdef _WIN32
+
+// ConPTY support would be needed for a persistent session on Windows
+bool ShellSession::Start(const std::string&) { return false; }
+void ShellSession::Stop() {}
+void ShellSession::Interrupt() {}
+void ShellSession::SignalForeground(int) {}
+void ShellSession::WriteInput(const std::string&) {}
+
+ProcessExit ShellSession::Run(const std::string&, const OutputCallback&, CancelToken*) {
+    throw std::runtime_error("Shell sessions are not supported on this platform");
+}
+
+ShellSession::MarkerKind ShellSession::ReadUntilMarker(const OutputCallback&, int, int&, int) {
+    return MarkerKind::None;
+}
+
+ShellSession::MarkerKind ShellSession::ExtractMarker(const OutputCallback&, int&) {
+    return MarkerKind::None;
+}
+
+#else
+
+bool ShellSession::Start(const std::string& workingDir) {
+    if (IsAlive()) return true;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0) return false;
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+
+    const char* slaveName = nullptr;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (slaveName = ptsname(master)) == nullptr) {
+        close(master);
+        return false;
+    }
+
+    int slave = open(slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (slave < 0) {
+        close(master);
+        return false;
+    }
+
+    // No echo of the commands we type, and no \n -> \r\n translation of output
+    struct termios settings;
+    if (tcgetattr(slave, &settings) == 0) {
+        settings.c_lflag &= ~(ECHO | ECHONL);
+        settings.c_oflag &= ~OPOST;
+        tcsetattr(slave, TCSANOW, &settings);
+    }
+    struct winsize size = {};
+    size.ws_row = 40;
+    size.ws_col = 120;
+    ioctl(master, TIOCSWINSZ, &size);
+
+    // Everything the child needs is prepared before fork; after it only
+    // async-signal-safe calls are allowed
+    std::vector<std::string> args = { shellPath_, "-i" };
+    if (shellPath_.find("bash") != std::string::npos) {
+        args = { shellPath_, "--noediting", "+o", "history", "-i" };
+    }
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    std::vector<std::string> env;
+    for (char** entry = environ; *entry != nullptr; ++entry) {
+        std::string var = *entry;
+        if (var.compare(0, 5, "TERM=") == 0 || var.compare(0, 6, "PAGER=") == 0 ||
+            var.compare(0, 10, "GIT_PAGER=") == 0) {
+            continue;
+        }
+        env.push_back(var);
+    }
+    env.push_back("TERM=dumb");
+    env.push_back("PAGER=cat");
+    env.push_back("GIT_PAGER=cat");
+    std::vector<char*> envp;
+    for (auto& var : env) envp.push_back(const_cast<char*>(var.c_str()));
+    envp.push_back(nullptr);
+
+    const char* dir = workingDir.empty() ? nullptr : workingDir.c_str();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(slave);
+        close(master);
+        return false;
+    }
+
+    if (pid == 0) {
+        // New session with the PTY as its controlling terminal
+        setsid();
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        if (dir != nullptr && chdir(dir) != 0) {
+            _exit(127);
+        }
+        sigset_t emptyMask;
+        sigemptyset(&emptyMask);
+        sigprocmask(SIG_SETMASK, &emptyMask, nullptr);
+        signal(SIGPIPE, SIG_DFL);
+        execve(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    close(slave);
+    masterFd_ = master;
+    shellPid_ = pid;
+    pending_.clear();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        workingDir_ = workingDir;
+    }
+
+    // Install our prompts after the rc files ran, so they can't override them.
+    // Whatever the rc files print before our first prompt is discarded.
+    WriteInput("unset PROMPT_COMMAND PS0 2>/dev/null; "
+               "PS1='" + kMarkerPrefix + "D;$?;$PWD;" + token_ + "\007'; "
+               "PS2='" + kMarkerPrefix + "X;" + token_ + "\007'\n");
+
+    try {
+        int exitCode = 0;
+        OutputCallback discard;
+        if (ReadUntilMarker(discard, kStartupTimeoutMs, exitCode) == MarkerKind::Prompt) {
+            return true;
+        }
+    } catch (const std::exception&) {
+        // Shell exited during startup
+    }
+
+    Stop();
+    return false;
+}
+
+void ShellSession::Stop() {
+    int master = masterFd_.exchange(-1);
+    if (master >= 0) {
+        close(master);
+    }
+    if (shellPid_ > 0) {
+        // Closing the master hangs up the terminal; give the shell a moment to leave
+        kill(shellPid_, SIGHUP);
+        int status = 0;
+        bool reaped = false;
+        for (int i = 0; i < 50 && !reaped; ++i) {
+            reaped = waitpid(shellPid_, &status, WNOHANG) == shellPid_;
+            if (!reaped) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (!reaped) {
+            kill(shellPid_, SIGKILL);
+            waitpid(shellPid_, &status, 0);
+        }
+        shellPid_ = -1;
+    }
+}
+
+void ShellSession::Interrupt() {
+    int master = masterFd_;
+    if (master >= 0) {
+        const char interrupt = '\003';
+        ssize_t written = write(master, &interrupt, 1);
+        (void)written;
+    }
+}
+
+void ShellSession::SignalForeground(int signal) {
+    int master = masterFd_;
+    if (master < 0) return;
+    pid_t group = tcgetpgrp(master);
+    if (group > 0 && group != shellPid_) {
+        killpg(group, signal);
+    }
+}
+
+ProcessExit ShellSession::Run(const std::string& command, const OutputCallback& onOutput, CancelToken* cancel) {
+    std::lock_guard<std::mutex> lock(runMutex_);
+    if (!IsAlive()) {
+        throw std::runtime_error("Shell session is not running");
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    WriteInput(command + "\n");
+
+    // Ctrl+C goes through the terminal first, so the shell sees a normal interrupt
+    auto stopForeground = [this](int signal) {
+        if (signal == SIGINT) {
+            Interrupt();
+        } else {
+            SignalForeground(signal);
+        }
+    };
+
+    ProcessExit result;
+    bool incomplete = false;
+    for (;;) {
+        int timeoutMs = -1;
+        int wakeFd = -1;
+        if (cancel) {
+            timeoutMs = cancel->Advance(stopForeground);
+            if (!cancel->IsCancelled()) wakeFd = cancel->GetWakeFd();
+        }
+
+        int exitCode = -1;
+        MarkerKind kind = ReadUntilMarker(onOutput, timeoutMs, exitCode, wakeFd);
+        if (kind == MarkerKind::None) continue;     // Time for the next stop step
+
+        if (kind == MarkerKind::Continuation) {
+            // Unterminated quote or block: the shell wants more input we don't have
+            if (!incomplete && onOutput) {
+                const std::string message = "Incomplete command discarded\n";
+                onOutput(message.data(), message.size());
+            }
+            incomplete = true;
+            Interrupt();
+            continue;
+        }
+
+        result.exitCode = exitCode;
+        break;
+    }
+
+    // The shell reaps its own children, so only wall time is known here
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    result.usage.wallSeconds = elapsed.count();
+    return result;
+}
+
+void ShellSession::WriteInput(const std::string& text) {
+    size_t offset = 0;
+    while (offset < text.size()) {
+        int master = masterFd_;
+        if (master < 0) return;
+        ssize_t written = write(master, text.data() + offset, text.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return;
+        }
+        offset += static_cast<size_t>(written);
+    }
+}
+
+ShellSession::MarkerKind ShellSession::ReadUntilMarker(const OutputCallback& onOutput, int timeoutMs, int& exitCode, int wakeFd) {
+    std::vector<char> buffer(kReadChunkSize);
+
+    for (;;) {
+        MarkerKind kind = ExtractMarker(onOutput, exitCode);
+        if (kind != MarkerKind::None) return kind;
+
+        int master = masterFd_;
+        if (master < 0) {
+            throw std::runtime_error("Shell session ended");
+        }
+
+        struct pollfd fds[2] = {
+            { master, POLLIN, 0 },
+            { wakeFd, POLLIN, 0 }
+        };
+        int ready = poll(fds, 2, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Shell session ended");
+        }
+        if (ready == 0 || fds[0].revents == 0) return MarkerKind::None;
+
+        ssize_t bytesRead = read(master, buffer.data(), buffer.size());
+        if (bytesRead > 0) {
+            pending_.append(buffer.data(), static_cast<size_t>(bytesRead));
+            continue;
+        }
+        if (bytesRead < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+
+        // EIO/EOF: the shell and everything on its terminal is gone
+        if (onOutput && !pending_.empty()) onOutput(pending_.data(), pending_.size());
+        pending_.clear();
+        Stop();
+        throw std::runtime_error("Shell session ended");
+    }
+}
+
+ShellSession::MarkerKind ShellSession::ExtractMarker(const OutputCallback& onOutput, int& exitCode) {
+    const std::string terminator = token_ + "\007";
+
+    size_t start = pending_.find(kMarkerPrefix);
+    while (start != std::string::npos) {
+        size_t end = pending_.find(terminator, start);
+        if (end == std::string::npos) {
+            // Possibly still arriving; if it's already too long it isn't ours
+            if (pending_.size() - start > kMaxMarkerLength) {
+                start = pending_.find(kMarkerPrefix, start + 1);
+                continue;
+            }
+            break;
+        }
+
+        std::string body = pending_.substr(start + kMarkerPrefix.size(), end - start - kMarkerPrefix.size());
+        if (onOutput && start > 0) onOutput(pending_.data(), start);
+        pending_.erase(0, end + terminator.size());
+
+        if (body.compare(0, 2, "X;") == 0) {
+            return MarkerKind::Continuation;
+        }
+
+        // "D;<status>;<cwd>;"
+        size_t statusEnd = body.find(';', 2);
+        if (body.compare(0, 2, "D;") == 0 && statusEnd != std::string::npos) {
+            exitCode = std::atoi(body.substr(2, statusEnd - 2).c_str());
+            std::string cwd = body.substr(statusEnd + 1);
+            if (!cwd.empty() && cwd.back() == ';') cwd.pop_back();
+
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            workingDir_ = cwd;
+        }
+        return MarkerKind::Prompt;
+    }
+
+    // Hand out everything that can't be the beginning of a marker
+    size_t keep = start;
+    if (keep == std::string::npos) {
+        keep = pending_.size();
+        for (size_t length = std::min(kMarkerPrefix.size() - 1, pending_.size()); length > 0; --length) {
+            if (pending_.compare(pending_.size() - length, length, kMarkerPrefix, 0, length) == 0) {
+                keep = pending_.size() - length;
+                break;
+            }
+        }
+    }
+    if (keep > 0) {
+        if (onOutput) onOutput(pending_.data(), keep);
+        pending_.erase(0, keep);
+    }
+    return MarkerKind::None;
+}
+
+#endif // _WIN32
+
+} // namespace NeuroShell
@@ -0,0 +1,553 @@
+#include "terminal/spawn_zygote.h"
+
+#ifndef _WIN32
+
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <cerrno>
+
+namespace NeuroShell {
+
+namespace {
+
+enum MessageType : uint32_t {
+    kSpawned = 1,
+    kExited = 2
+};
+
+// Fixed-size message from the helper; a kSpawned reply carries the child's
+// stdout and stderr read ends as SCM_RIGHTS ancillary data
+struct Reply {
+    uint32_t type;
+    int32_t pid;
+    uint64_t requestId;
+    int32_t error;                  // Non-zero if the spawn failed
+    int32_t waitStatus;
+    double wallSeconds;
+    struct rusage usage;
+};
+
+struct SpawnResult {
+    Reply reply;
+    int stdoutFd;
+    int stderrFd;
+};
+
+struct ZygoteState {
+    std::mutex mutex;               // Guards everything below except sendMutex
+    std::mutex sendMutex;           // Serializes request frames on the socket
+    std::condition_variable changed;
+    int socketFd = -1;
+    int zygotePid = -1;
+    uint64_t nextRequestId = 1;
+    bool readerDone = true;
+    std::map<uint64_t, SpawnResult> spawned;
+    std::map<int, ProcessExit> exited;
+    std::thread reader;
+};
+
+ZygoteState& State() {
+    static ZygoteState state;
+    return state;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool ReadAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t bytesRead = read(fd, data, size);
+        if (bytesRead < 0 && errno == EINTR) continue;
+        if (bytesRead <= 0) return false;
+        data += bytesRead;
+        size -= static_cast<size_t>(bytesRead);
+    }
+    return true;
+}
+
+void AppendString(std::string& frame, const std::string& value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    frame.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    frame.append(value);
+}
+
+bool TakeString(const std::string& payload, size_t& offset, std::string& value) {
+    uint32_t length = 0;
+    if (offset + sizeof(length) > payload.size()) return false;
+    std::memcpy(&length, payload.data() + offset, sizeof(length));
+    offset += sizeof(length);
+    if (offset + length > payload.size()) return false;
+    value.assign(payload, offset, length);
+    offset += length;
+    return true;
+}
+
+// Frame: [u32 payload size][u64 request id][u32 argc][argv strings][working dir]
+// [i32 nice, I/O class, I/O level, idle scheduling]. A working directory
+// descriptor rides on the first byte as SCM_RIGHTS.
+std::string EncodeRequest(uint64_t requestId, const SpawnOptions& options) {
+    std::string payload;
+    payload.append(reinterpret_cast<const char*>(&requestId), sizeof(requestId));
+    uint32_t argc = static_cast<uint32_t>(options.argv.size());
+    payload.append(reinterpret_cast<const char*>(&argc), sizeof(argc));
+    for (const auto& arg : options.argv) {
+        AppendString(payload, arg);
+    }
+    AppendString(payload, options.workingDir);
+    const ProcessPriority& priority = options.limits.priority;
+    int32_t levels[4] = { priority.nice, priority.ioClass, priority.ioLevel, priority.idleScheduling ? 1 : 0 };
+    payload.append(reinterpret_cast<const char*>(levels), sizeof(levels));
+
+    std::string frame;
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    frame.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    frame.append(payload);
+    return frame;
+}
+
+bool DecodeRequest(const std::string& payload, uint64_t& requestId, SpawnOptions& options) {
+    size_t offset = 0;
+    uint32_t argc = 0;
+    if (payload.size() < sizeof(requestId) + sizeof(argc)) return false;
+    std::memcpy(&requestId, payload.data(), sizeof(requestId));
+    offset += sizeof(requestId);
+    std::memcpy(&argc, payload.data() + offset, sizeof(argc));
+    offset += sizeof(argc);
+
+    options.argv.resize(argc);
+    for (auto& arg : options.argv) {
+        if (!TakeString(payload, offset, arg)) return false;
+    }
+    if (!TakeString(payload, offset, options.workingDir)) return false;
+
+    int32_t levels[4];
+    if (offset + sizeof(levels) > payload.size()) return false;
+    std::memcpy(levels, payload.data() + offset, sizeof(levels));
+    ProcessPriority& priority = options.limits.priority;
+    priority.nice = levels[0];
+    priority.ioClass = levels[1];
+    priority.ioLevel = levels[2];
+    priority.idleScheduling = levels[3] != 0;
+    return true;
+}
+
+// Write a whole request frame, attaching fd (if any) to its first byte
+bool SendRequest(int sock, const std::string& frame, int fd) {
+    if (fd < 0) return WriteAll(sock, frame.data(), frame.size());
+
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(frame.data());
+    iov.iov_len = frame.size();
+
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) return false;
+
+    size_t done = static_cast<size_t>(sent);
+    return done == frame.size() || WriteAll(sock, frame.data() + done, frame.size() - done);
+}
+
+// Read a request's size prefix and any descriptor sent along with it (-1 if none)
+bool ReceiveRequestSize(int sock, uint32_t& size, int& fd) {
+    fd = -1;
+
+    struct iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof(size);
+
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    ssize_t received;
+    do {
+        received = recvmsg(sock, &message, flags);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return false;
+
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (header != nullptr && header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+        std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    size_t done = static_cast<size_t>(received);
+    return done == sizeof(size) ||
+           ReadAll(sock, reinterpret_cast<char*>(&size) + done, sizeof(size) - done);
+}
+
+bool SendReply(int sock, const Reply& reply, const int* fds, int fdCount) {
+    struct iovec iov;
+    iov.iov_base = const_cast<Reply*>(&reply);
+    iov.iov_len = sizeof(reply);
+
+    char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    struct msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    if (fdCount > 0) {
+        message.msg_control = control;
+        message.msg_controllen = CMSG_SPACE(fdCount * sizeof(int));
+        struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(fdCount * sizeof(int));
+        std::memcpy(CMSG_DATA(header), fds, fdCount * sizeof(int));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) return false;
+
+    // Descriptors ride on the first byte; the rest of a short send is plain data
+    size_t done = static_cast<size_t>(sent);
+    return done == sizeof(reply) ||
+           WriteAll(sock, reinterpret_cast<const char*>(&reply) + done, sizeof(reply) - done);
+}
+
+bool ReceiveReply(int sock, Reply& reply, int fds[2]) {
+    fds[0] = fds[1] = -1;
+
+    struct iovec iov;
+    iov.iov_base = &reply;
+    iov.iov_len = sizeof(reply);
+
+    char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    struct msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    ssize_t received;
+    do {
+        received = recvmsg(sock, &message, flags);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return false;
+
+    for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+         header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            std::memcpy(fds, CMSG_DATA(header), std::min<size_t>(count, 2) * sizeof(int));
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (fds[i] >= 0) fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    size_t done = static_cast<size_t>(received);
+    return done == sizeof(reply) ||
+           ReadAll(sock, reinterpret_cast<char*>(&reply) + done, sizeof(reply) - done);
+}
+
+// --- Helper process side ---------------------------------------------------
+
+int g_childExitPipe[2] = { -1, -1 };
+
+void OnChildExit(int) {
+    int savedErrno = errno;
+    char byte = 0;
+    ssize_t written = write(g_childExitPipe[1], &byte, 1);
+    (void)written;
+    errno = savedErrno;
+}
+
+void ReapChildren(int sock, std::map<int, std::chrono::steady_clock::time_point>& started) {
+    int status = 0;
+    struct rusage usage = {};
+    int pid;
+    while ((pid = wait4(-1, &status, WNOHANG, &usage)) > 0) {
+        Reply reply = {};
+        reply.type = kExited;
+        reply.pid = pid;
+        reply.waitStatus = status;
+        reply.usage = usage;
+
+        auto it = started.find(pid);
+        if (it != started.end()) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - it->second;
+            reply.wallSeconds = elapsed.count();
+            started.erase(it);
+        }
+        SendReply(sock, reply, nullptr, 0);
+    }
+}
+
+[[noreturn]] void RunZygote(int sock) {
+    signal(SIGPIPE, SIG_IGN);
+    if (pipe(g_childExitPipe) != 0) _exit(1);
+    fcntl(g_childExitPipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(g_childExitPipe[1], F_SETFL, O_NONBLOCK);
+
+    struct sigaction action = {};
+    action.sa_handler = OnChildExit;
+    action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, nullptr);
+
+    std::map<int, std::chrono::steady_clock::time_point> started;
+
+    for (;;) {
+        struct pollfd fds[2] = {
+            { sock, POLLIN, 0 },
+            { g_childExitPipe[0], POLLIN, 0 }
+        };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            _exit(1);
+        }
+
+        if (fds[1].revents != 0) {
+            char drain[64];
+            while (read(g_childExitPipe[0], drain, sizeof(drain)) > 0) {}
+            ReapChildren(sock, started);
+        }
+
+        if (fds[0].revents != 0) {
+            uint32_t size = 0;
+            int dirFd = -1;
+            std::string payload;
+            if (!ReceiveRequestSize(sock, size, dirFd)) _exit(0);
+            payload.resize(size);
+            if (!ReadAll(sock, &payload[0], size)) _exit(0);
+
+            Reply reply = {};
+            reply.type = kSpawned;
+            SpawnOptions options;
+            if (!DecodeRequest(payload, reply.requestId, options)) _exit(1);
+            options.workingDirFd = dirFd;
+
+            try {
+                ChildProcess child = SpawnProcess(options);
+                started[child.pid] = child.startTime;
+                reply.pid = child.pid;
+                int fds[2] = { child.stdoutFd, child.stderrFd };
+                SendReply(sock, reply, fds, 2);
+                close(child.stdoutFd);
+                close(child.stderrFd);
+            } catch (const std::exception&) {
+                reply.error = 1;
+                SendReply(sock, reply, nullptr, 0);
+            }
+            if (dirFd >= 0) close(dirFd);
+        }
+    }
+}
+
+// --- UI process side -------------------------------------------------------
+
+void ReadReplies(int sock) {
+    ZygoteState& state = State();
+    for (;;) {
+        Reply reply;
+        int fds[2];
+        if (!ReceiveReply(sock, reply, fds)) break;
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (reply.type == kSpawned) {
+            state.spawned[reply.requestId] = { reply, fds[0], fds[1] };
+        } else if (reply.type == kExited) {
+            state.exited[reply.pid] = MakeProcessExit(reply.waitStatus, reply.usage, reply.wallSeconds);
+        }
+        state.changed.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.readerDone = true;
+    state.changed.notify_all();
+}
+
+} // namespace
+
+bool SpawnZygote::Start() {
+    ZygoteState& state = State();
+    if (IsRunning()) return true;
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) return false;
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    fcntl(sockets[1], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(sockets[0]);
+        RunZygote(sockets[1]);
+    }
+
+    close(sockets[1]);
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.socketFd = sockets[0];
+        state.zygotePid = pid;
+        state.readerDone = false;
+    }
+    state.reader = std::thread(ReadReplies, sockets[0]);
+    return true;
+}
+
+void SpawnZygote::Stop() {
+    ZygoteState& state = State();
+    int sock;
+    int pid;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        sock = state.socketFd;
+        pid = state.zygotePid;
+        state.socketFd = -1;
+        state.zygotePid = -1;
+    }
+    if (sock < 0) return;
+
+    // The helper exits when it sees EOF on its end of the socket
+    shutdown(sock, SHUT_RDWR);
+    if (state.reader.joinable()) state.reader.join();
+    close(sock);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (auto& entry : state.spawned) {
+        if (entry.second.stdoutFd >= 0) close(entry.second.stdoutFd);
+        if (entry.second.stderrFd >= 0) close(entry.second.stderrFd);
+    }
+    state.spawned.clear();
+}
+
+bool SpawnZygote::IsRunning() {
+    ZygoteState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.socketFd >= 0 && !state.readerDone;
+}
+
+ChildProcess SpawnZygote::Spawn(const SpawnOptions& options) {
+    ZygoteState& state = State();
+    uint64_t requestId;
+    int sock;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.socketFd < 0 || state.readerDone) {
+            throw std::runtime_error("Spawn helper is not running");
+        }
+        requestId = state.nextRequestId++;
+        sock = state.socketFd;
+    }
+
+    std::string frame = EncodeRequest(requestId, options);
+    {
+        std::lock_guard<std::mutex> sendLock(state.sendMutex);
+        if (!SendRequest(sock, frame, options.workingDirFd)) {
+            throw std::runtime_error("Spawn helper is not responding");
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.changed.wait(lock, [&]() {
+        return state.spawned.count(requestId) > 0 || state.readerDone;
+    });
+
+    auto it = state.spawned.find(requestId);
+    if (it == state.spawned.end()) {
+        throw std::runtime_error("Spawn helper exited");
+    }
+    SpawnResult result = it->second;
+    state.spawned.erase(it);
+    lock.unlock();
+
+    if (result.reply.error != 0 || result.stdoutFd < 0 || result.stderrFd < 0) {
+        if (result.stdoutFd >= 0) close(result.stdoutFd);
+        if (result.stderrFd >= 0) close(result.stderrFd);
+        throw std::runtime_error("Failed to execute command");
+    }
+
+    ChildProcess child;
+    child.pid = result.reply.pid;
+    child.stdoutFd = result.stdoutFd;
+    child.stderrFd = result.stderrFd;
+    child.startTime = std::chrono::steady_clock::now();
+    child.viaZygote = true;
+    return child;
+}
+
+ProcessExit SpawnZygote::Wait(const ChildProcess& child) {
+    ZygoteState& state = State();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.changed.wait(lock, [&]() {
+        return state.exited.count(child.pid) > 0 || state.readerDone;
+    });
+
+    auto it = state.exited.find(child.pid);
+    if (it == state.exited.end()) {
+        return ProcessExit();
+    }
+    ProcessExit result = it->second;
+    state.exited.erase(it);
+    return result;
+}
+
+bool SpawnZygote::HasExited(const ChildProcess& child) {
+    ZygoteState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.exited.count(child.pid) > 0 || state.readerDone;
+}
+
+} // namespace NeuroShell
+
+#endif // _WIN32
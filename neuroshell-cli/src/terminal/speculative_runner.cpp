@@ -0,0 +1,289 @@
+#include "terminal/speculative_runner.h"
+#include "terminal/command_lexer.h"
+#include "common/thread_pool.h"
+#include <algorithm>
+
+namespace NeuroShell {
+
+SpeculativeRunner::SpeculativeRunner()
+    : running_(0)
+    , enabled_(true)
+    , ttl_(std::chrono::seconds(5))
+    , maxPredictions_(2)
+{
+}
+
+SpeculativeRunner::~SpeculativeRunner() {
+    Invalidate();
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return running_ == 0; });
+}
+
+void SpeculativeRunner::SetRunner(RunFn run) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    run_ = std::move(run);
+}
+
+void SpeculativeRunner::SetEnabled(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled_ = enabled;
+    }
+    if (!enabled) Invalidate();
+}
+
+bool SpeculativeRunner::IsEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+void SpeculativeRunner::SetLimits(int ttlMs, int maxPredictions) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ttl_ = std::chrono::milliseconds(std::max(0, ttlMs));
+    maxPredictions_ = static_cast<size_t>(std::max(0, maxPredictions));
+}
+
+void SpeculativeRunner::Observe(const std::string& command, bool builtIn) {
+    std::string context = Context(command);
+    if (context.empty()) return;
+    if (!builtIn && !safety_.isSpeculatable(command)) {
+        Invalidate();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!previous_.empty() && !builtIn) {
+        if (!followers_.count(previous_) && followers_.size() >= kMaxContexts) {
+            // Forget the context seen least
+            auto least = followers_.end();
+            unsigned leastTotal = 0;
+            for (auto it = followers_.begin(); it != followers_.end(); ++it) {
+                unsigned total = 0;
+                for (const auto& next : it->second) total += next.second;
+                if (least == followers_.end() || total < leastTotal) {
+                    least = it;
+                    leastTotal = total;
+                }
+            }
+            followers_.erase(least);
+        }
+
+        auto& next = followers_[previous_];
+        if (++next[context] > kMaxCount) {
+            for (auto it = next.begin(); it != next.end();) {
+                it->second /= 2;
+                it = it->second == 0 ? next.erase(it) : std::next(it);
+            }
+        }
+    }
+    previous_ = context;
+}
+
+std::vector<std::string> SpeculativeRunner::Predict(const std::string& command) const {
+    std::vector<std::pair<unsigned, std::string>> candidates;
+    size_t limit;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit = maxPredictions_;
+        auto it = followers_.find(Context(command));
+        if (it == followers_.end()) return {};
+
+        unsigned total = 0;
+        for (const auto& next : it->second) total += next.second;
+        for (const auto& next : it->second) {
+            if (next.second >= kMinSupport && next.second >= total * kMinShare) {
+                candidates.emplace_back(next.second, next.first);
+            }
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    std::vector<std::string> predictions;
+    for (const auto& candidate : candidates) {
+        if (predictions.size() >= limit) break;
+        if (safety_.isSpeculatable(candidate.second)) {
+            predictions.push_back(candidate.second);
+        }
+    }
+    return predictions;
+}
+
+void SpeculativeRunner::Speculate(const std::string& command, const WorkingDirectory& dir) {
+    if (!IsEnabled() || !dir.IsValid()) return;
+
+    for (const auto& prediction : Predict(command)) {
+        std::vector<std::string> argv;
+        uint64_t fingerprint = 0;
+        if (!CommandLexer::SplitSimple(prediction, argv) || argv.empty() ||
+            !CommandCache::Fingerprint(argv, dir.Path(), fingerprint)) {
+            continue;
+        }
+        std::string key = CommandCache::Key(argv, dir.Path());
+
+        RunFn run;
+        auto cancel = std::make_shared<CancelToken>();
+        cancel->SetTimeout(kRunTimeoutSeconds);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Sweep(Clock::now());
+            if (!run_ || entries_.count(key)) continue;
+            run = run_;
+
+            Entry entry;
+            entry.command = prediction;
+            entry.fingerprint = fingerprint;
+            entry.cancel = cancel;
+            entry.done = false;
+            entry.cpuSeconds = 0.0;
+            entries_[key] = std::move(entry);
+            stats_.started++;
+            running_++;
+        }
+
+        std::string runnable = RunnableForm(prediction);
+        auto done = [this, key, cancel](bool success, CachedResult result, double cpuSeconds) {
+            Finish(key, cancel, success, std::move(result), cpuSeconds);
+        };
+        bool submitted = ThreadPool::Shared().Submit([run, runnable, dir, cancel, done]() {
+            if (cancel->IsCancelled()) {
+                done(false, CachedResult(), 0.0);
+                return;
+            }
+            run(runnable, dir, cancel, done);
+        }, TaskPriority::Background);
+        if (!submitted) {
+            done(false, CachedResult(), 0.0);
+        }
+    }
+}
+
+bool SpeculativeRunner::Take(const std::string& command, const std::string& workingDir, CachedResult& result) {
+    std::vector<std::string> argv;
+    if (!IsEnabled() || !safety_.isSpeculatable(command) ||
+        !CommandLexer::SplitSimple(command, argv) || argv.empty()) {
+        return false;
+    }
+    std::string key = CommandCache::Key(argv, workingDir);
+    uint64_t fingerprint = 0;
+    bool checked = CommandCache::Fingerprint(argv, workingDir, fingerprint);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Sweep(Clock::now());
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        stats_.misses++;
+        return false;
+    }
+
+    Entry& entry = it->second;
+    if (!entry.done || !checked || entry.fingerprint != fingerprint) {
+        // Still running, or what it read has changed since
+        if (!entry.done) {
+            entry.cancel->Cancel();
+        } else {
+            Waste(entry);
+        }
+        entries_.erase(it);
+        stats_.misses++;
+        return false;
+    }
+
+    result = std::move(entry.result);
+    entries_.erase(it);
+    stats_.hits++;
+    return true;
+}
+
+void SpeculativeRunner::Invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        // Runs still going are counted when they finish
+        if (entry.second.done) {
+            Waste(entry.second);
+        } else {
+            entry.second.cancel->Cancel();
+        }
+    }
+    entries_.clear();
+}
+
+SpeculativeRunner::Stats SpeculativeRunner::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    Clock::time_point now = Clock::now();
+    stats.warm = std::count_if(entries_.begin(), entries_.end(), [this, now](const auto& entry) {
+        return entry.second.done && now - entry.second.finishedAt <= ttl_;
+    });
+    return stats;
+}
+
+std::string SpeculativeRunner::RunnableForm(const std::string& command) {
+    std::vector<std::string> argv;
+    if (!CommandLexer::SplitSimple(command, argv) || argv.size() < 2 || argv[0] != "git") {
+        return command;
+    }
+
+    // Splice the options in after the words as written; quoted ones are left alone
+    size_t name = command.find_first_not_of(" \t");
+    if (command.compare(name, 4, "git ") != 0) return command;
+    const std::string options = " --no-optional-locks";
+    std::string runnable = command.substr(0, name + 3) + options + command.substr(name + 3);
+    size_t subcommand = runnable.find_first_not_of(" \t", name + 3 + options.size());
+    if (argv[1] == "log" && runnable.compare(subcommand, 3, "log") == 0) {
+        runnable.insert(subcommand + 3, " --no-ext-diff --no-textconv");
+    }
+    return runnable;
+}
+
+std::string SpeculativeRunner::Context(const std::string& command) {
+    size_t start = command.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = command.find_last_not_of(" \t\r\n");
+    std::string trimmed = command.substr(start, end - start + 1);
+
+    // Where cd went matters less than that it happened
+    if (trimmed == "cd" || trimmed.compare(0, 3, "cd ") == 0 || trimmed.compare(0, 3, "cd\t") == 0) {
+        return "cd";
+    }
+    return trimmed;
+}
+
+void SpeculativeRunner::Waste(const Entry& entry) {
+    stats_.wasted++;
+    stats_.wastedCpuSeconds += entry.cpuSeconds;
+}
+
+void SpeculativeRunner::Sweep(Clock::time_point now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.done && now - it->second.finishedAt > ttl_) {
+            Waste(it->second);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SpeculativeRunner::Finish(const std::string& key, const std::shared_ptr<CancelToken>& cancel, bool success,
+                               CachedResult result, double cpuSeconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.cpuSeconds += cpuSeconds;
+
+    auto it = entries_.find(key);
+    bool current = it != entries_.end() && it->second.cancel == cancel;
+    if (!current || !success || cancel->IsCancelled()) {
+        stats_.wasted++;
+        stats_.wastedCpuSeconds += cpuSeconds;
+        if (current) entries_.erase(it);
+    } else {
+        it->second.done = true;
+        it->second.finishedAt = Clock::now();
+        it->second.result = std::move(result);
+        it->second.cpuSeconds = cpuSeconds;
+    }
+
+    running_--;
+    idle_.notify_all();
+}
+
+} // namespace NeuroShell
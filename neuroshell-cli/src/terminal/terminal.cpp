@@ -1,43 +1,826 @@
 #include "terminal/terminal.h"
+#include "terminal/file_watcher.h"
+#include "common/line_diff.h"
+#include "common/thread_pool.h"
+#include "utils/config_loader.h"
 #include <algorithm>
+#include <map>
+#include <sstream>
+#include <csignal>
 
 namespace NeuroShell {
 
+namespace {
+
+#ifdef _WIN32
+// No job control signals; CancelToken::Signal() fails there anyway
+constexpr int kStopSignal = 19;
+constexpr int kContinueSignal = 18;
+constexpr int kTerminalStopSignal = 20;
+#else
+constexpr int kStopSignal = SIGSTOP;
+constexpr int kContinueSignal = SIGCONT;
+constexpr int kTerminalStopSignal = SIGTSTP;
+#endif
+
+std::vector<std::string> SplitWords(const std::string& command) {
+    std::istringstream stream(command);
+    std::vector<std::string> words;
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+} // namespace
+
+struct Terminal::PlanRun {
+    std::vector<PlannedCommand> plan;
+    std::vector<uint64_t> blockIds;
+    std::vector<bool> started;
+    std::vector<size_t> remainingDeps;          // Unfinished dependencies per command
+    std::vector<std::vector<size_t>> dependents;
+    std::shared_ptr<ShellSession> session;      // Taken when the plan was submitted
+    std::mutex mutex;
+    int running = 0;
+    int limit = 1;
+};
+
 Terminal::Terminal()
     : executor_(nullptr)
+    , reactorRuns_(0)
+    , nextBlockId_(1)
+    , maxParallelCommands_(4)
+    , limitMode_(LimitMode::None)
     , historyNavigationIndex_(-1)
     , screenCleared_(false)
+    , watchDebounceMs_(200)
+    , watchMinIntervalMs_(1000)
 {
 }
 
-Terminal::~Terminal() = default;
+Terminal::~Terminal() {
+    // Watch callbacks and the reactor's completions point back here
+    auto lock = LockHistory();
+    for (const auto& entry : watches_) {
+        FileWatcher::Shared().Remove(entry.second.watchId);
+    }
+    CancelAll();
+    reactorIdle_.wait(lock, [this]() { return reactorRuns_ == 0; });
+}
 
 void Terminal::Initialize() {
     executor_ = std::make_unique<CommandExecutor>();
     InitializeCompletions();
+    
+    // Speculative runs go through the reactor like any other, in the lowest priority class
+    speculator_.SetRunner([this](const std::string& command, const WorkingDirectory& dir,
+                                 std::shared_ptr<CancelToken> cancel, SpeculativeRunner::DoneFn done) {
+        auto collected = std::make_shared<CommandBlock>();
+        auto onOutput = [collected](OutputStream stream, const char* data, size_t size) {
+            collected->AppendOutput(stream, data, size);
+        };
+        auto onComplete = [collected, done](const CommandBlock& finished) {
+            collected->FinishOutput();
+            CachedResult result;
+            bool success = finished.status == CommandStatus::Success && collected->output.SpilledBytes() == 0;
+            if (success) {
+                result.output = collected->output.Str();
+                result.segments = std::move(collected->segments);
+                result.styles = std::move(collected->styles);
+                result.lines = std::move(collected->lines);
+                result.binaryBytes = collected->binaryBytes;
+                result.exitCode = finished.exitCode;
+            }
+            done(success, std::move(result), finished.usage.CpuSeconds());
+        };
+        ResourceLimits idle;
+        idle.priority = priorities_.For(CommandOrigin::Speculative);
+        executor_->ExecuteReactive(command, onOutput, onComplete, dir, cancel, idle);
+    });
+    
+    neuroshell::utils::ConfigLoader config;
+    if (config.load("config/neuroshell.conf")) {
+        SetMaxParallelCommands(config.getInt("max_parallel_commands", maxParallelCommands_));
+        cache_.SetEnabled(config.getBool("cache_commands", true));
+        cache_.SetCapacity(static_cast<size_t>(std::max(0, config.getInt("cache_size", 50))));
+        OutputBuffer::SetDefaultLimits(static_cast<size_t>(std::max(0, config.getInt("output_head_kb", 256))) * 1024,
+                                       static_cast<size_t>(std::max(0, config.getInt("output_tail_kb", 256))) * 1024);
+        
+        executor_->SetStopSchedule(config.getInt("cancel_interrupt_grace_ms", 2000),
+                                   config.getInt("cancel_terminate_grace_ms", 3000));
+        executor_->SetDefaultTimeout(config.getInt("command_timeout", 0));
+        
+        // timeout.<program>=<seconds> overrides the default for one program
+        const std::string prefix = "timeout.";
+        for (const auto& key : config.getKeys()) {
+            if (key.compare(0, prefix.size(), prefix) == 0 && key.size() > prefix.size()) {
+                executor_->SetCommandTimeout(key.substr(prefix.size()), config.getInt(key, 0));
+            }
+        }
+        
+        std::string limitMode = config.getString("command_limits", "none");
+        ResourceLimits limits;
+        limits.cpuWeight = std::max(0, config.getInt("limit_cpu_weight", 0));
+        limits.memoryMaxBytes = static_cast<uint64_t>(std::max(0, config.getInt("limit_memory_mb", 0))) * 1024 * 1024;
+        limits.pidsMax = std::max(0, config.getInt("limit_pids", 0));
+        SetResourceLimits(limitMode == "all" ? LimitMode::All
+                          : limitMode == "ai" ? LimitMode::AIGenerated : LimitMode::None, limits);
+        
+        // priority.<origin>=nice:<n> io:<class>[:<level>] sched:<idle|normal>
+        const std::string priorityPrefix = "priority.";
+        for (const auto& key : config.getKeys()) {
+            CommandOrigin origin;
+            ProcessPriority priority;
+            if (key.compare(0, priorityPrefix.size(), priorityPrefix) == 0 &&
+                PriorityClasses::FromName(key.substr(priorityPrefix.size()), origin) &&
+                ProcessPriority::Parse(config.getString(key, ""), priority)) {
+                priorities_.Set(origin, priority);
+            }
+        }
+        
+        SetWatchTiming(config.getInt("watch_debounce_ms", watchDebounceMs_),
+                       config.getInt("watch_min_interval_ms", watchMinIntervalMs_));
+        
+        speculator_.SetEnabled(config.getBool("speculate_commands", true));
+        speculator_.SetLimits(config.getInt("speculate_ttl_ms", 5000), config.getInt("speculate_max", 2));
+    }
 }
 
 void Terminal::ExecuteCommand(const std::string& command) {
-    if (command.empty()) return;
+    std::string stripped;
+    if (!IsSessionMode() && JobTable::SplitBackground(command, stripped)) {
+        RunCommand(stripped, false, "", true);
+        return;
+    }
+    RunCommand(command, false, "");
+}
+
+void Terminal::ExecuteInBackground(const std::string& command) {
+    // The session shell has job control of its own
+    if (IsSessionMode()) {
+        RunCommand(command + " &", false, "");
+        return;
+    }
+    RunCommand(command, false, "", true);
+}
+
+void Terminal::ExecuteAICommand(const std::string& command, const std::string& nlpPrompt) {
+    RunCommand(command, true, nlpPrompt);
+}
+
+void Terminal::ExecuteAICommands(const std::vector<std::string>& commands, const std::string& nlpPrompt) {
+    std::vector<PlannedCommand> plan = ExecutionPlanner::Plan(commands);
+    if (plan.empty()) return;
     
-    CommandBlock block = executor_->Execute(command);
-    history_.push_back(block);
+    // The session shell runs one command at a time, so keep its queue in order
+    std::shared_ptr<ShellSession> session = GetSession();
+    if (session) {
+        for (size_t i = 0; i < plan.size(); ++i) {
+            plan[i].dependsOn.clear();
+            if (i > 0) plan[i].dependsOn.push_back(i - 1);
+        }
+    }
     
-    historyNavigationIndex_ = -1;
+    for (const auto& planned : plan) {
+        speculator_.Observe(planned.command, !session && IsBuiltInCommand(planned.command));
+    }
+    
+    std::vector<uint64_t> blockIds;
+    {
+        auto lock = LockHistory();
+        for (const auto& planned : plan) {
+            blockIds.push_back(AddRunningBlock(planned.command, true, nlpPrompt));
+        }
+    }
+    
+    auto run = std::make_shared<PlanRun>();
+    run->plan = std::move(plan);
+    run->blockIds = std::move(blockIds);
+    run->session = session;
+    run->limit = maxParallelCommands_;
+    run->started.assign(run->plan.size(), false);
+    run->remainingDeps.assign(run->plan.size(), 0);
+    run->dependents.resize(run->plan.size());
+    for (size_t i = 0; i < run->plan.size(); ++i) {
+        run->remainingDeps[i] = run->plan[i].dependsOn.size();
+        for (size_t dep : run->plan[i].dependsOn) {
+            run->dependents[dep].push_back(i);
+        }
+    }
+    
+    DispatchPlan(run);
 }
 
-void Terminal::ExecuteAICommand(const std::string& command, const std::string& nlpPrompt) {
+void Terminal::SetMaxParallelCommands(int limit) {
+    maxParallelCommands_ = std::max(1, limit);
+}
+
+void Terminal::SetResourceLimits(LimitMode mode, const ResourceLimits& limits) {
+    limitMode_ = mode;
+    limits_ = limits;
+}
+
+void Terminal::SetWatchTiming(int debounceMs, int minIntervalMs) {
+    auto lock = LockHistory();
+    watchDebounceMs_ = std::max(0, debounceMs);
+    watchMinIntervalMs_ = std::max(0, minIntervalMs);
+}
+
+bool Terminal::StartWatch(uint64_t blockId, const std::vector<std::string>& paths) {
+    auto lock = LockHistory();
+    CommandBlock* block = FindBlock(blockId);
+    if (!block || block->watching || block->status == CommandStatus::Running) return false;
+    // cd and friends act on the terminal itself; rerunning them makes no sense
+    if (IsBuiltInCommand(block->input) || IsJobCommand(block->input)) return false;
+    // Reruns replace this output, so earlier runs can't be rebuilt from it any more
+    UnfoldInto(blockId);
+    
+    WorkingDirectory workingDir;
+    if (!WorkingDirectory::Current().Resolve(block->workingDirectory, workingDir)) return false;
+    
+    std::vector<std::string> targets;
+    for (const auto& path : paths) {
+        targets.push_back(!path.empty() && path[0] == '/' ? path : workingDir.Path() + "/" + path);
+    }
+    if (targets.empty()) targets.push_back(workingDir.Path());
+    
+    // The watcher thread only queues the rerun, so it never waits on the history lock
+    uint64_t watchId = FileWatcher::Shared().Add(targets, [this, blockId]() {
+        ThreadPool::Shared().Submit([this, blockId]() { RerunWatched(blockId); }, TaskPriority::Background);
+    }, watchDebounceMs_, watchMinIntervalMs_);
+    if (watchId == 0) return false;
+    
+    watches_[blockId] = WatchedBlock{ watchId, workingDir };
+    block->watching = true;
+    return true;
+}
+
+void Terminal::StopWatch(uint64_t blockId) {
+    auto lock = LockHistory();
+    auto watch = watches_.find(blockId);
+    if (watch == watches_.end()) return;
+    FileWatcher::Shared().Remove(watch->second.watchId);
+    watches_.erase(watch);
+    if (CommandBlock* block = FindBlock(blockId)) {
+        block->watching = false;
+    }
+}
+
+void Terminal::RerunWatched(uint64_t blockId) {
+    std::string command;
+    WorkingDirectory workingDir;
+    uint64_t watchId;
+    {
+        auto lock = LockHistory();
+        auto watch = watches_.find(blockId);
+        CommandBlock* block = FindBlock(blockId);
+        if (watch == watches_.end() || !block) return;
+        
+        command = block->input;
+        workingDir = watch->second.workingDir;
+        watchId = watch->second.watchId;
+        block->ClearOutput();
+        block->status = CommandStatus::Running;
+        block->exitCode = 0;
+        block->termSignal = 0;
+        block->usage = ResourceUsage();
+        block->fromCache = false;
+        block->speculated = false;
+        block->nativeBuiltin = false;
+        block->pipeline.clear();
+        block->timestamp = std::chrono::system_clock::now();
+        block->watchReruns++;
+        block->jobNumber = 0;
+        cancelTokens_[blockId] = std::make_shared<CancelToken>();
+    }
+    
+    // A change the cache's fingerprint misses (same size, same mtime second) is
+    // still a change, so the rerun always runs
+    RunStreaming(command, blockId, workingDir, CommandOrigin::Background, [watchId]() {
+        FileWatcher::Shared().Resume(watchId);
+    }, false);
+}
+
+void Terminal::DiffWithPreviousRun(uint64_t blockId) {
+    // Both outputs have to be in memory: fully captured, nothing spilled
+    auto diffable = [](const CommandBlock& block) {
+        return block.status != CommandStatus::Running && !block.watching && block.outputFoldedInto == 0 &&
+               block.output.SpilledBytes() == 0 && block.binaryBytes == 0;
+    };
+    
+    std::string before;
+    std::string after;
+    uint64_t baseId = 0;
+    {
+        auto lock = LockHistory();
+        CommandBlock* block = FindBlock(blockId);
+        if (!block || !diffable(*block)) return;
+        
+        // The latest earlier run of the same command in the same directory,
+        // passing over runs that are watched, spilled or already folded
+        for (auto it = history_.rbegin(); it != history_.rend(); ++it) {
+            if (it->id >= blockId || it->input != block->input ||
+                it->workingDirectory != block->workingDirectory || !diffable(*it)) {
+                continue;
+            }
+            baseId = it->id;
+            break;
+        }
+        if (baseId == 0) return;
+        before = FindBlock(baseId)->output.Str();
+        after = block->output.Str();
+    }
+    
+    OutputDiff diff;
+    if (!LineDiff::Diff(before, after, diff)) return;
+    diff.baseBlockId = baseId;
+    
+    auto lock = LockHistory();
+    CommandBlock* block = FindBlock(blockId);
+    CommandBlock* base = FindBlock(baseId);
+    // Either one may have been rerun or folded meanwhile
+    if (!block || !base || !diffable(*block) || !diffable(*base) ||
+        block->output.Size() != after.size() || base->output.Size() != before.size()) {
+        return;
+    }
+    block->diff = std::move(diff);
+    
+    // Plain stdout is rebuilt exactly from the diff; colors and stderr tags would be lost
+    bool plain = base->styles.empty() &&
+                 std::all_of(base->segments.begin(), base->segments.end(),
+                             [](const OutputSegment& segment) { return segment.stream == OutputStream::Stdout; });
+    if (plain && block->diff.MemoryBytes() < base->output.MemoryBytes()) {
+        // Its own diff stays: runs before it may be folded into it
+        base->output.Clear();
+        base->segments.clear();
+        base->lines.Clear();
+        base->outputFoldedInto = blockId;
+    }
+}
+
+std::string Terminal::RebuildOutput(uint64_t blockId) {
+    auto lock = LockHistory();
+    // Follow the chain to the run that still has its output, then rebuild back down it
+    std::vector<const CommandBlock*> chain;
+    const CommandBlock* block = FindBlock(blockId);
+    while (block && block->outputFoldedInto != 0) {
+        chain.push_back(block);
+        block = FindBlock(block->outputFoldedInto);
+    }
+    if (!block) return std::string();
+    
+    std::string text = block->output.Str();
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        text = FindBlock((*it)->outputFoldedInto)->diff.Rebuild(text);
+    }
+    return text;
+}
+
+void Terminal::UnfoldInto(uint64_t blockId) {
+    for (auto& block : history_) {
+        if (block.outputFoldedInto != blockId) continue;
+        std::string text = RebuildOutput(block.id);
+        block.outputFoldedInto = 0;
+        // Its own diff stays: earlier runs may still be folded into it
+        OutputDiff diff = std::move(block.diff);
+        block.ClearOutput();
+        block.diff = std::move(diff);
+        block.AppendOutput(OutputStream::Stdout, text.data(), text.size());
+        block.FinishOutput();
+    }
+}
+
+void Terminal::DispatchPlan(const std::shared_ptr<PlanRun>& run) {
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(run->mutex);
+        for (size_t i = 0; i < run->plan.size() && run->running < run->limit; ++i) {
+            if (run->started[i] || run->remainingDeps[i] > 0) continue;
+            run->started[i] = true;
+            run->running++;
+            ready.push_back(i);
+        }
+    }
+    
+    for (size_t i : ready) {
+        // Read the directory now, after any cd this command was ordered behind
+        WorkingDirectory workingDir = executor_->GetWorkingDirectoryHandle();
+        ThreadPool::Shared().Submit([this, run, i, workingDir]() {
+            auto finished = [this, run, i]() {
+                {
+                    std::lock_guard<std::mutex> lock(run->mutex);
+                    run->running--;
+                    for (size_t next : run->dependents[i]) {
+                        run->remainingDeps[next]--;
+                    }
+                }
+                DispatchPlan(run);
+            };
+            
+            if (run->session) {
+                RunInSession(run->session, run->plan[i].command, run->blockIds[i]);
+                finished();
+            } else {
+                RunStreaming(run->plan[i].command, run->blockIds[i], workingDir, CommandOrigin::AIBatch, finished);
+            }
+        }, TaskPriority::Interactive);
+    }
+}
+
+void Terminal::RunCommand(const std::string& command, bool isAIGenerated, const std::string& nlpPrompt,
+                          bool background) {
     if (command.empty()) return;
     
-    CommandBlock block = executor_->Execute(command);
-    block.isAIGenerated = true;
+    // Learn what follows what; anything that could write drops speculative results
+    std::shared_ptr<ShellSession> session = GetSession();
+    bool sessionCommand = session && command != "clear" && command != "exit";
+    bool builtIn = !sessionCommand && IsBuiltInCommand(command);
+    speculator_.Observe(command, builtIn);
+    
+    if (!session && IsJobCommand(command)) {
+        auto lock = LockHistory();
+        CommandBlock block;
+        RunJobCommand(command, block);
+        block.id = nextBlockId_++;
+        history_.push_back(block);
+        historyNavigationIndex_ = -1;
+        return;
+    }
+    
+    // Built-ins change executor state (cd) and finish instantly, so run them inline.
+    // A session shell handles cd and pwd itself; only UI commands stay local.
+    if (builtIn) {
+        CommandBlock block = executor_->ExecuteBuiltIn(command);
+        block.isAIGenerated = isAIGenerated;
+        block.aiPrompt = nlpPrompt;
+        
+        {
+            auto lock = LockHistory();
+            block.id = nextBlockId_++;
+            history_.push_back(block);
+            historyNavigationIndex_ = -1;
+        }
+        SpeculateAfter(command);
+        return;
+    }
+    
+    uint64_t blockId;
+    {
+        auto lock = LockHistory();
+        blockId = AddRunningBlock(command, isAIGenerated, nlpPrompt);
+        if (background) {
+            history_.back().jobNumber = jobs_.Add(blockId, command);
+        }
+    }
+    
+    if (sessionCommand) {
+        ThreadPool::Shared().Submit([this, session, command, blockId]() {
+            RunInSession(session, command, blockId);
+        }, TaskPriority::Interactive);
+        return;
+    }
+    
+    WorkingDirectory workingDir = executor_->GetWorkingDirectoryHandle();
+    CommandOrigin origin = background ? CommandOrigin::Background : CommandOrigin::Interactive;
+    ThreadPool::Shared().Submit([this, command, workingDir, blockId, origin]() {
+        RunStreaming(command, blockId, workingDir, origin, [this, command]() { SpeculateAfter(command); });
+    }, TaskPriority::Interactive);
+}
+
+void Terminal::SpeculateAfter(const std::string& command) {
+    if (IsSessionMode()) return;
+    speculator_.Speculate(command, executor_->GetWorkingDirectoryHandle());
+}
+
+uint64_t Terminal::AddRunningBlock(const std::string& command, bool isAIGenerated, const std::string& nlpPrompt) {
+    CommandBlock block;
+    block.id = nextBlockId_++;
+    block.input = command;
+    block.workingDirectory = GetWorkingDirectory();
+    block.status = CommandStatus::Running;
+    block.isAIGenerated = isAIGenerated;
     block.aiPrompt = nlpPrompt;
     
     history_.push_back(block);
+    cancelTokens_[block.id] = std::make_shared<CancelToken>();
     historyNavigationIndex_ = -1;
+    return block.id;
+}
+
+std::shared_ptr<CancelToken> Terminal::GetCancelToken(uint64_t blockId) {
+    auto lock = LockHistory();
+    auto it = cancelTokens_.find(blockId);
+    return it != cancelTokens_.end() ? it->second : nullptr;
+}
+
+bool Terminal::CancelCommand(uint64_t blockId) {
+    auto lock = LockHistory();
+    auto token = GetCancelToken(blockId);
+    if (!token) return false;
+    token->Cancel();
+    // A stopped job only sees the stop signals once it runs again
+    CommandBlock* block = FindBlock(blockId);
+    if (block && block->stopped) {
+        ResumeCommand(blockId, false);
+    }
+    return true;
+}
+
+void Terminal::CancelAll() {
+    auto lock = LockHistory();
+    for (auto& entry : cancelTokens_) {
+        CancelCommand(entry.first);
+    }
+}
+
+bool Terminal::SuspendCommand(uint64_t blockId) {
+    auto lock = LockHistory();
+    auto token = GetCancelToken(blockId);
+    CommandBlock* block = FindBlock(blockId);
+    if (!token || !block || block->stopped || !token->Signal(kStopSignal)) return false;
+    
+    block->stopped = true;
+    if (block->jobNumber == 0) {
+        block->jobNumber = jobs_.Add(blockId, block->input, JobState::Stopped);
+    } else {
+        jobs_.SetState(block->jobNumber, JobState::Stopped);
+    }
+    return true;
+}
+
+bool Terminal::ResumeCommand(uint64_t blockId, bool foreground) {
+    auto lock = LockHistory();
+    auto token = GetCancelToken(blockId);
+    CommandBlock* block = FindBlock(blockId);
+    if (!token || !block || block->jobNumber == 0) return false;
+    if (block->stopped && !token->Signal(kContinueSignal)) return false;
+    
+    block->stopped = false;
+    if (foreground) {
+        jobs_.Remove(block->jobNumber);
+        block->jobNumber = 0;
+    } else {
+        jobs_.SetState(block->jobNumber, JobState::Running);
+    }
+    return true;
+}
+
+std::vector<Job> Terminal::GetJobs() const {
+    auto lock = LockHistory();
+    return jobs_.Jobs();
+}
+
+void Terminal::FinishJob(CommandBlock& block) {
+    block.stopped = false;
+    if (block.jobNumber != 0) {
+        jobs_.Finish(block.id, block.exitCode);
+    }
+}
+
+void Terminal::RunStreaming(const std::string& command, uint64_t blockId, const WorkingDirectory& workingDir,
+                            CommandOrigin origin, std::function<void()> onFinished, bool replay) {
+    // A speculative run that already finished, or a read-only command whose
+    // inputs haven't changed, replays its output
+    CommandCache::Ticket ticket = cache_.Prepare(command, workingDir.Path());
+    CachedResult ready;
+    bool speculated = replay && speculator_.Take(command, workingDir.Path(), ready);
+    if (speculated || (replay && cache_.Lookup(ticket, ready))) {
+        ReplayResult(blockId, ready, workingDir, speculated);
+        if (speculated) {
+            auto lock = LockHistory();
+            if (const CommandBlock* block = FindBlock(blockId)) cache_.Store(ticket, *block);
+        }
+        ThreadPool::Shared().Submit([this, blockId]() { DiffWithPreviousRun(blockId); }, TaskPriority::Background);
+        if (onFinished) onFinished();
+        return;
+    }
+    
+    ResourceLimits limits;
+    if (limitMode_ == LimitMode::All) {
+        limits = limits_;
+    } else if (limitMode_ == LimitMode::AIGenerated) {
+        auto lock = LockHistory();
+        const CommandBlock* block = FindBlock(blockId);
+        if (block && block->isAIGenerated) limits = limits_;
+    }
+    limits.priority = priorities_.For(origin);
+    
+    // The reactor thread streams output in and completes the block; this worker is free once it has started
+    std::shared_ptr<OutputThrottle> throttle;
+    {
+        auto lock = LockHistory();
+        throttle = StartThrottle(blockId);
+        reactorRuns_++;
+    }
+    auto onOutput = [this, blockId, throttle](OutputStream stream, const char* data, size_t size) {
+        QueueOutput(blockId, *throttle, stream, data, size);
+    };
+    auto onComplete = [this, blockId, ticket, throttle, onFinished](const CommandBlock& result) {
+        FinishThrottle(blockId, *throttle);
+        {
+            auto lock = LockHistory();
+            cancelTokens_.erase(blockId);
+            if (CommandBlock* block = FindBlock(blockId)) {
+                block->FinishOutput();
+                block->workingDirectory = result.workingDirectory;
+                block->status = result.status;
+                block->exitCode = result.exitCode;
+                block->termSignal = result.termSignal;
+                block->usage = result.usage;
+                block->nativeBuiltin = result.nativeBuiltin;
+                block->pipeline = result.pipeline;
+                FinishJob(*block);
+                cache_.Store(ticket, *block);
+            }
+        }
+        ThreadPool::Shared().Submit([this, blockId]() { DiffWithPreviousRun(blockId); }, TaskPriority::Background);
+        if (onFinished) onFinished();
+        
+        // The destructor may go ahead once this is the last one
+        auto lock = LockHistory();
+        if (--reactorRuns_ == 0) reactorIdle_.notify_all();
+    };
+    executor_->ExecuteReactive(command, onOutput, onComplete, workingDir, GetCancelToken(blockId), limits);
+}
+
+void Terminal::ReplayResult(uint64_t blockId, const CachedResult& result, const WorkingDirectory& workingDir,
+                            bool speculated) {
+    auto lock = LockHistory();
+    cancelTokens_.erase(blockId);
+    CommandBlock* block = FindBlock(blockId);
+    if (!block) return;
+    
+    block->output = result.output;
+    block->segments = result.segments;
+    block->styles = result.styles;
+    block->lines = result.lines;
+    block->binaryBytes = result.binaryBytes;
+    block->workingDirectory = workingDir.Path();
+    block->exitCode = result.exitCode;
+    block->status = CommandStatus::Success;
+    block->fromCache = !speculated;
+    block->speculated = speculated;
+    FinishJob(*block);
+}
+
+std::shared_ptr<ShellSession> Terminal::GetSession() const {
+    auto lock = LockHistory();
+    return session_;
+}
+
+void Terminal::RunInSession(const std::shared_ptr<ShellSession>& session, const std::string& command,
+                            uint64_t blockId) {
+    std::shared_ptr<OutputThrottle> throttle;
+    {
+        auto lock = LockHistory();
+        throttle = StartThrottle(blockId);
+    }
+    auto appendOutput = [this, blockId, throttle](const char* data, size_t size) {
+        QueueOutput(blockId, *throttle, OutputStream::Stdout, data, size);
+    };
+    
+    // The session shell survives a cancel; only its foreground job is stopped
+    std::shared_ptr<CancelToken> cancel = GetCancelToken(blockId);
+    if (cancel) {
+        executor_->ApplyLimits(*cancel, command);
+    }
+    
+    ProcessExit result;
+    try {
+        result = session->Run(command, appendOutput, cancel.get());
+    } catch (const std::exception& e) {
+        std::string message = std::string("Error: ") + e.what();
+        auto lock = LockHistory();
+        if (CommandBlock* block = FindBlock(blockId)) {
+            block->AppendOutput(OutputStream::Stderr, message.data(), message.size());
+        }
+        result.exitCode = 1;
+    }
+    
+    FinishThrottle(blockId, *throttle);
+    auto lock = LockHistory();
+    cancelTokens_.erase(blockId);
+    if (CommandBlock* block = FindBlock(blockId)) {
+        block->FinishOutput();
+        if (cancel && cancel->IsCancelled()) {
+            std::ostringstream note;
+            if (cancel->TimedOut()) {
+                note << "\n[Timed out after " << cancel->GetTimeout() << "s]\n";
+            } else {
+                note << "\n[Cancelled]\n";
+            }
+            std::string text = note.str();
+            block->AppendOutput(OutputStream::Stderr, text.data(), text.size());
+            block->status = CommandStatus::Cancelled;
+        } else {
+            block->status = result.exitCode == 0 ? CommandStatus::Success : CommandStatus::Failed;
+        }
+        block->exitCode = result.exitCode;
+        block->usage = result.usage;
+    }
+}
+
+bool Terminal::SetSessionMode(bool enabled) {
+    if (!enabled) {
+        // Swapped out under the lock; the shell goes once its last command is done
+        std::shared_ptr<ShellSession> old;
+        {
+            auto lock = LockHistory();
+            old.swap(session_);
+        }
+        return true;
+    }
+    if (IsSessionMode()) return true;
+    
+    auto session = std::make_shared<ShellSession>();
+    if (!session->Start(executor_->GetWorkingDirectory())) {
+        return false;
+    }
+    auto lock = LockHistory();
+    if (!session_) {
+        session_ = std::move(session);
+    }
+    return true;
+}
+
+std::unique_lock<std::recursive_mutex> Terminal::LockHistory() const {
+    return std::unique_lock<std::recursive_mutex>(historyMutex_);
+}
+
+void Terminal::PublishOutput() {
+    auto lock = LockHistory();
+    auto now = OutputThrottle::Clock::now();
+    for (auto& entry : throttles_) {
+        if (entry.second->Stranded(now)) {
+            PublishQueued(entry.first, *entry.second);
+        }
+    }
+}
+
+void Terminal::QueueOutput(uint64_t blockId, OutputThrottle& throttle, OutputStream stream,
+                           const char* data, size_t size) {
+    if (!throttle.Add(stream, data, size)) return;
+    
+    // Mid-frame the UI holds the lock; keep queuing and try again with the next chunk
+    std::unique_lock<std::recursive_mutex> lock(historyMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        if (!throttle.Full()) return;
+        lock.lock();
+    }
+    PublishQueued(blockId, throttle);
+}
+
+void Terminal::PublishQueued(uint64_t blockId, OutputThrottle& throttle) {
+    auto start = OutputThrottle::Clock::now();
+    std::vector<OutputThrottle::Chunk> batch = throttle.Take(start);
+    CommandBlock* block = FindBlock(blockId);
+    if (!block) return;
+    size_t bytes = 0;
+    for (const auto& chunk : batch) {
+        block->AppendOutput(chunk.stream, chunk.data.data(), chunk.data.size());
+        bytes += chunk.data.size();
+    }
+    block->flooding = throttle.Flooding();
+    block->outputBytesPerSecond = throttle.BytesPerSecond();
+    
+    // Times the append so the next batch fits the lock budget
+    auto end = OutputThrottle::Clock::now();
+    throttle.Published(bytes, end - start, end);
+}
+
+std::shared_ptr<OutputThrottle> Terminal::StartThrottle(uint64_t blockId) {
+    auto throttle = std::make_shared<OutputThrottle>();
+    throttles_[blockId] = throttle;
+    return throttle;
+}
+
+void Terminal::FinishThrottle(uint64_t blockId, OutputThrottle& throttle) {
+    while (!throttle.Empty()) {
+        auto lock = LockHistory();
+        PublishQueued(blockId, throttle);
+    }
+    auto lock = LockHistory();
+    throttles_.erase(blockId);
+    if (CommandBlock* block = FindBlock(blockId)) {
+        block->flooding = false;
+    }
+}
+
+CommandBlock* Terminal::FindBlock(uint64_t id) {
+    auto it = std::lower_bound(history_.begin(), history_.end(), id,
+        [](const CommandBlock& block, uint64_t value) { return block.id < value; });
+    if (it == history_.end() || it->id != id) return nullptr;
+    return &*it;
 }
 
 void Terminal::ClearHistory() {
+    auto lock = LockHistory();
+    for (const auto& entry : watches_) {
+        FileWatcher::Shared().Remove(entry.second.watchId);
+    }
+    watches_.clear();
     history_.clear();
     historyNavigationIndex_ = -1;
 }
@@ -48,6 +831,9 @@ void Terminal::ClearScreen() {
 }
 
 std::string Terminal::GetWorkingDirectory() const {
+    if (std::shared_ptr<ShellSession> session = GetSession()) {
+        return session->GetWorkingDirectory();
+    }
     if (executor_) {
         return executor_->GetWorkingDirectory();
     }
@@ -55,16 +841,18 @@ std::string Terminal::GetWorkingDirectory() const {
 }
 
 const CommandBlock* Terminal::GetLastCommand() const {
+    auto lock = LockHistory();
     if (history_.empty()) return nullptr;
     return &history_.back();
 }
 
 std::vector<CommandBlock> Terminal::SearchHistory(const std::string& query) const {
     std::vector<CommandBlock> results;
+    auto lock = LockHistory();
     
     for (const auto& block : history_) {
         if (block.input.find(query) != std::string::npos ||
-            block.output.find(query) != std::string::npos) {
+            block.output.Find(query) != std::string::npos) {
             results.push_back(block);
         }
     }
@@ -72,7 +860,34 @@ std::vector<CommandBlock> Terminal::SearchHistory(const std::string& query) cons
     return results;
 }
 
+std::vector<CommandCost> Terminal::GetCommandCosts() const {
+    std::map<std::string, CommandCost> byCommand;
+    {
+        auto lock = LockHistory();
+        for (const auto& block : history_) {
+            if (block.status == CommandStatus::Running) continue;
+            
+            CommandCost& cost = byCommand[block.input];
+            cost.command = block.input;
+            cost.runs++;
+            cost.totalWallSeconds += block.usage.wallSeconds;
+            cost.totalCpuSeconds += block.usage.CpuSeconds();
+            cost.peakRssKb = std::max(cost.peakRssKb, block.usage.maxRssKb);
+        }
+    }
+    
+    std::vector<CommandCost> costs;
+    for (auto& entry : byCommand) {
+        costs.push_back(std::move(entry.second));
+    }
+    std::sort(costs.begin(), costs.end(), [](const CommandCost& a, const CommandCost& b) {
+        return a.totalCpuSeconds > b.totalCpuSeconds;
+    });
+    return costs;
+}
+
 std::string Terminal::GetPreviousCommand() {
+    auto lock = LockHistory();
     if (history_.empty()) return "";
     
     if (historyNavigationIndex_ == -1) {
@@ -89,6 +904,7 @@ std::string Terminal::GetPreviousCommand() {
 }
 
 std::string Terminal::GetNextCommand() {
+    auto lock = LockHistory();
     if (historyNavigationIndex_ == -1 || history_.empty()) return "";
     
     historyNavigationIndex_++;
@@ -143,8 +959,121 @@ bool Terminal::IsBuiltInCommand(const std::string& command) const {
     return executor_->IsBuiltInCommand(command);
 }
 
+bool Terminal::IsJobCommand(const std::string& command) const {
+    std::vector<std::string> words = SplitWords(command);
+    if (words.empty()) return false;
+    if (words[0] == "jobs" || words[0] == "fg" || words[0] == "bg") return true;
+    // Plain kill with pids is left to the system's kill
+    return words[0] == "kill" &&
+           std::any_of(words.begin() + 1, words.end(), [](const std::string& word) { return word[0] == '%'; });
+}
+
+void Terminal::RunJobCommand(const std::string& command, CommandBlock& block) {
+    std::vector<std::string> words = SplitWords(command);
+    const std::string& name = words[0];
+    std::vector<std::string> specs(words.begin() + 1, words.end());
+    std::ostringstream out;
+    int exitCode = 0;
+    
+    block.input = command;
+    block.workingDirectory = GetWorkingDirectory();
+    
+    if (name == "jobs") {
+        out << jobs_.Reap();
+    } else if (name == "fg" || name == "bg") {
+        // fg takes one job, bg any number; both default to the current one
+        bool current = specs.empty();
+        if (current) specs.push_back("%+");
+        if (name == "fg") specs.resize(1);
+        for (const auto& spec : specs) {
+            Job* job = jobs_.Resolve(spec);
+            if (!job) {
+                out << name << ": " << (current ? "no current job" : spec + ": no such job") << "\n";
+                exitCode = 1;
+                continue;
+            }
+            if (job->state == JobState::Done) {
+                out << name << ": job " << job->number << " has terminated\n";
+                jobs_.Remove(job->number);
+                exitCode = 1;
+                continue;
+            }
+            int number = job->number;
+            std::string jobCommand = job->command;
+            if (name == "bg" && job->state == JobState::Running) {
+                out << "bg: job " << number << " already in background\n";
+            } else if (!ResumeCommand(job->blockId, name == "fg")) {
+                out << name << ": job " << number << " can't be continued\n";
+                exitCode = 1;
+            } else if (name == "fg") {
+                out << jobCommand << "\n";
+            } else {
+                out << "[" << number << "]" << jobs_.Marker(number) << " " << jobCommand << " &\n";
+            }
+        }
+    } else {
+        // kill [-s SIGNAL | -SIGNAL] %job|pid ...
+        int signal = SIGTERM;
+        size_t first = 0;
+        if (!specs.empty() && specs[0] == "-s" && specs.size() > 1) {
+            signal = JobTable::SignalNumber(specs[1]);
+            first = 2;
+        } else if (!specs.empty() && specs[0].size() > 1 && specs[0][0] == '-') {
+            signal = JobTable::SignalNumber(specs[0].substr(1));
+            first = 1;
+        }
+        if (signal < 0) {
+            out << "kill: " << specs[first - 1] << ": invalid signal specification\n";
+            exitCode = 1;
+            specs.clear();
+        }
+        
+        for (size_t i = first; i < specs.size(); ++i) {
+            const std::string& spec = specs[i];
+            if (spec[0] != '%') {
+#ifndef _WIN32
+                bool isPid = std::all_of(spec.begin(), spec.end(), [](char c) { return c >= '0' && c <= '9'; });
+                if (isPid && spec.size() < 10 && ::kill(std::stoi(spec), signal) == 0) continue;
+#endif
+                out << "kill: (" << spec << ") - No such process\n";
+                exitCode = 1;
+                continue;
+            }
+            Job* job = jobs_.Resolve(spec);
+            auto token = job ? GetCancelToken(job->blockId) : nullptr;
+            if (!job || !token) {
+                out << "kill: " << spec << ": no such job\n";
+                exitCode = 1;
+                continue;
+            }
+            if (!token->Signal(signal)) {
+                out << "kill: " << spec << ": can't signal this job\n";
+                exitCode = 1;
+                continue;
+            }
+            
+            CommandBlock* target = FindBlock(job->blockId);
+            if (signal == kStopSignal || signal == kTerminalStopSignal) {
+                if (target) target->stopped = true;
+                jobs_.SetState(job->number, JobState::Stopped);
+            } else if (signal == kContinueSignal || job->state == JobState::Stopped) {
+                // Like a shell, continue a stopped job so it can act on the signal
+                if (signal != kContinueSignal) token->Signal(kContinueSignal);
+                if (target) target->stopped = false;
+                jobs_.SetState(job->number, JobState::Running);
+            }
+        }
+    }
+    
+    block.output = out.str();
+    block.exitCode = exitCode;
+    block.status = exitCode == 0 ? CommandStatus::Success : CommandStatus::Failed;
+}
+
 void Terminal::HandleBuiltInCommand(const std::string& command) {
     CommandBlock block = executor_->ExecuteBuiltIn(command);
+    auto lock = LockHistory();
+    block.id = nextBlockId_++;
     history_.push_back(block);
 }
 
@@ -0,0 +1,153 @@
+#include "terminal/working_directory.h"
+#include <filesystem>
+#include <vector>
+#include <cerrno>
+#include <climits>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace NeuroShell {
+
+namespace {
+
+#ifndef _WIN32
+
+// O_PATH needs no read permission on the directory, just like chdir()
+#ifdef O_PATH
+constexpr int kOpenFlags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#else
+constexpr int kOpenFlags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+#endif
+
+// getcwd() into a buffer that grows until the path fits
+std::string CurrentPath() {
+    std::vector<char> buffer(4096);
+    while (getcwd(buffer.data(), buffer.size()) == nullptr) {
+        if (errno != ERANGE) return "";
+        buffer.resize(buffer.size() * 2);
+    }
+    return buffer.data();
+}
+
+// Where the kernel says fd points; empty if it can't tell
+std::string PathOfFd(int fd) {
+#if defined(__APPLE__)
+    char buffer[PATH_MAX];
+    return fcntl(fd, F_GETPATH, buffer) == 0 ? std::string(buffer) : std::string();
+#else
+    std::string link = "/proc/self/fd/" + std::to_string(fd);
+    std::vector<char> buffer(4096);
+    ssize_t length;
+    while ((length = readlink(link.c_str(), buffer.data(), buffer.size())) == static_cast<ssize_t>(buffer.size())) {
+        buffer.resize(buffer.size() * 2);
+    }
+    return length > 0 ? std::string(buffer.data(), static_cast<size_t>(length)) : std::string();
+#endif
+}
+
+#endif
+
+// base/path with . and .. folded away and no trailing separator
+std::string JoinLexically(const std::string& base, const std::string& path) {
+    fs::path joined = fs::path(path).is_absolute() ? fs::path(path) : fs::path(base) / path;
+    joined = joined.lexically_normal();
+    std::string text = joined.string();
+    if (text.size() > 1 && joined.has_relative_path() && !joined.has_filename()) {
+        text.pop_back();
+    }
+    return text;
+}
+
+bool HasParentStep(const std::string& path) {
+    for (const auto& part : fs::path(path)) {
+        if (part == "..") return true;
+    }
+    return false;
+}
+
+} // namespace
+
+class WorkingDirectory::Handle {
+public:
+    explicit Handle(int fd) : fd_(fd) {}
+    ~Handle() {
+#ifndef _WIN32
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    int Fd() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+WorkingDirectory::WorkingDirectory() = default;
+
+int WorkingDirectory::Fd() const {
+    return handle_ ? handle_->Fd() : -1;
+}
+
+WorkingDirectory WorkingDirectory::Current() {
+    WorkingDirectory dir;
+#ifdef _WIN32
+    std::error_code ec;
+    dir.path_ = fs::current_path(ec).string();
+#else
+    dir.path_ = CurrentPath();
+    int fd = open(".", kOpenFlags);
+    if (fd >= 0) {
+        dir.handle_ = std::make_shared<Handle>(fd);
+    }
+#endif
+    return dir;
+}
+
+bool WorkingDirectory::Resolve(const std::string& path, WorkingDirectory& result) const {
+    if (path.empty()) return false;
+
+#ifdef _WIN32
+    std::string target = JoinLexically(path_, path);
+    std::error_code ec;
+    if (!fs::is_directory(target, ec)) return false;
+    result.handle_.reset();
+    result.path_ = target;
+    return true;
+#else
+    // openat() ignores the base for absolute paths; without a descriptor fall back to the path
+    int base = Fd();
+    int fd = base >= 0 ? openat(base, path.c_str(), kOpenFlags)
+                       : open(JoinLexically(path_, path).c_str(), kOpenFlags);
+    if (fd < 0) return false;
+
+    // Opening needs no search permission on the directory itself, but entering it does
+    if (faccessat(fd, ".", X_OK, 0) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // Keep the path the user walked (symlinks and all) unless .. makes it ambiguous;
+    // then ask the kernel where the descriptor really is, like cd -P would
+    std::string shown;
+    if (HasParentStep(path)) {
+        shown = PathOfFd(fd);
+    }
+    if (shown.empty()) {
+        shown = JoinLexically(path_, path);
+    }
+
+    result.handle_ = std::make_shared<Handle>(fd);
+    result.path_ = shown;
+    return true;
+#endif
+}
+
+} // namespace NeuroShell
@@ -3,6 +3,20 @@
 
 namespace NeuroShell {
 
+namespace {
+
+ImVec4 FromRgb(uint32_t rgb) {
+    return ImVec4(((rgb >> 16) & 0xFF) / 255.0f, ((rgb >> 8) & 0xFF) / 255.0f, (rgb & 0xFF) / 255.0f, 1.0f);
+}
+
+void SetAnsiPalette(ThemeColors& colors, const uint32_t (&palette)[16]) {
+    for (int i = 0; i < 16; ++i) {
+        colors.ansi[i] = FromRgb(palette[i]);
+    }
+}
+
+} // namespace
+
 void Theme::ApplyTokyoNight() {
     ThemeColors colors = GetTokyoNightColors();
     SetImGuiColors(colors);
@@ -30,6 +44,10 @@ ThemeColors Theme::GetTokyoNightColors() {
     colors.accent = ImVec4(0.46f, 0.67f, 0.98f, 1.00f);          // #7aa2f7 (blue)
     colors.border = ImVec4(0.20f, 0.22f, 0.27f, 1.00f);          // #414868
     colors.scrollbar = ImVec4(0.16f, 0.18f, 0.22f, 1.00f);       // #292e42
+    SetAnsiPalette(colors, {
+        0x15161e, 0xf7768e, 0x9ece6a, 0xe0af68, 0x7aa2f7, 0xbb9af7, 0x7dcfff, 0xa9b1d6,
+        0x414868, 0xf7768e, 0x9ece6a, 0xe0af68, 0x7aa2f7, 0xbb9af7, 0x7dcfff, 0xc0caf5
+    });
     
     return colors;
 }
@@ -50,6 +68,10 @@ ThemeColors Theme::GetWarpDarkColors() {
     colors.accent = ImVec4(0.38f, 0.78f, 0.95f, 1.00f);
     colors.border = ImVec4(0.18f, 0.20f, 0.24f, 1.00f);
     colors.scrollbar = ImVec4(0.14f, 0.16f, 0.19f, 1.00f);
+    SetAnsiPalette(colors, {
+        0x616161, 0xff8272, 0xb4fa72, 0xfefdc2, 0xa5d5fe, 0xff8ffd, 0xd0d1fe, 0xf1f1f1,
+        0x8e8e8e, 0xffc4bd, 0xd6fcb9, 0xfefdd5, 0xc1e3fe, 0xffb1fe, 0xe5e6fe, 0xfeffff
+    });
     
     return colors;
 }
@@ -70,10 +92,36 @@ ThemeColors Theme::GetHyperColors() {
     colors.accent = ImVec4(0.00f, 1.00f, 0.65f, 1.00f);
     colors.border = ImVec4(0.15f, 0.15f, 0.15f, 1.00f);
     colors.scrollbar = ImVec4(0.10f, 0.10f, 0.10f, 1.00f);
+    SetAnsiPalette(colors, {
+        0x000000, 0xfe0100, 0x33ff00, 0xfeff00, 0x0066ff, 0xcc00ff, 0x00ffff, 0xd0d0d0,
+        0x808080, 0xfe0100, 0x33ff00, 0xfeff00, 0x0066ff, 0xcc00ff, 0x00ffff, 0xffffff
+    });
     
     return colors;
 }
 
+ImVec4 Theme::AnsiColor(const ThemeColors& colors, uint32_t color, const ImVec4& defaultColor) {
+    if (color & kRgbColor) {
+        return FromRgb(color & 0xFFFFFF);
+    }
+    if (!(color & kPaletteColor)) {
+        return defaultColor;
+    }
+    
+    int index = static_cast<int>(color & 0xFF);
+    if (index < 16) {
+        return colors.ansi[index];
+    }
+    if (index < 232) {
+        // 6x6x6 cube: levels 0, 95, 135, 175, 215, 255
+        index -= 16;
+        auto level = [](int value) { return value == 0 ? 0 : 55 + value * 40; };
+        return FromRgb((level(index / 36) << 16) | (level(index / 6 % 6) << 8) | level(index % 6));
+    }
+    int gray = 8 + (index - 232) * 10;
+    return FromRgb((gray << 16) | (gray << 8) | gray);
+}
+
 void Theme::SetImGuiColors(const ThemeColors& colors) {
     ImGuiStyle& style = ImGui::GetStyle();
     ImVec4* styleColors = style.Colors;
@@ -1,5 +1,7 @@
 #include "ui/ui.h"
 #include "ui/theme.h"
+#include "common/thread_pool.h"
+#include "terminal/process_reactor.h"
 
 // DirectX 11 includes
 #include <d3d11.h>
@@ -14,6 +16,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -43,6 +47,14 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 
 namespace NeuroShell {
 
+// Outputs longer than this render one unwrapped row per line, only the visible ones
+constexpr size_t kClippedLines = 2000;
+// Most the pager reads from the spilled middle at once
+constexpr size_t kPageBytes = 256 * 1024;
+// What a block flooding with output shows: its last lines, up to so many bytes
+constexpr size_t kFloodTailLines = 200;
+constexpr size_t kFloodTailBytes = 64 * 1024;
+
 UI::UI()
     : window_(nullptr)
     , terminal_(nullptr)
@@ -174,6 +186,9 @@ void UI::Run() {
             CreateRenderTarget();
         }
         
+        // Output that went quiet before its batch was due
+        terminal_->PublishOutput();
+        
         // Start ImGui frame
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
@@ -206,6 +221,14 @@ void UI::Run() {
 }
 
 void UI::Shutdown() {
+    // Stop running commands, let the reactor report their exits, then finish
+    // queued work while the terminal and AI client it references still exist
+    if (terminal_) {
+        terminal_->CancelAll();
+    }
+    ProcessReactor::Shared().Shutdown();
+    ThreadPool::Shared().Shutdown();
+    
     if (window_) {
         SaveConfiguration();
         
@@ -357,6 +380,8 @@ void UI::RenderCMDStyle() {
     // Everything in one scrollable area - like real CMD
     ImGui::BeginChild("CMDOutput", ImVec2(0, 0), false, ImGuiWindowFlags_AlwaysVerticalScrollbar);
     
+    // Running commands append output from worker threads
+    auto historyLock = terminal_->LockHistory();
     const auto& history = terminal_->GetHistory();
     
     // Show welcome banner only when no commands have been run
@@ -417,14 +442,12 @@ void UI::RenderCMDStyle() {
         ImGui::PopStyleColor();
         
         // Show output
-        if (!block.output.empty()) {
-            if (block.status == CommandStatus::Failed) {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
-            } else {
-                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.9f, 0.9f, 1.0f));
-            }
-            ImGui::TextWrapped("%s", block.output.c_str());
-            ImGui::PopStyleColor();
+        if (!block.output.Empty()) {
+            ImVec4 errorColor = ImVec4(1.0f, 0.3f, 0.3f, 1.0f);
+            ImVec4 outputColor = block.status == CommandStatus::Failed
+                ? errorColor
+                : ImVec4(0.9f, 0.9f, 0.9f, 1.0f);
+            RenderBlockOutput(block, outputColor, errorColor);
         }
         
         ImGui::Spacing();
@@ -479,6 +502,7 @@ void UI::RenderHistorySidebar() {
     
     ImGui::Begin("📜 Command History", &showHistorySidebar_);
     
+    auto historyLock = terminal_->LockHistory();
     const auto& history = terminal_->GetHistory();
     
     if (history.empty()) {
@@ -490,6 +514,75 @@ void UI::RenderHistorySidebar() {
         return;
     }
     
+    // Commands that cost the most CPU across all their runs
+    if (ImGui::CollapsingHeader("Most expensive")) {
+        auto costs = terminal_->GetCommandCosts();
+        for (size_t i = 0; i < costs.size() && i < 5; ++i) {
+            const auto& cost = costs[i];
+            ImGui::TextWrapped("%s", cost.command.c_str());
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.6f, 0.6f, 0.6f, 1.0f));
+            ImGui::Text("  %dx  cpu %.2fs  wall %.2fs  rss %ld KB",
+                        cost.runs, cost.totalCpuSeconds, cost.totalWallSeconds, cost.peakRssKb);
+            ImGui::PopStyleColor();
+        }
+        ImGui::Separator();
+    }
+    
+    // Worker pool queues, to spot commands piling up behind busy workers
+    if (ImGui::CollapsingHeader("Worker pool")) {
+        ThreadPool& pool = ThreadPool::Shared();
+        ImGui::Text("%zu workers", pool.GetWorkerCount());
+        const std::pair<const char*, TaskPriority> lanes[] = {
+            { "Interactive", TaskPriority::Interactive },
+            { "Background", TaskPriority::Background }
+        };
+        for (const auto& lane : lanes) {
+            ThreadPool::LaneMetrics metrics = pool.GetMetrics(lane.second);
+            ImGui::Text("%s", lane.first);
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.6f, 0.6f, 0.6f, 1.0f));
+            ImGui::Text("  queued %zu (max %zu)  done %llu/%llu",
+                        metrics.queueDepth, metrics.maxQueueDepth,
+                        static_cast<unsigned long long>(metrics.completed),
+                        static_cast<unsigned long long>(metrics.submitted));
+            ImGui::Text("  wait avg %.1fms max %.1fms  run avg %.1fms",
+                        metrics.avgWaitMs, metrics.maxWaitMs, metrics.avgRunMs);
+            ImGui::PopStyleColor();
+        }
+        ImGui::Separator();
+    }
+    
+    // Result cache effectiveness
+    if (ImGui::CollapsingHeader("Result cache")) {
+        CommandCache::Stats stats = terminal_->GetCacheStats();
+        uint64_t lookups = stats.hits + stats.misses;
+        ImGui::Text("%zu entries", stats.entries);
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.6f, 0.6f, 0.6f, 1.0f));
+        ImGui::Text("  hits %llu  misses %llu (%.0f%% hit)",
+                    static_cast<unsigned long long>(stats.hits),
+                    static_cast<unsigned long long>(stats.misses),
+                    lookups > 0 ? 100.0 * stats.hits / lookups : 0.0);
+        ImGui::Text("  invalidated %llu", static_cast<unsigned long long>(stats.invalidations));
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+    }
+    
+    // Speculative pre-execution: how often a prediction was used, and what the rest cost
+    if (ImGui::CollapsingHeader("Speculation")) {
+        SpeculativeRunner::Stats stats = terminal_->GetSpeculationStats();
+        ImGui::Text("%zu warm", stats.warm);
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.6f, 0.6f, 0.6f, 1.0f));
+        ImGui::Text("  started %llu  used %llu (%.0f%% hit)",
+                    static_cast<unsigned long long>(stats.started),
+                    static_cast<unsigned long long>(stats.hits),
+                    stats.started > 0 ? 100.0 * stats.hits / stats.started : 0.0);
+        ImGui::Text("  missed %llu  wasted %llu",
+                    static_cast<unsigned long long>(stats.misses),
+                    static_cast<unsigned long long>(stats.wasted));
+        ImGui::Text("  CPU %.2fs, wasted %.2fs", stats.cpuSeconds, stats.wastedCpuSeconds);
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+    }
+    
     // Reverse order - newest first
     for (int i = static_cast<int>(history.size()) - 1; i >= 0; --i) {
         const auto& block = history[i];
@@ -504,6 +597,9 @@ void UI::RenderHistorySidebar() {
         } else if (block.status == CommandStatus::Failed) {
             icon = "✗";
             color = ImVec4(1.0f, 0.3f, 0.3f, 1.0f);
+        } else if (block.status == CommandStatus::Cancelled) {
+            icon = "■";
+            color = ImVec4(1.0f, 0.7f, 0.3f, 1.0f);
         }
         
         ImGui::PushStyleColor(ImGuiCol_Text, color);
@@ -526,12 +622,26 @@ void UI::RenderHistorySidebar() {
             ImGui::BeginTooltip();
             ImGui::Text("Command: %s", block.input.c_str());
             ImGui::Text("Exit Code: %d", block.exitCode);
+            if (block.termSignal != 0) {
+                ImGui::Text("Killed by signal: %d", block.termSignal);
+            }
             
             auto time = std::chrono::system_clock::to_time_t(block.timestamp);
             char timeStr[100];
             std::strftime(timeStr, sizeof(timeStr), "%H:%M:%S", std::localtime(&time));
             ImGui::Text("Time: %s", timeStr);
             
+            if (block.status != CommandStatus::Running) {
+                const ResourceUsage& usage = block.usage;
+                ImGui::Separator();
+                ImGui::Text("Wall: %.3fs  User: %.3fs  Sys: %.3fs",
+                            usage.wallSeconds, usage.userCpuSeconds, usage.systemCpuSeconds);
+                ImGui::Text("Max RSS: %ld KB", usage.maxRssKb);
+                ImGui::Text("Block I/O: %ld in / %ld out", usage.blockReads, usage.blockWrites);
+                ImGui::Text("Context switches: %ld voluntary / %ld involuntary",
+                            usage.voluntarySwitches, usage.involuntarySwitches);
+            }
+            
             if (block.isAIGenerated) {
                 ImGui::Separator();
                 ImGui::Text("🤖 AI: %s", block.aiPrompt.c_str());
@@ -579,6 +689,7 @@ void UI::RenderTerminalArea() {
 }
 
 void UI::RenderCommandHistory() {
+    auto historyLock = terminal_->LockHistory();
     const auto& history = terminal_->GetHistory();
     
     if (history.empty()) {
@@ -617,9 +728,16 @@ void UI::RenderCommandBlock(const CommandBlock& block, int index) {
     }
     
     // Output
-    if (!block.output.empty()) {
-        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.text);
-        ImGui::TextWrapped("%s", block.output.c_str());
+    if (block.outputFoldedInto != 0) {
+        RenderFoldedOutput(block);
+    } else if (!block.diff.Empty() && changesOnly_.count(block.id)) {
+        RenderOutputDiff(block);
+    } else if (!block.output.Empty()) {
+        RenderBlockOutput(block, appState_.theme.text, appState_.theme.errorOutput);
+    }
+    if (block.binaryBytes > 0) {
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("[Binary output, %zu bytes]", block.binaryBytes);
         ImGui::PopStyleColor();
     }
     
@@ -628,21 +746,112 @@ void UI::RenderCommandBlock(const CommandBlock& block, int index) {
     const char* statusStr = "⏳ Running";
     ImVec4 statusColor = appState_.theme.textDim;
     
-    if (block.status == CommandStatus::Success) {
+    if (block.stopped) {
+        statusStr = "⏸ Stopped";
+        statusColor = ImVec4(1.0f, 0.7f, 0.3f, 1.0f);
+    } else if (block.status == CommandStatus::Success) {
         statusStr = "✓ Success";
         statusColor = appState_.theme.successOutput;
     } else if (block.status == CommandStatus::Failed) {
         statusStr = "✗ Failed";
         statusColor = appState_.theme.errorOutput;
+    } else if (block.status == CommandStatus::Cancelled) {
+        statusStr = "■ Cancelled";
+        statusColor = ImVec4(1.0f, 0.7f, 0.3f, 1.0f);
     }
     
     ImGui::PushStyleColor(ImGuiCol_Text, statusColor);
-    ImGui::Text("%s", statusStr);
+    if (block.jobNumber != 0 && block.status == CommandStatus::Running) {
+        ImGui::Text("[%d] %s", block.jobNumber, statusStr);
+    } else {
+        ImGui::Text("%s%s", statusStr, block.fromCache ? " (cached)" : block.speculated ? " (predicted)"
+                                      : block.nativeBuiltin ? " (builtin)" : "");
+    }
     ImGui::PopStyleColor();
     
     ImGui::SameLine();
-    ImGui::Text("| Exit: %d", block.exitCode);
-    ImGui::PopStyleColor();
+    if (block.status == CommandStatus::Running) {
+        ImGui::PopStyleColor();
+        if (ImGui::SmallButton("Stop")) {
+            terminal_->CancelCommand(block.id);
+        }
+        // Job control: suspend, then continue in the background or foreground
+        ImGui::SameLine();
+        if (block.stopped) {
+            if (ImGui::SmallButton("Continue")) {
+                terminal_->ResumeCommand(block.id, false);
+            }
+        } else if (ImGui::SmallButton("Suspend")) {
+            terminal_->SuspendCommand(block.id);
+        }
+        if (block.jobNumber != 0) {
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Foreground")) {
+                terminal_->ResumeCommand(block.id, true);
+            }
+        }
+    } else {
+        ImGui::Text("| Exit: %d", block.exitCode);
+        ImGui::PopStyleColor();
+    }
+    
+    // Exit status of every stage of a pipeline, with what each wrote to stderr on hover
+    if (!block.pipeline.empty() && block.status != CommandStatus::Running) {
+        std::string statuses;
+        for (const auto& stage : block.pipeline) {
+            statuses += " " + std::to_string(stage.exitCode);
+        }
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("| Pipeline:%s", statuses.c_str());
+        ImGui::PopStyleColor();
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            for (const auto& stage : block.pipeline) {
+                ImGui::PushStyleColor(ImGuiCol_Text, stage.exitCode == 0 ? appState_.theme.successOutput
+                                                                         : appState_.theme.errorOutput);
+                ImGui::Text("[%d] %s", stage.exitCode, stage.command.c_str());
+                ImGui::PopStyleColor();
+                if (!stage.stderrHead.empty()) {
+                    ImGui::Indent();
+                    ImGui::TextUnformatted(stage.stderrHead.data(), stage.stderrHead.data() + stage.stderrHead.size());
+                    ImGui::Unindent();
+                }
+            }
+            ImGui::EndTooltip();
+        }
+    }
+    
+    // Changes since the previous run of the same command
+    if (!block.diff.Empty() && block.status != CommandStatus::Running) {
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("| +%zu -%zu lines since last run", block.diff.insertedLines, block.diff.deletedLines);
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+        bool changesOnly = changesOnly_.count(block.id) > 0;
+        if (ImGui::SmallButton(changesOnly ? "Full output" : "Changes only")) {
+            if (changesOnly) {
+                changesOnly_.erase(block.id);
+            } else {
+                changesOnly_.insert(block.id);
+            }
+        }
+    }
+    
+    // Watch mode reruns the command in place whenever files change
+    ImGui::SameLine();
+    if (block.watching) {
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.accent);
+        ImGui::Text("| Watching (%u reruns)", block.watchReruns);
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Unwatch")) {
+            terminal_->StopWatch(block.id);
+        }
+    } else if (block.status != CommandStatus::Running && ImGui::SmallButton("Watch")) {
+        terminal_->StartWatch(block.id);
+    }
     
     ImGui::Spacing();
     ImGui::Separator();
@@ -651,6 +860,263 @@ void UI::RenderCommandBlock(const CommandBlock& block, int index) {
     ImGui::PopID();
 }
 
+void UI::RenderOutputDiff(const CommandBlock& block) {
+    const OutputDiff& diff = block.diff;
+    if (!diff.Changed()) {
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("No changes since the last run");
+        ImGui::PopStyleColor();
+        return;
+    }
+    
+    // Inserted lines come from this block's output, deleted ones from the diff itself
+    ImGui::PushTextWrapPos(0.0f);
+    size_t line = 0;
+    size_t deletedPos = 0;
+    for (const auto& run : diff.runs) {
+        if (run.op == DiffOp::Equal) {
+            ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+            ImGui::Text("  ... %u unchanged line%s", run.count, run.count == 1 ? "" : "s");
+            ImGui::PopStyleColor();
+            line += run.count;
+            continue;
+        }
+        
+        bool inserted = run.op == DiffOp::Insert;
+        ImGui::PushStyleColor(ImGuiCol_Text, inserted ? appState_.theme.successOutput : appState_.theme.errorOutput);
+        for (uint32_t i = 0; i < run.count; ++i) {
+            std::string text = inserted ? "+ " : "- ";
+            if (inserted) {
+                text += block.ReadLines(line + i, 1);
+            } else {
+                size_t newline = diff.deleted.find('\n', deletedPos);
+                size_t next = newline == std::string::npos ? diff.deleted.size() : newline + 1;
+                text.append(diff.deleted, deletedPos, next - deletedPos);
+                deletedPos = next;
+            }
+            if (text.back() == '\n') text.pop_back();
+            ImGui::TextUnformatted(text.data(), text.data() + text.size());
+        }
+        ImGui::PopStyleColor();
+        if (inserted) line += run.count;
+    }
+    ImGui::PopTextWrapPos();
+}
+
+void UI::RenderFoldedOutput(const CommandBlock& block) {
+    auto rebuilt = rebuiltOutput_.find(block.id);
+    if (rebuilt == rebuiltOutput_.end()) {
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("[Output kept as changes against a later run]");
+        ImGui::PopStyleColor();
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Show")) {
+            rebuiltOutput_[block.id] = terminal_->RebuildOutput(block.id);
+        }
+        return;
+    }
+    
+    ImGui::PushTextWrapPos(0.0f);
+    ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.text);
+    ImGui::TextUnformatted(rebuilt->second.data(), rebuilt->second.data() + rebuilt->second.size());
+    ImGui::PopStyleColor();
+    ImGui::PopTextWrapPos();
+}
+
+void UI::RenderBlockOutput(const CommandBlock& block, const ImVec4& stdoutColor, const ImVec4& stderrColor) {
+    // Output arriving faster than it could be laid out shows only its tail until it slows down or ends
+    if (block.flooding) {
+        RenderFloodTail(block, stdoutColor, stderrColor);
+        return;
+    }
+    
+    // Long outputs go unwrapped so every line is one row and only the visible rows get laid out
+    bool clipped = block.lines.LineCount() > kClippedLines;
+    if (!clipped) ImGui::PushTextWrapPos(0.0f);
+    const OutputBuffer& output = block.output;
+    const std::string& head = output.Head();
+    RenderOutputRegion(block, head.data(), 0, head.size(), clipped, stdoutColor, stderrColor);
+    
+    // The middle of a long output lives on disk; page it in only on request
+    if (output.SpilledBytes() > 0) {
+        LoadedMiddle& middle = loadedMiddle_[block.id];
+        if (middle.run != block.watchReruns) {
+            middle = LoadedMiddle{ block.watchReruns, "" };
+        }
+        const std::string& loaded = middle.text;
+        // Laid out in full: its line starts may have been thinned out, and it only holds what was asked for
+        RenderOutputRange(block, loaded.data(), head.size(), head.size() + loaded.size(), stdoutColor, stderrColor);
+        
+        size_t hidden = output.SpilledBytes() - loaded.size();
+        if (hidden > 0) {
+            ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+            ImGui::Text("... %.1f KB not shown%s ...", hidden / 1024.0, output.HasGap() ? " (partly lost)" : "");
+            ImGui::PopStyleColor();
+            ImGui::SameLine();
+            ImGui::PushID(static_cast<int>(block.id));
+            if (ImGui::SmallButton("Show 1000 more lines")) {
+                // Whole lines where the index allows, capped in bytes for very long ones
+                size_t from = head.size() + loaded.size();
+                size_t to = block.lines.LineStart(block.lines.LineAt(from, output) + 1000, output);
+                to = std::min({ to, output.TailOffset(), from + kPageBytes });
+                middle.text += output.Read(from, std::max<size_t>(to, from + 1) - from);
+            }
+            ImGui::PopID();
+        }
+    }
+    
+    const std::string& tail = output.Tail();
+    RenderOutputRegion(block, tail.data(), output.TailOffset(), output.Size(), clipped, stdoutColor, stderrColor);
+    if (!clipped) ImGui::PopTextWrapPos();
+}
+
+void UI::RenderFloodTail(const CommandBlock& block, const ImVec4& stdoutColor, const ImVec4& stderrColor) {
+    const OutputBuffer& output = block.output;
+    ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+    ImGui::Text("[Output arriving at %.1f MB/s, %.1f MB so far: showing the last lines]",
+                block.outputBytesPerSecond / (1024.0 * 1024.0), output.Size() / (1024.0 * 1024.0));
+    ImGui::PopStyleColor();
+    
+    size_t lineCount = block.lines.LineCount();
+    size_t from = block.lines.LineStart(lineCount > kFloodTailLines ? lineCount - kFloodTailLines : 0, output);
+    if (output.Size() - from > kFloodTailBytes) from = output.Size() - kFloodTailBytes;
+    std::string tail = output.Read(from, output.Size() - from);
+    RenderOutputRange(block, tail.data(), from, output.Size(), stdoutColor, stderrColor);
+}
+
+void UI::RenderOutputRegion(const CommandBlock& block, const char* text, size_t begin, size_t end, bool clipped,
+                            const ImVec4& stdoutColor, const ImVec4& stderrColor) {
+    if (!clipped || begin >= end) {
+        RenderOutputRange(block, text, begin, end, stdoutColor, stderrColor);
+        return;
+    }
+    
+    // One row per line; the line index finds the rows that scrolled into view
+    size_t firstLine = block.lines.LineAt(begin, block.output);
+    size_t lastLine = block.lines.LineAt(end - 1, block.output);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(lastLine - firstLine + 1), ImGui::GetTextLineHeightWithSpacing());
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            size_t line = firstLine + row;
+            size_t from = std::max(begin, block.lines.LineStart(line, block.output));
+            size_t to = std::min(end, block.lines.LineStart(line + 1, block.output));
+            if (to > from && text[to - 1 - begin] == '\n') --to;
+            if (from >= to) {
+                ImGui::TextUnformatted("");
+                continue;
+            }
+            RenderOutputRange(block, text + (from - begin), from, to, stdoutColor, stderrColor);
+        }
+    }
+    clipper.End();
+}
+
+void UI::RenderOutputRange(const CommandBlock& block, const char* text, size_t begin, size_t end,
+                           const ImVec4& stdoutColor, const ImVec4& stderrColor) {
+    if (begin >= end) return;
+    
+    // Blocks built without streaming (built-ins) carry no segments; all of it is stdout
+    if (block.segments.empty() && block.styles.empty()) {
+        ImGui::PushStyleColor(ImGuiCol_Text, stdoutColor);
+        ImGui::TextUnformatted(text, text + (end - begin));
+        ImGui::PopStyleColor();
+        return;
+    }
+    
+    // Walk the stream segments so stderr stands out without being split from stdout
+    auto endsBefore = [](const OutputSegment& segment, size_t offset) { return segment.offset + segment.length <= offset; };
+    auto first = std::lower_bound(block.segments.begin(), block.segments.end(), begin, endsBefore);
+    if (block.styles.empty()) {
+        for (auto it = first; it != block.segments.end() && it->offset < end; ++it) {
+            const auto& segment = *it;
+            size_t from = std::max(begin, segment.offset);
+            size_t to = std::min(end, segment.offset + segment.length);
+            if (from >= to) continue;
+            ImGui::PushStyleColor(ImGuiCol_Text, segment.stream == OutputStream::Stderr ? stderrColor : stdoutColor);
+            ImGui::TextUnformatted(text + (from - begin), text + (to - begin));
+            ImGui::PopStyleColor();
+        }
+        return;
+    }
+    
+    // Colored output: cut at every segment and style boundary, both precomputed at capture
+    auto startsAfter = [](size_t offset, const StyleSpan& span) { return offset < span.offset; };
+    auto style = std::upper_bound(block.styles.begin(), block.styles.end(), begin, startsAfter);
+    auto segment = first;
+    
+    const TextStyle plain;
+    bool lineOpen = false;
+    size_t pos = begin;
+    while (pos < end) {
+        while (style != block.styles.end() && style->offset <= pos) ++style;
+        while (segment != block.segments.end() && segment->offset + segment->length <= pos) ++segment;
+        
+        size_t next = end;
+        if (style != block.styles.end()) next = std::min(next, style->offset);
+        if (segment != block.segments.end()) next = std::min(next, segment->offset + segment->length);
+        
+        bool isStderr = segment != block.segments.end() && segment->stream == OutputStream::Stderr;
+        const TextStyle& current = style == block.styles.begin() ? plain : (style - 1)->style;
+        RenderStyledText(text + (pos - begin), text + (next - begin), current,
+                         isStderr ? stderrColor : stdoutColor, lineOpen);
+        pos = next;
+    }
+}
+
+void UI::RenderStyledText(const char* from, const char* to, const TextStyle& style,
+                          const ImVec4& baseColor, bool& lineOpen) {
+    // Bold lifts the eight basic colors to their bright variants, as terminals do
+    uint32_t fgColor = style.fg;
+    if ((style.flags & StyleBold) && (fgColor & kPaletteColor) && (fgColor & 0xFF) < 8) {
+        fgColor += 8;
+    }
+    ImVec4 fg = Theme::AnsiColor(appState_.theme, fgColor, baseColor);
+    ImVec4 bg = Theme::AnsiColor(appState_.theme, style.bg, appState_.theme.background);
+    bool hasBackground = style.bg != kDefaultColor;
+    if (style.flags & StyleInverse) {
+        std::swap(fg, bg);
+        hasBackground = true;
+    }
+    if (style.flags & StyleDim) {
+        fg.w *= 0.6f;
+    }
+    
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    while (from < to) {
+        const char* newline = static_cast<const char*>(memchr(from, '\n', to - from));
+        const char* lineEnd = newline ? newline : to;
+        
+        if (lineEnd > from) {
+            // Pieces of one line follow each other without a gap
+            if (lineOpen) ImGui::SameLine(0.0f, 0.0f);
+            if (hasBackground) {
+                ImVec2 pos = ImGui::GetCursorScreenPos();
+                ImVec2 size = ImGui::CalcTextSize(from, lineEnd, false, ImGui::GetContentRegionAvail().x);
+                drawList->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y), ImGui::GetColorU32(bg));
+            }
+            ImGui::PushStyleColor(ImGuiCol_Text, fg);
+            ImGui::TextUnformatted(from, lineEnd);
+            ImGui::PopStyleColor();
+            if (style.flags & StyleUnderline) {
+                ImVec2 min = ImGui::GetItemRectMin();
+                ImVec2 max = ImGui::GetItemRectMax();
+                drawList->AddLine(ImVec2(min.x, max.y), max, ImGui::GetColorU32(fg));
+            }
+            lineOpen = true;
+        } else if (!lineOpen) {
+            ImGui::TextUnformatted("");     // An empty line still takes its height
+        }
+        
+        if (newline) {
+            lineOpen = false;
+            from = newline + 1;
+        } else {
+            from = to;
+        }
+    }
+}
+
 void UI::RenderCommandInput() {
     ImGui::Separator();
     ImGui::Spacing();
@@ -793,6 +1259,20 @@ void UI::RenderStatusBar() {
     
     ImGui::Text("%s", statusMessage_.c_str());
     
+    // Background jobs still running or stopped
+    size_t running = 0;
+    size_t stopped = 0;
+    for (const auto& job : terminal_->GetJobs()) {
+        if (job.state == JobState::Running) running++;
+        if (job.state == JobState::Stopped) stopped++;
+    }
+    if (running + stopped > 0) {
+        ImGui::SameLine();
+        ImGui::PushStyleColor(ImGuiCol_Text, appState_.theme.textDim);
+        ImGui::Text("| Jobs: %zu running, %zu stopped", running, stopped);
+        ImGui::PopStyleColor();
+    }
+    
     ImGui::End();
     ImGui::PopStyleColor();
 }
@@ -833,9 +1313,15 @@ void UI::HandleCommandInput() {
 #endif
     }
     
-    // Execute as normal command (not natural language or AI failed)
-    terminal_->ExecuteCommand(input);
-    SetStatusMessage("Executed: " + input);
+    // Execute as normal command (not natural language or AI failed);
+    // Ctrl+Enter starts it as a background job
+    if (ImGui::GetIO().KeyCtrl) {
+        terminal_->ExecuteInBackground(input);
+        SetStatusMessage("Started in background: " + input);
+    } else {
+        terminal_->ExecuteCommand(input);
+        SetStatusMessage("Executed: " + input);
+    }
     commandInputBuffer_[0] = '\0';
 }
 
@@ -858,9 +1344,9 @@ void UI::ProcessAIQuery(const std::string& query) {
     // Async AI call
     aiClient_->TranslateToCommandAsync(query, [this, query](const AIResponse& response) {
         if (response.success && !response.commands.empty()) {
-            for (const auto& cmd : response.commands) {
-                ExecuteAICommand(cmd, query);
-            }
+            // Independent steps run side by side; blocks still appear in order
+            terminal_->ExecuteAICommands(response.commands, query);
+            scrollToBottom_ = true;
             SetStatusMessage("AI generated " + std::to_string(response.commands.size()) + " command(s)");
         } else {
             SetStatusMessage("AI Error: " + response.error);
@@ -891,8 +1377,38 @@ void UI::HandleKeyboardShortcuts() {
     // Ctrl+Shift+C: Clear history
     if (IsKeyComboPressed(ImGuiKey_C, true, true)) {
         terminal_->ClearHistory();
+        loadedMiddle_.clear();
+        changesOnly_.clear();
+        rebuiltOutput_.clear();
         SetStatusMessage("History cleared");
     }
+    // Ctrl+C: Stop the newest running command; in a text box it copies instead
+    else if (IsKeyComboPressed(ImGuiKey_C, true) && !ImGui::GetIO().KeyShift && !ImGui::GetIO().WantTextInput) {
+        auto historyLock = terminal_->LockHistory();
+        const auto& history = terminal_->GetHistory();
+        for (auto it = history.rbegin(); it != history.rend(); ++it) {
+            if (it->status == CommandStatus::Running) {
+                terminal_->CancelCommand(it->id);
+                SetStatusMessage("Stopping: " + it->input);
+                break;
+            }
+        }
+    }
+    
+    // Ctrl+Z: Suspend the newest running foreground command, making it a stopped
+    // job; in a text box it undoes instead
+    if (IsKeyComboPressed(ImGuiKey_Z, true) && !ImGui::GetIO().WantTextInput) {
+        auto historyLock = terminal_->LockHistory();
+        const auto& history = terminal_->GetHistory();
+        for (auto it = history.rbegin(); it != history.rend(); ++it) {
+            if (it->status == CommandStatus::Running && it->jobNumber == 0) {
+                if (terminal_->SuspendCommand(it->id)) {
+                    SetStatusMessage("Suspended: " + it->input);
+                }
+                break;
+            }
+        }
+    }
     
     // Ctrl+K: Focus command input
     if (IsKeyComboPressed(ImGuiKey_K, true)) {
@@ -995,6 +1511,27 @@ void UI::RenderSettingsWindow() {
                 ImGui::Checkbox("Confirm before exit", &confirmExit);
                 ImGui::Checkbox("Save command history", &confirmExit);
                 
+                // One shell kept alive across commands, so export/alias/cd persist
+                bool sessionMode = terminal_->IsSessionMode();
+                if (ImGui::Checkbox("Persistent shell session", &sessionMode)) {
+                    if (terminal_->SetSessionMode(sessionMode)) {
+                        SetStatusMessage(sessionMode ? "Shell session started" : "Shell session closed");
+                    } else {
+                        SetStatusMessage("Failed to start shell session");
+                    }
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Keep one shell running on a pseudo-terminal instead of starting a new one per command");
+                }
+                
+                int parallelCommands = terminal_->GetMaxParallelCommands();
+                if (ImGui::SliderInt("Parallel AI commands", &parallelCommands, 1, 16)) {
+                    terminal_->SetMaxParallelCommands(parallelCommands);
+                }
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("How many independent commands from one AI answer may run at once");
+                }
+                
                 ImGui::EndTabItem();
             }
             
@@ -1179,6 +1716,9 @@ void UI::RenderSettingsWindow() {
                 ImGui::BulletText("Ctrl+Shift+C - Clear history");
                 ImGui::BulletText("Ctrl+K - Focus command input");
                 ImGui::BulletText("Ctrl+, - Open settings");
+                ImGui::BulletText("Ctrl+C - Stop the newest command (outside a text box)");
+                ImGui::BulletText("Ctrl+Z - Suspend the newest command (outside a text box)");
+                ImGui::BulletText("Ctrl+Enter - Run as a background job");
                 
                 ImGui::EndTabItem();
             }
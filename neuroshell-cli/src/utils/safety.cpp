@@ -1,6 +1,7 @@
 #include "utils/safety.h"
 #include <algorithm>
 #include <regex>
+#include <sstream>
 
 namespace neuroshell {
 namespace utils {
@@ -59,6 +60,48 @@ bool SafetyChecker::hasInjectionRisk(const std::string& input) const {
     return matchesAnyPattern(input, injection_patterns_);
 }
 
+bool SafetyChecker::isCacheable(const std::string& command) const {
+    std::string cmd_name = extractCommandName(command);
+    if (cacheable_commands_.find(cmd_name) == cacheable_commands_.end()) {
+        return false;
+    }
+    
+    // Recursive listings read more than can be cheaply checked for changes
+    std::istringstream words(command);
+    std::string word;
+    while (words >> word) {
+        bool lsRecursive = cmd_name == "ls" && word.size() > 1 && word[0] == '-' && word[1] != '-' &&
+                           word.find('R') != std::string::npos;
+        if (lsRecursive || word == "--recursive" || word == "/s" || word == "/S") {
+            return false;
+        }
+    }
+    return isSafe(command);
+}
+
+bool SafetyChecker::isSpeculatable(const std::string& command) const {
+    if (isCacheable(command)) {
+        return true;
+    }
+    
+    // Read-only git queries; git options before the subcommand (-c, -C) could run anything
+    std::istringstream words(command);
+    std::string name, subcommand, word;
+    words >> name >> subcommand;
+    if (name != "git" || speculatable_git_commands_.find(subcommand) == speculatable_git_commands_.end()) {
+        return false;
+    }
+    while (words >> word) {
+        // git branch <name> creates a branch; only its listing flags are reads
+        bool branchName = subcommand == "branch" && word[0] != '-';
+        if (branchName || word.compare(0, 8, "--output") == 0 || word == "-d" || word == "-D" ||
+            word == "-m" || word == "-M" || word == "-c" || word == "-C") {
+            return false;
+        }
+    }
+    return isSafe(command);
+}
+
 void SafetyChecker::initializeWhitelist() {
     // Safe read-only commands
     whitelisted_commands_.insert("ls");
@@ -85,6 +128,26 @@ void SafetyChecker::initializeWhitelist() {
     whitelisted_commands_.insert("hostname");
     whitelisted_commands_.insert("uname");
     whitelisted_commands_.insert("systeminfo");
+    
+    // Read-only commands that give the same output until the files they read change.
+    // Not ps, date, ping and the like, and nothing recursive (find, ls -R walk too much to validate).
+    cacheable_commands_.insert("ls");
+    cacheable_commands_.insert("dir");
+    cacheable_commands_.insert("pwd");
+    cacheable_commands_.insert("cat");
+    cacheable_commands_.insert("type");
+    cacheable_commands_.insert("head");
+    cacheable_commands_.insert("whoami");
+    cacheable_commands_.insert("hostname");
+    cacheable_commands_.insert("uname");
+    cacheable_commands_.insert("systeminfo");
+    
+    // git subcommands that only read the repository. Speculative runs add
+    // --no-optional-locks so status doesn't rewrite the index, and give log
+    // --no-ext-diff --no-textconv so no configured driver runs.
+    speculatable_git_commands_.insert("status");
+    speculatable_git_commands_.insert("log");
+    speculatable_git_commands_.insert("branch");
 }
 
 void SafetyChecker::initializeBlacklist() {
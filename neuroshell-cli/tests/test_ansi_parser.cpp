@@ -0,0 +1,158 @@
+#include "../include/common/ansi_parser.h"
+#include "../include/colors.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace NeuroShell;
+
+struct Parsed {
+    std::string text;
+    std::vector<StyleRun> runs;
+};
+
+Parsed Parse(const std::string& input) {
+    AnsiParser parser;
+    Parsed parsed;
+    parser.Feed(input.data(), input.size(), parsed.text, parsed.runs);
+    return parsed;
+}
+
+void test_plain_text() {
+    Parsed parsed = Parse("hello\nworld\n");
+
+    assert(parsed.text == "hello\nworld\n");
+    assert(parsed.runs.size() == 1);
+    assert(parsed.runs[0].length == 12);
+    assert(parsed.runs[0].style.IsDefault());
+
+    std::cout << "✓ Plain text test passed" << std::endl;
+}
+
+void test_basic_colors() {
+    Parsed parsed = Parse(Colors::RED + "error" + Colors::RESET + ": " + Colors::BOLD_GREEN + "ok" + Colors::RESET);
+
+    assert(parsed.text == "error: ok");
+    assert(parsed.runs.size() == 3);
+    assert(parsed.runs[0].length == 5);
+    assert(parsed.runs[0].style.fg == PaletteColor(1));
+    assert(parsed.runs[1].length == 2);
+    assert(parsed.runs[1].style.IsDefault());
+    assert(parsed.runs[2].length == 2);
+    assert(parsed.runs[2].style.fg == PaletteColor(2));
+    assert(parsed.runs[2].style.flags == StyleBold);
+
+    std::cout << "✓ Basic colors test passed" << std::endl;
+}
+
+void test_extended_colors() {
+    Parsed parsed = Parse("\x1b[38;5;208ma\x1b[48;2;10;20;30mb\x1b[38:2::1:2:3mc\x1b[39;49md\x1b[95;104me");
+
+    assert(parsed.text == "abcde");
+    assert(parsed.runs.size() == 5);
+    assert(parsed.runs[0].style.fg == PaletteColor(208));
+    assert(parsed.runs[1].style.fg == PaletteColor(208));
+    assert(parsed.runs[1].style.bg == RgbColor(10, 20, 30));
+    assert(parsed.runs[2].style.fg == RgbColor(1, 2, 3));
+    assert(parsed.runs[3].style.IsDefault());
+    assert(parsed.runs[4].style.fg == PaletteColor(13));
+    assert(parsed.runs[4].style.bg == PaletteColor(12));
+
+    std::cout << "✓ Extended colors test passed" << std::endl;
+}
+
+void test_split_sequences() {
+    // Every chunking of the input gives the same text and styles
+    std::string input = "a\x1b[1;31mred\x1b]0;title\x07" "b\x1b[0mc\x1b[2Kd";
+    Parsed whole = Parse(input);
+    assert(whole.text == "aredbcd");
+
+    for (size_t chunk = 1; chunk <= input.size(); ++chunk) {
+        AnsiParser parser;
+        Parsed parsed;
+        for (size_t i = 0; i < input.size(); i += chunk) {
+            parser.Feed(input.data() + i, std::min(chunk, input.size() - i), parsed.text, parsed.runs);
+        }
+        assert(parsed.text == whole.text);
+        assert(parsed.runs.size() == whole.runs.size());
+        for (size_t i = 0; i < parsed.runs.size(); ++i) {
+            assert(parsed.runs[i].length == whole.runs[i].length);
+            assert(parsed.runs[i].style == whole.runs[i].style);
+        }
+    }
+
+    std::cout << "✓ Split sequences test passed" << std::endl;
+}
+
+void test_style_carries_across_feeds() {
+    AnsiParser parser;
+    Parsed first;
+    parser.Feed("\x1b[4mx\x1b[", 7, first.text, first.runs);
+    assert(first.text == "x");
+    assert(parser.CurrentStyle().flags == StyleUnderline);
+
+    Parsed second;
+    parser.Feed("24my", 4, second.text, second.runs);
+    assert(second.text == "y");
+    assert(second.runs.size() == 1);
+    assert(second.runs[0].style.IsDefault());
+
+    parser.Feed("\x1b[7m", 4, second.text, second.runs);
+    parser.Reset();
+    assert(parser.CurrentStyle().IsDefault());
+
+    std::cout << "✓ Style across feeds test passed" << std::endl;
+}
+
+void test_other_sequences_stripped() {
+    Parsed parsed = Parse("\x1b[?25l\x1b(Bone\x1b[H\x1b]8;;http://x\x1b\\two\x1b]8;;\x1b\\\x07\x1b[>0m");
+
+    assert(parsed.text == "onetwo");
+    assert(parsed.runs.size() == 1);
+    assert(parsed.runs[0].style.IsDefault());
+
+    std::cout << "✓ Other sequences test passed" << std::endl;
+}
+
+void test_drop_style_spans() {
+    TextStyle red;
+    red.fg = PaletteColor(1);
+    TextStyle blue;
+    blue.fg = PaletteColor(4);
+
+    std::vector<StyleSpan> spans = { { 0, red }, { 10, TextStyle() }, { 20, blue }, { 30, TextStyle() }, { 50, red } };
+
+    // The span in effect at the cut moves to its end
+    DropStyleSpans(spans, 5, 25, 100);
+    assert(spans.size() == 4);
+    assert(spans[0].offset == 0 && spans[0].style == red);
+    assert(spans[1].offset == 25 && spans[1].style == blue);
+    assert(spans[2].offset == 30);
+    assert(spans[3].offset == 50);
+
+    // Past the cut, only the newest keep spans stay
+    DropStyleSpans(spans, 5, 25, 1);
+    assert(spans.size() == 3);
+    assert(spans[0].style == red);
+    assert(spans[1].offset == 30 && spans[1].style.IsDefault());
+    assert(spans[2].offset == 50 && spans[2].style == red);
+
+    std::cout << "✓ Drop style spans test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running ANSI Parser Tests ===\n" << std::endl;
+
+    test_plain_text();
+    test_basic_colors();
+    test_extended_colors();
+    test_split_sequences();
+    test_style_carries_across_feeds();
+    test_other_sequences_stripped();
+    test_drop_style_spans();
+
+    std::cout << "\n✅ All ANSI parser tests passed!\n" << std::endl;
+    return 0;
+}
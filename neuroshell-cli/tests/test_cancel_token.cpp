@@ -0,0 +1,132 @@
+#include "../include/terminal/cancel_token.h"
+#include <iostream>
+#include <cassert>
+#include <csignal>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+using namespace NeuroShell;
+
+void test_idle_token() {
+    CancelToken token;
+    std::vector<int> sent;
+
+    assert(!token.IsCancelled());
+    assert(token.Advance([&sent](int signal) { sent.push_back(signal); }) == -1);
+    assert(sent.empty());
+
+    std::cout << "✓ Idle token test passed" << std::endl;
+}
+
+void test_escalation() {
+    CancelToken token;
+    token.SetStopSchedule(20, 20);
+    std::vector<int> sent;
+    auto record = [&sent](int signal) { sent.push_back(signal); };
+
+    token.Cancel();
+    assert(token.IsCancelled());
+    assert(!token.TimedOut());
+
+    // First call interrupts; nothing more until the grace period is over
+    assert(token.Advance(record) > 0);
+    assert(token.Advance(record) > 0);
+    assert(sent.size() == 1 && sent[0] == SIGINT);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(token.Advance(record) > 0);
+    assert(sent.size() == 2 && sent[1] == SIGTERM);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(token.Advance(record) == -1);
+    assert(sent.size() == 3);
+#ifndef _WIN32
+    assert(sent[2] == SIGKILL);
+#endif
+
+    // Nothing left to send
+    assert(token.Advance(record) == -1);
+    assert(sent.size() == 3);
+
+    std::cout << "✓ Signal escalation test passed" << std::endl;
+}
+
+void test_timeout() {
+    CancelToken token;
+    token.SetTimeout(0.02);
+    std::vector<int> sent;
+    auto record = [&sent](int signal) { sent.push_back(signal); };
+
+    int wait = token.Advance(record);
+    assert(wait > 0 && wait <= 20);
+    assert(sent.empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(token.IsCancelled());
+    token.Advance(record);
+    assert(token.TimedOut());
+    assert(sent.size() == 1 && sent[0] == SIGINT);
+
+    std::cout << "✓ Timeout test passed" << std::endl;
+}
+
+void test_wake_fd() {
+#ifndef _WIN32
+    CancelToken token;
+    assert(token.GetWakeFd() >= 0);
+#endif
+    std::cout << "✓ Wake fd test passed" << std::endl;
+}
+
+void test_signal_group() {
+    CancelToken token;
+    assert(!token.Signal(SIGTERM));
+
+#ifndef _WIN32
+    pid_t child = fork();
+    if (child == 0) {
+        setpgid(0, 0);
+        pause();
+        _exit(0);
+    }
+    setpgid(child, child);
+    token.Attach(child);
+
+    // Stop and continue the group, as job control does
+    int status = 0;
+    assert(token.Signal(SIGSTOP));
+    assert(waitpid(child, &status, WUNTRACED) == child && WIFSTOPPED(status));
+    assert(token.Signal(SIGCONT));
+    assert(waitpid(child, &status, WCONTINUED) == child && WIFCONTINUED(status));
+
+    assert(token.Signal(SIGKILL));
+    assert(waitpid(child, &status, 0) == child && WIFSIGNALED(status));
+    token.Detach();
+    assert(!token.Signal(SIGTERM));
+#endif
+
+    std::cout << "✓ Signal group test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Cancel Token Tests ===\n" << std::endl;
+
+    try {
+        test_idle_token();
+        test_escalation();
+        test_timeout();
+        test_wake_fd();
+        test_signal_group();
+
+        std::cout << "\n✅ All cancel token tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,130 @@
+#include "../include/terminal/command_cache.h"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include <cstdlib>
+
+using namespace NeuroShell;
+namespace fs = std::filesystem;
+
+// Scratch directory removed at the end of each test
+struct TempDir {
+    fs::path path;
+    TempDir() : path(fs::temp_directory_path() / ("neuroshell_cache_" + std::to_string(std::rand()))) {
+        fs::create_directories(path);
+    }
+    ~TempDir() { std::error_code ec; fs::remove_all(path, ec); }
+    void Write(const std::string& name, const std::string& text) {
+        std::ofstream(path / name) << text;
+    }
+};
+
+CommandBlock MakeBlock(const std::string& output) {
+    CommandBlock block;
+    block.AppendOutput(OutputStream::Stdout, output.data(), output.size());
+    block.status = CommandStatus::Success;
+    return block;
+}
+
+void test_classification() {
+    TempDir dir;
+    CommandCache cache;
+
+    assert(cache.Prepare("ls -la", dir.path.string()).cacheable);
+    assert(cache.Prepare("pwd", dir.path.string()).cacheable);
+    assert(!cache.Prepare("ls -laR", dir.path.string()).cacheable);
+    assert(!cache.Prepare("rm -f x", dir.path.string()).cacheable);
+    assert(!cache.Prepare("date", dir.path.string()).cacheable);
+    assert(!cache.Prepare("ls | wc -l", dir.path.string()).cacheable);
+
+    // Spacing and quoting don't matter
+    assert(cache.Prepare("ls   -la", dir.path.string()).key == cache.Prepare("ls '-la'", dir.path.string()).key);
+
+    std::cout << "✓ Classification test passed" << std::endl;
+}
+
+void test_hit_and_invalidation() {
+    TempDir dir;
+    dir.Write("a.txt", "one");
+    CommandCache cache;
+    CachedResult result;
+
+    CommandCache::Ticket ticket = cache.Prepare("ls", dir.path.string());
+    assert(!cache.Lookup(ticket, result));
+    cache.Store(ticket, MakeBlock("a.txt\n"));
+
+    assert(cache.Lookup(cache.Prepare("ls", dir.path.string()), result));
+    assert(result.output == "a.txt\n");
+
+    // Growing a file in the directory changes the fingerprint
+    dir.Write("a.txt", "one two");
+    assert(!cache.Lookup(cache.Prepare("ls", dir.path.string()), result));
+
+    CommandCache::Stats stats = cache.GetStats();
+    assert(stats.hits == 1);
+    assert(stats.misses == 2);
+    assert(stats.invalidations == 1);
+    assert(stats.entries == 0);
+
+    std::cout << "✓ Hit and invalidation test passed" << std::endl;
+}
+
+void test_path_arguments() {
+    TempDir dir;
+    TempDir other;
+    other.Write("notes.txt", "hello");
+    std::string file = (other.path / "notes.txt").string();
+    CommandCache cache;
+    CachedResult result;
+
+    CommandCache::Ticket ticket = cache.Prepare("cat " + file, dir.path.string());
+    cache.Store(ticket, MakeBlock("hello"));
+    assert(cache.Lookup(cache.Prepare("cat " + file, dir.path.string()), result));
+
+    other.Write("notes.txt", "hello again");
+    assert(!cache.Lookup(cache.Prepare("cat " + file, dir.path.string()), result));
+
+    std::cout << "✓ Path argument test passed" << std::endl;
+}
+
+void test_capacity_and_failures() {
+    TempDir dir;
+    CommandCache cache;
+    cache.SetCapacity(2);
+    CachedResult result;
+
+    cache.Store(cache.Prepare("ls", dir.path.string()), MakeBlock("1"));
+    cache.Store(cache.Prepare("ls -l", dir.path.string()), MakeBlock("2"));
+    cache.Store(cache.Prepare("ls -la", dir.path.string()), MakeBlock("3"));
+    assert(cache.GetStats().entries == 2);
+    assert(!cache.Lookup(cache.Prepare("ls", dir.path.string()), result));
+
+    // Failed runs are never cached
+    CommandBlock failed = MakeBlock("boom");
+    failed.status = CommandStatus::Failed;
+    cache.Store(cache.Prepare("cat missing", dir.path.string()), failed);
+    assert(!cache.Lookup(cache.Prepare("cat missing", dir.path.string()), result));
+
+    cache.SetEnabled(false);
+    assert(!cache.Prepare("ls -l", dir.path.string()).cacheable);
+
+    std::cout << "✓ Capacity and failure test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Command Cache Tests ===\n" << std::endl;
+
+    try {
+        test_classification();
+        test_hit_and_invalidation();
+        test_path_arguments();
+        test_capacity_and_failures();
+
+        std::cout << "\n✅ All command cache tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,60 @@
+#include "../include/terminal/command_cgroup.h"
+#include <iostream>
+#include <cassert>
+
+using namespace NeuroShell;
+
+void test_limits() {
+    ResourceLimits limits;
+    assert(!limits.Any());
+    limits.pidsMax = 64;
+    assert(limits.Any());
+
+    std::cout << "✓ Resource limits test passed" << std::endl;
+}
+
+void test_nice_for_weight() {
+    // An even share (or more) needs no nice; less maps to ~1.25x per step
+    assert(NiceForWeight(0) == 0);
+    assert(NiceForWeight(100) == 0);
+    assert(NiceForWeight(10000) == 0);
+    assert(NiceForWeight(80) == 1);
+    assert(NiceForWeight(50) == 3);
+    assert(NiceForWeight(20) == 7);
+    assert(NiceForWeight(1) == 19);
+
+    std::cout << "✓ Nice for weight test passed" << std::endl;
+}
+
+void test_create() {
+    ResourceLimits limits;
+    limits.memoryMaxBytes = 256ull * 1024 * 1024;
+    auto cgroup = CommandCgroup::Create(limits);
+
+    // Only possible with a delegated cgroup v2 hierarchy; otherwise callers use setrlimit()
+    assert((cgroup != nullptr) == CommandCgroup::IsAvailable());
+    if (cgroup) {
+        assert(cgroup->ProcsFd() >= 0);
+        ResourceUsage usage;
+        cgroup->ReadUsage(usage);
+        assert(usage.CpuSeconds() == 0.0);
+    }
+
+    std::cout << "✓ Create test passed (cgroups " << (cgroup ? "available" : "unavailable") << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Command Cgroup Tests ===\n" << std::endl;
+
+    try {
+        test_limits();
+        test_nice_for_weight();
+        test_create();
+
+        std::cout << "\n✅ All command cgroup tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
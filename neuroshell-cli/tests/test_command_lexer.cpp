@@ -0,0 +1,124 @@
+#include "../include/terminal/command_lexer.h"
+#include <iostream>
+#include <cassert>
+
+using namespace NeuroShell;
+
+void test_plain_words() {
+    std::vector<std::string> argv;
+
+    assert(CommandLexer::SplitSimple("ls -la", argv));
+    assert(argv.size() == 2 && argv[0] == "ls" && argv[1] == "-la");
+
+    assert(CommandLexer::SplitSimple("  git   status  ", argv));
+    assert(argv.size() == 2 && argv[1] == "status");
+
+    assert(CommandLexer::SplitSimple("ls --color=auto", argv));
+    assert(argv[1] == "--color=auto");
+
+    std::cout << "✓ Plain words test passed" << std::endl;
+}
+
+void test_quoting() {
+    std::vector<std::string> argv;
+
+    assert(CommandLexer::SplitSimple("git commit -m 'fix: a | b'", argv));
+    assert(argv.size() == 4 && argv[3] == "fix: a | b");
+
+    assert(CommandLexer::SplitSimple("echo \"say \\\"hi\\\"\" it\\'s", argv));
+    assert(argv.size() == 3 && argv[1] == "say \"hi\"" && argv[2] == "it's");
+
+    assert(CommandLexer::SplitSimple("printf '' x", argv));
+    assert(argv.size() == 3 && argv[1].empty());
+
+    assert(CommandLexer::SplitSimple("echo a\\ b", argv));
+    assert(argv.size() == 2 && argv[1] == "a b");
+
+    std::cout << "✓ Quoting test passed" << std::endl;
+}
+
+void test_needs_shell() {
+    std::vector<std::string> argv;
+
+    assert(!CommandLexer::SplitSimple("ls | wc -l", argv));
+    assert(!CommandLexer::SplitSimple("make && make install", argv));
+    assert(!CommandLexer::SplitSimple("echo hi > out.txt", argv));
+    assert(!CommandLexer::SplitSimple("ls *.cpp", argv));
+    assert(!CommandLexer::SplitSimple("echo $HOME", argv));
+    assert(!CommandLexer::SplitSimple("echo \"$HOME\"", argv));
+    assert(!CommandLexer::SplitSimple("echo `date`", argv));
+    assert(!CommandLexer::SplitSimple("ls ~/src", argv));
+    assert(!CommandLexer::SplitSimple("FOO=1 make", argv));
+    assert(!CommandLexer::SplitSimple("echo {a,b}", argv));
+    assert(!CommandLexer::SplitSimple("sleep 5 &", argv));
+    assert(!CommandLexer::SplitSimple("ls # comment", argv));
+    assert(!CommandLexer::SplitSimple("echo 'unterminated", argv));
+    assert(!CommandLexer::SplitSimple("", argv));
+
+    std::cout << "✓ Needs-shell test passed" << std::endl;
+}
+
+void test_shell_words() {
+    std::vector<std::string> argv;
+
+    assert(!CommandLexer::SplitSimple("cd /tmp", argv));
+    assert(!CommandLexer::SplitSimple("export PATH", argv));
+    assert(!CommandLexer::SplitSimple("source env.sh", argv));
+    assert(CommandLexer::SplitSimple("echo cd", argv));
+
+    std::cout << "✓ Shell words test passed" << std::endl;
+}
+
+void test_pipelines() {
+    std::vector<std::string> stages;
+
+    assert(CommandLexer::SplitPipeline("ps aux | grep 'a|b' | head -5", stages));
+    assert(stages.size() == 3);
+    assert(stages[0] == "ps aux");
+    assert(stages[1] == "grep 'a|b'");
+    assert(stages[2] == "head -5");
+
+    assert(!CommandLexer::SplitPipeline("ls", stages));
+    assert(!CommandLexer::SplitPipeline("false || true", stages));
+    assert(!CommandLexer::SplitPipeline("make |& less", stages));
+    assert(!CommandLexer::SplitPipeline("ls | ", stages));
+    assert(!CommandLexer::SplitPipeline("echo \"a | b", stages));
+    // Every stage has to be simple
+    assert(!CommandLexer::SplitPipeline("cat *.txt | wc -l", stages));
+    assert(!CommandLexer::SplitPipeline("ls | cd /tmp", stages));
+
+    std::cout << "✓ Pipelines test passed" << std::endl;
+}
+
+void test_path_cache() {
+    PathCache cache;
+
+    assert(cache.Resolve("./build.sh") == "./build.sh");
+    assert(cache.Resolve("no-such-program-neuroshell").empty());
+#ifndef _WIN32
+    std::string sh = cache.Resolve("sh");
+    assert(!sh.empty() && sh[0] == '/');
+    assert(cache.Resolve("sh") == sh);
+#endif
+
+    std::cout << "✓ Path cache test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Command Lexer Tests ===\n" << std::endl;
+
+    try {
+        test_plain_words();
+        test_quoting();
+        test_needs_shell();
+        test_shell_words();
+        test_pipelines();
+        test_path_cache();
+
+        std::cout << "\n✅ All command lexer tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
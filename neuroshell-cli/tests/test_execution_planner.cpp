@@ -0,0 +1,104 @@
+#include "../include/terminal/execution_planner.h"
+#include <iostream>
+#include <cassert>
+
+using namespace NeuroShell;
+
+void test_read_only_independent() {
+    auto plan = ExecutionPlanner::Plan({ "ls -la", "git status", "df -h", "cat README.md | wc -l" });
+
+    assert(plan.size() == 4);
+    for (const auto& step : plan) {
+        assert(step.readOnly);
+        assert(!step.barrier);
+        assert(step.dependsOn.empty());
+    }
+
+    std::cout << "✓ Read-only independence test passed" << std::endl;
+}
+
+void test_cd_is_barrier() {
+    auto plan = ExecutionPlanner::Plan({ "ls", "cd src", "ls", "du -sh" });
+
+    assert(plan[1].barrier);
+    assert(plan[1].dependsOn == std::vector<size_t>{ 0 });
+    assert(plan[2].dependsOn == std::vector<size_t>{ 1 });
+    assert(plan[3].dependsOn == std::vector<size_t>{ 1 });     // Not the ls beside it
+
+    std::cout << "✓ cd barrier test passed" << std::endl;
+}
+
+void test_write_then_read() {
+    auto plan = ExecutionPlanner::Plan({ "mkdir build", "ls build", "echo hi > notes.txt", "cat notes.txt", "whoami" });
+
+    assert(!plan[0].readOnly);
+    assert(plan[1].dependsOn == std::vector<size_t>{ 0 });
+    assert(!plan[2].readOnly);
+    assert(plan[3].dependsOn == std::vector<size_t>{ 2 });
+    assert(plan[4].dependsOn.empty());
+
+    std::cout << "✓ Write-then-read test passed" << std::endl;
+}
+
+void test_read_then_write() {
+    auto plan = ExecutionPlanner::Plan({ "cat log.txt", "rm log.txt" });
+
+    assert(plan[1].dependsOn == std::vector<size_t>{ 0 });
+
+    std::cout << "✓ Read-then-write test passed" << std::endl;
+}
+
+void test_unknown_is_barrier() {
+    auto plan = ExecutionPlanner::Plan({ "make", "ls", "echo $(date)", "find . -delete", "git commit -m x", "git log" });
+
+    assert(plan[0].barrier);
+    assert(!plan[1].barrier);
+    assert(plan[2].barrier);
+    assert(plan[3].barrier);
+    assert(plan[4].barrier);
+    assert(plan[5].readOnly);
+
+    std::cout << "✓ Unknown effects test passed" << std::endl;
+}
+
+void test_redirects() {
+    PlannedCommand step = ExecutionPlanner::Analyze("grep -r TODO src 2>/dev/null >&2");
+    assert(step.readOnly);
+
+    step = ExecutionPlanner::Analyze("ls 2> errors.log");
+    assert(!step.readOnly);
+    assert(step.writes.size() == 1 && step.writes[0] == "errors.log");
+
+    std::cout << "✓ Redirect test passed" << std::endl;
+}
+
+void test_path_overlap() {
+    assert(ExecutionPlanner::PathsOverlap("build", "build/out.o"));
+    assert(ExecutionPlanner::PathsOverlap("./src/", "src"));
+    assert(ExecutionPlanner::PathsOverlap(".", "src"));
+    assert(ExecutionPlanner::PathsOverlap("/tmp/x", "x"));
+    assert(!ExecutionPlanner::PathsOverlap("src", "srcs"));
+    assert(!ExecutionPlanner::PathsOverlap("/var/log", "/tmp"));
+
+    std::cout << "✓ Path overlap test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Execution Planner Tests ===\n" << std::endl;
+
+    try {
+        test_read_only_independent();
+        test_cd_is_barrier();
+        test_write_then_read();
+        test_read_then_write();
+        test_unknown_is_barrier();
+        test_redirects();
+        test_path_overlap();
+
+        std::cout << "\n✅ All execution planner tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,144 @@
+#include "../include/terminal/file_watcher.h"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+using namespace NeuroShell;
+namespace fs = std::filesystem;
+
+// Scratch directory removed at the end of each test
+struct TempDir {
+    fs::path path;
+    TempDir() : path(fs::temp_directory_path() / ("neuroshell_watch_" + std::to_string(std::rand()))) {
+        fs::create_directories(path);
+    }
+    ~TempDir() { std::error_code ec; fs::remove_all(path, ec); }
+    void Write(const std::string& name, const std::string& text) {
+        std::ofstream(path / name) << text;
+    }
+};
+
+void Sleep(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Wait up to a second for count to reach expected
+bool WaitFor(const std::atomic<int>& count, int expected) {
+    for (int i = 0; i < 100 && count.load() < expected; ++i) Sleep(10);
+    return count.load() >= expected;
+}
+
+void test_burst_makes_one_call() {
+    TempDir dir;
+    FileWatcher watcher;
+    std::atomic<int> calls(0);
+    uint64_t id = watcher.Add({ dir.path.string() }, [&calls]() { calls++; }, 50, 0);
+    assert(id != 0);
+
+    for (int i = 0; i < 20; ++i) {
+        dir.Write("file" + std::to_string(i % 3), "content " + std::to_string(i));
+    }
+    assert(WaitFor(calls, 1));
+    Sleep(150);
+    assert(calls.load() == 1);
+
+    std::cout << "✓ Burst makes one call test passed" << std::endl;
+}
+
+void test_suspended_until_resume() {
+    TempDir dir;
+    FileWatcher watcher;
+    std::atomic<int> calls(0);
+    uint64_t id = watcher.Add({ dir.path.string() }, [&calls]() { calls++; }, 20, 0);
+
+    dir.Write("a", "1");
+    assert(WaitFor(calls, 1));
+
+    // Changes made by the "rerun" itself are dropped, queued ones included
+    dir.Write("a", "2");
+    Sleep(100);
+    dir.Write("b", "3");
+    watcher.Resume(id);
+    Sleep(150);
+    assert(calls.load() == 1);
+
+    // After Resume() the next change counts again
+    dir.Write("a", "4");
+    assert(WaitFor(calls, 2));
+
+    std::cout << "✓ Suspended until resume test passed" << std::endl;
+}
+
+void test_min_interval() {
+    TempDir dir;
+    FileWatcher watcher;
+    std::atomic<int> calls(0);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point second;
+    uint64_t id = 0;
+    id = watcher.Add({ dir.path.string() }, [&]() {
+        if (++calls == 2) second = std::chrono::steady_clock::now();
+    }, 10, 300);
+
+    dir.Write("a", "1");
+    assert(WaitFor(calls, 1));
+    watcher.Resume(id);
+    Sleep(30);
+    dir.Write("a", "2");
+    assert(WaitFor(calls, 2));
+    assert(second - start >= std::chrono::milliseconds(300));
+
+    std::cout << "✓ Min interval test passed" << std::endl;
+}
+
+void test_subdirectories_and_remove() {
+    TempDir dir;
+    fs::create_directories(dir.path / "src" / "deep");
+    fs::create_directories(dir.path / ".git");
+    FileWatcher watcher;
+    std::atomic<int> calls(0);
+    uint64_t id = watcher.Add({ dir.path.string() }, [&calls]() { calls++; }, 20, 0);
+
+    // Hidden directories are not watched
+    dir.Write(".git/index", "x");
+    Sleep(100);
+    assert(calls.load() == 0);
+
+    dir.Write("src/deep/file.cpp", "int x;");
+    assert(WaitFor(calls, 1));
+    watcher.Resume(id);
+    Sleep(50);
+
+    watcher.Remove(id);
+    assert(watcher.WatchCount() == 0);
+    dir.Write("src/deep/file.cpp", "int y;");
+    Sleep(100);
+    assert(calls.load() == 1);
+
+    // Nothing to watch
+    assert(watcher.Add({ (dir.path / "missing").string() }, []() {}, 20, 0) == 0);
+
+    std::cout << "✓ Subdirectories and remove test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running File Watcher Tests ===\n" << std::endl;
+
+    if (!FileWatcher::IsSupported()) {
+        std::cout << "File watching not supported here, skipping" << std::endl;
+        return 0;
+    }
+
+    test_burst_makes_one_call();
+    test_suspended_until_resume();
+    test_min_interval();
+    test_subdirectories_and_remove();
+
+    std::cout << "\n✅ All file watcher tests passed!\n" << std::endl;
+    return 0;
+}
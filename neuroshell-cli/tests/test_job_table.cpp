@@ -0,0 +1,120 @@
+#include "../include/terminal/job_table.h"
+#include <iostream>
+#include <cassert>
+#include <csignal>
+
+using namespace NeuroShell;
+
+void test_split_background() {
+    std::string stripped;
+    assert(JobTable::SplitBackground("make -j8 &", stripped));
+    assert(stripped == "make -j8");
+    assert(JobTable::SplitBackground("sleep 10&  ", stripped));
+    assert(stripped == "sleep 10");
+    assert(JobTable::SplitBackground("make 2>&1 &", stripped));
+    assert(stripped == "make 2>&1");
+
+    // Other operators, quoted and escaped ampersands
+    assert(!JobTable::SplitBackground("make && make install", stripped));
+    assert(!JobTable::SplitBackground("true &&", stripped));
+    assert(!JobTable::SplitBackground("echo 'a &'", stripped));
+    assert(!JobTable::SplitBackground("echo \"a &", stripped));
+    assert(!JobTable::SplitBackground("echo a \\&", stripped));
+    assert(!JobTable::SplitBackground("make >&", stripped));
+    assert(!JobTable::SplitBackground("&", stripped));
+    assert(!JobTable::SplitBackground("ls", stripped));
+
+    std::cout << "✓ Split background test passed" << std::endl;
+}
+
+void test_numbers_and_current() {
+    JobTable jobs;
+    assert(jobs.Resolve("%%") == nullptr);
+
+    assert(jobs.Add(10, "make") == 1);
+    assert(jobs.Add(11, "sleep 100") == 2);
+    assert(jobs.Add(12, "tail -f log") == 3);
+    assert(jobs.Marker(3) == '+');
+    assert(jobs.Marker(2) == '-');
+    assert(jobs.Marker(1) == ' ');
+
+    // Stopping a job makes it current
+    jobs.SetState(1, JobState::Stopped);
+    assert(jobs.Resolve("")->number == 1);
+    assert(jobs.Resolve("%-")->number == 3);
+
+    // Numbers go one past the highest in use
+    jobs.Remove(3);
+    assert(jobs.Add(13, "top") == 3);
+    jobs.Remove(2);
+    jobs.Remove(3);
+    assert(jobs.Add(14, "du") == 2);
+    assert(jobs.FindByBlock(14)->number == 2);
+
+    std::cout << "✓ Numbers and current job test passed" << std::endl;
+}
+
+void test_resolve() {
+    JobTable jobs;
+    jobs.Add(1, "make all");
+    jobs.Add(2, "sleep 100");
+    jobs.Add(3, "sleep 200");
+
+    assert(jobs.Resolve("%1")->blockId == 1);
+    assert(jobs.Resolve("2")->blockId == 2);
+    assert(jobs.Resolve("%+")->blockId == 3);
+    assert(jobs.Resolve("%make")->blockId == 1);
+    assert(jobs.Resolve("%?200")->blockId == 3);
+    assert(jobs.Resolve("%9") == nullptr);
+    assert(jobs.Resolve("make") == nullptr);
+    // Ambiguous
+    assert(jobs.Resolve("%sleep") == nullptr);
+
+    std::cout << "✓ Resolve test passed" << std::endl;
+}
+
+void test_reap() {
+    JobTable jobs;
+    jobs.Add(1, "make");
+    jobs.Add(2, "sleep 100");
+    jobs.SetState(2, JobState::Stopped);
+    jobs.Finish(1, 2);
+
+    std::string listing = jobs.Reap();
+    assert(listing.find("[1]   Exit 2") != std::string::npos);
+    assert(listing.find("[2]+  Stopped") != std::string::npos);
+    assert(listing.find("sleep 100\n") != std::string::npos);
+
+    // Finished jobs are reported once
+    assert(jobs.Jobs().size() == 1);
+    assert(jobs.Reap().find("make") == std::string::npos);
+
+    std::cout << "✓ Reap test passed" << std::endl;
+}
+
+void test_signal_numbers() {
+    assert(JobTable::SignalNumber("9") == 9);
+    assert(JobTable::SignalNumber("TERM") == SIGTERM);
+    assert(JobTable::SignalNumber("sigint") == SIGINT);
+#ifndef _WIN32
+    assert(JobTable::SignalNumber("STOP") == SIGSTOP);
+    assert(JobTable::SignalNumber("SIGCONT") == SIGCONT);
+#endif
+    assert(JobTable::SignalNumber("BOGUS") == -1);
+    assert(JobTable::SignalNumber("") == -1);
+
+    std::cout << "✓ Signal numbers test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Job Table Tests ===\n" << std::endl;
+
+    test_split_background();
+    test_numbers_and_current();
+    test_resolve();
+    test_reap();
+    test_signal_numbers();
+
+    std::cout << "\n✅ All job table tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "../include/common/line_diff.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace NeuroShell;
+
+std::string Join(const std::vector<std::string>& lines) {
+    std::string text;
+    for (const auto& line : lines) text += line + "\n";
+    return text;
+}
+
+// Edits in a shortest script, by dynamic programming over the LCS
+size_t ReferenceEdits(const std::vector<std::string_view>& a, const std::vector<std::string_view>& b) {
+    std::vector<std::vector<size_t>> lcs(a.size() + 1, std::vector<size_t>(b.size() + 1, 0));
+    for (size_t i = 1; i <= a.size(); ++i) {
+        for (size_t j = 1; j <= b.size(); ++j) {
+            lcs[i][j] = a[i - 1] == b[j - 1] ? lcs[i - 1][j - 1] + 1 : std::max(lcs[i - 1][j], lcs[i][j - 1]);
+        }
+    }
+    return a.size() + b.size() - 2 * lcs[a.size()][b.size()];
+}
+
+void test_simple() {
+    OutputDiff diff;
+    assert(LineDiff::Diff("a\nb\nc\n", "a\nb\nc\n", diff));
+    assert(!diff.Changed() && diff.runs.size() == 1 && diff.runs[0].op == DiffOp::Equal && diff.runs[0].count == 3);
+
+    assert(LineDiff::Diff("a\nb\nc\n", "a\nx\nc\nd\n", diff));
+    assert(diff.insertedLines == 2 && diff.deletedLines == 1 && diff.deleted == "b\n");
+    assert(diff.Rebuild("a\nx\nc\nd\n") == "a\nb\nc\n");
+
+    // The last line without its newline is a different line
+    assert(LineDiff::Diff("a\nb", "a\nb\n", diff));
+    assert(diff.insertedLines == 1 && diff.deletedLines == 1 && diff.deleted == "b");
+    assert(diff.Rebuild("a\nb\n") == "a\nb");
+
+    assert(LineDiff::Diff("", "one\n", diff));
+    assert(diff.insertedLines == 1 && diff.Rebuild("one\n").empty());
+    assert(LineDiff::Diff("one\n", "", diff));
+    assert(diff.deletedLines == 1 && diff.Rebuild("") == "one\n");
+
+    // Rebuilding from some other output refuses
+    assert(LineDiff::Diff("a\nb\n", "a\nc\n", diff));
+    assert(diff.Rebuild("a\nc\nd\n").empty());
+
+    std::cout << "✓ Simple diff test passed" << std::endl;
+}
+
+void test_random_edits_are_shortest() {
+    std::mt19937 random(7);
+    for (int round = 0; round < 300; ++round) {
+        // Few distinct lines, so there are many equally short scripts to pick from
+        std::vector<std::string> before;
+        size_t count = random() % 60;
+        for (size_t i = 0; i < count; ++i) before.push_back("line " + std::to_string(random() % 8));
+        std::vector<std::string> after = before;
+        int edits = random() % 10;
+        for (int e = 0; e < edits; ++e) {
+            size_t at = after.empty() ? 0 : random() % (after.size() + 1);
+            if (random() % 2 && at < after.size()) {
+                after.erase(after.begin() + at);
+            } else {
+                after.insert(after.begin() + at, "new " + std::to_string(random() % 4));
+            }
+        }
+
+        std::string beforeText = Join(before);
+        std::string afterText = Join(after);
+        OutputDiff diff;
+        assert(LineDiff::Diff(beforeText, afterText, diff));
+        assert(diff.Rebuild(afterText) == beforeText);
+        size_t expected = ReferenceEdits(LineDiff::SplitLines(beforeText), LineDiff::SplitLines(afterText));
+        assert(diff.insertedLines + diff.deletedLines == expected);
+
+        // Runs alternate and cover both sides exactly
+        size_t beforeLines = 0;
+        size_t afterLines = 0;
+        for (size_t i = 0; i < diff.runs.size(); ++i) {
+            assert(diff.runs[i].count > 0);
+            assert(i == 0 || diff.runs[i].op != diff.runs[i - 1].op);
+            if (diff.runs[i].op != DiffOp::Insert) beforeLines += diff.runs[i].count;
+            if (diff.runs[i].op != DiffOp::Delete) afterLines += diff.runs[i].count;
+        }
+        assert(beforeLines == before.size() && afterLines == after.size());
+    }
+
+    std::cout << "✓ Random edits are shortest test passed" << std::endl;
+}
+
+void test_polling_output() {
+    // A large listing where a few lines changed between polls
+    std::vector<std::string> before;
+    for (int i = 0; i < 100000; ++i) before.push_back("process " + std::to_string(i) + " running");
+    std::vector<std::string> after = before;
+    after[500] = "process 500 sleeping";
+    after.erase(after.begin() + 70000);
+    after.push_back("process 100000 running");
+
+    std::string beforeText = Join(before);
+    std::string afterText = Join(after);
+    OutputDiff diff;
+    assert(LineDiff::Diff(beforeText, afterText, diff));
+    assert(diff.insertedLines == 2 && diff.deletedLines == 2);
+    assert(diff.MemoryBytes() < 200);
+    assert(diff.Rebuild(afterText) == beforeText);
+
+    // Too different to be worth it
+    std::vector<std::string> other;
+    for (int i = 0; i < 2000; ++i) other.push_back("other " + std::to_string(i));
+    assert(!LineDiff::Diff(beforeText, Join(other), diff));
+
+    std::cout << "✓ Polling output test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Line Diff Tests ===\n" << std::endl;
+
+    test_simple();
+    test_random_edits_are_shortest();
+    test_polling_output();
+
+    std::cout << "\n✅ All line diff tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "../include/common/line_index.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace NeuroShell;
+
+// Lines of varying length, some long enough for multi-byte deltas
+std::string MakeLines(size_t count, std::mt19937& random) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = random() % 10 == 0 ? random() % 1000 : random() % 80;
+        text += std::to_string(i);
+        text.append(length, 'x');
+        text += '\n';
+    }
+    return text;
+}
+
+// Reference answers by scanning
+std::vector<size_t> Starts(const std::string& text) {
+    std::vector<size_t> starts = { 0 };
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n') starts.push_back(i + 1);
+    }
+    return starts;
+}
+
+void CheckAgainstText(const LineIndex& index, const OutputBuffer& buffer, const std::string& text) {
+    std::vector<size_t> starts = Starts(text);
+    size_t lines = text.empty() ? 0 : (text.back() == '\n' ? starts.size() - 1 : starts.size());
+    assert(index.Size() == text.size());
+    assert(index.LineCount() == lines);
+
+    for (size_t line = 0; line < starts.size(); ++line) {
+        assert(index.LineStart(line, buffer) == starts[line]);
+    }
+    assert(index.LineStart(starts.size() + 5, buffer) == text.size());
+
+    for (size_t offset = 0; offset < text.size(); offset += 1 + offset % 7) {
+        size_t expected = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+        assert(index.LineAt(offset, buffer) == expected);
+    }
+}
+
+void test_empty_and_single_line() {
+    LineIndex index;
+    OutputBuffer buffer;
+    assert(index.LineCount() == 0);
+    assert(index.LineStart(0, buffer) == 0);
+
+    index.Append("no newline", 10);
+    buffer.Append("no newline", 10);
+    assert(index.LineCount() == 1);
+    assert(index.LineStart(1, buffer) == 10);
+    assert(index.LineAt(9, buffer) == 0);
+
+    index.Append("\n", 1);
+    buffer.Append("\n", 1);
+    assert(index.LineCount() == 1);
+    assert(index.LineStart(1, buffer) == 11);
+
+    index.Append("\n\n", 2);
+    buffer.Append("\n\n", 2);
+    assert(index.LineCount() == 3);
+
+    std::cout << "✓ Empty and single line test passed" << std::endl;
+}
+
+void test_chunked_append() {
+    OutputBuffer::SetDefaultLimits(1 << 30, 1 << 30);
+    std::mt19937 random(1);
+    std::string text = MakeLines(5000, random) + "unterminated";
+
+    // Chunk boundaries anywhere, including inside lines and right at newlines
+    LineIndex index;
+    OutputBuffer buffer;
+    for (size_t i = 0; i < text.size(); ) {
+        size_t size = std::min<size_t>(1 + random() % 300, text.size() - i);
+        index.Append(text.data() + i, size);
+        buffer.Append(text.data() + i, size);
+        i += size;
+    }
+    CheckAgainstText(index, buffer, text);
+    assert(index.MemoryBytes() < text.size() / 10);
+
+    std::cout << "✓ Chunked append test passed" << std::endl;
+}
+
+void test_compact_keeps_answers() {
+    std::mt19937 random(2);
+    std::string text = MakeLines(20000, random);
+
+    OutputBuffer::SetDefaultLimits(64 * 1024, 64 * 1024);
+    LineIndex index(256 * 1024);
+    OutputBuffer buffer;
+    for (size_t i = 0; i < text.size(); i += 4096) {
+        size_t size = std::min<size_t>(4096, text.size() - i);
+        index.Append(text.data() + i, size);
+        buffer.Append(text.data() + i, size);
+    }
+    assert(buffer.SpilledBytes() > 0);
+
+    // Below the budget nothing happens
+    size_t before = index.MemoryBytes();
+    index.Compact(buffer.Head().size(), buffer.TailOffset());
+    assert(index.MemoryBytes() == before);
+
+    // Far past it: the spilled middle goes sparse, answers stay the same
+    std::string more;
+    while (index.MemoryBytes() <= 256 * 1024) {
+        more = MakeLines(20000, random);
+        text += more;
+        index.Append(more.data(), more.size());
+        buffer.Append(more.data(), more.size());
+    }
+    before = index.MemoryBytes();
+    index.Compact(buffer.Head().size(), buffer.TailOffset());
+    assert(index.MemoryBytes() < before / 4);
+
+    std::vector<size_t> starts = Starts(text);
+    assert(index.LineCount() == starts.size() - 1);
+    for (size_t line = 0; line < starts.size(); line += 1 + random() % 2000) {
+        assert(index.LineStart(line, buffer) == starts[line]);
+        assert(index.LineAt(starts[line], buffer) == line);
+    }
+    // Head and tail lines need no text
+    OutputBuffer none;
+    assert(index.LineStart(10, none) == starts[10]);
+    assert(index.LineStart(starts.size() - 10, none) == starts[starts.size() - 10]);
+
+    std::cout << "✓ Compact test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Line Index Tests ===\n" << std::endl;
+
+    test_empty_and_single_line();
+    test_chunked_append();
+    test_compact_keeps_answers();
+
+    std::cout << "\n✅ All line index tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "../include/terminal/native_builtins.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <ctime>
+#include <cstdlib>
+
+using namespace NeuroShell;
+
+// Runs command through registry; ran is false if it declined
+struct Result {
+    bool ran;
+    int exitCode;
+    std::string output;
+};
+
+Result Run(const BuiltinRegistry& registry, const std::string& command) {
+    Result result = { false, -2, "" };
+    BuiltinCall::OutputCallback onOutput = [&result](OutputStream, const char* data, size_t size) {
+        result.output.append(data, size);
+    };
+    result.ran = registry.Run(command, WorkingDirectory::Current(), onOutput, result.exitCode);
+    return result;
+}
+
+void test_echo() {
+    BuiltinRegistry registry;
+    assert(Run(registry, "echo hello  world").output == "hello world\n");
+    assert(Run(registry, "echo").output == "\n");
+    assert(Run(registry, "echo -n 'two  spaces'").output == "two  spaces");
+    assert(Run(registry, "echo -nE -x -n").output == "-x -n");
+    assert(Run(registry, "echo - a").output == "- a\n");
+
+    // Escapes and help are left to the real echo, and decline without output
+    Result escaped = Run(registry, "echo -e 'a\\tb'");
+    assert(!escaped.ran && escaped.output.empty());
+    assert(!Run(registry, "echo --help").ran);
+
+    std::cout << "✓ Echo test passed" << std::endl;
+}
+
+void test_only_simple_commands() {
+    BuiltinRegistry registry;
+    assert(!Run(registry, "echo $HOME").ran);
+    assert(!Run(registry, "echo a | cat").ran);
+    assert(!Run(registry, "echo a > /dev/null").ran);
+    assert(!Run(registry, "ls").ran);
+    assert(!Run(registry, "").ran);
+
+    std::cout << "✓ Simple commands only test passed" << std::endl;
+}
+
+void test_standard_builtins() {
+    BuiltinRegistry registry;
+    Result ok = Run(registry, "true");
+    assert(ok.ran && ok.exitCode == 0 && ok.output.empty());
+    Result fail = Run(registry, "false ignored");
+    assert(fail.ran && fail.exitCode == 1);
+
+    setenv("NEUROSHELL_TEST_VAR", "some value", 1);
+    unsetenv("NEUROSHELL_TEST_MISSING");
+    Result found = Run(registry, "printenv NEUROSHELL_TEST_VAR");
+    assert(found.ran && found.exitCode == 0 && found.output == "some value\n");
+    Result missing = Run(registry, "printenv NEUROSHELL_TEST_MISSING NEUROSHELL_TEST_VAR");
+    assert(missing.ran && missing.exitCode == 1 && missing.output == "some value\n");
+    assert(Run(registry, "env").output.find("NEUROSHELL_TEST_VAR=some value\n") != std::string::npos);
+    assert(!Run(registry, "env -i ls").ran);
+
+    Result which = Run(registry, "which sh");
+    assert(which.ran && which.exitCode == 0 && which.output.back() == '\n' && which.output.find("/sh") != std::string::npos);
+    assert(!Run(registry, "which -a sh").ran);
+    assert(!Run(registry, "which no-such-program-anywhere").ran);
+
+    setenv("LC_ALL", "C", 1);
+    char year[8];
+    time_t now = time(nullptr);
+    strftime(year, sizeof(year), "%Y", localtime(&now));
+    assert(Run(registry, "date +%Y").output == std::string(year) + "\n");
+    assert(Run(registry, "date +").output == "\n");
+    assert(!Run(registry, "date +%N").ran);
+    assert(!Run(registry, "date -u").ran);
+    setenv("LC_ALL", "de_DE.UTF-8", 1);
+    assert(!Run(registry, "date").ran);
+    unsetenv("LC_ALL");
+
+    assert(Run(registry, "whoami").ran);
+    assert(!Run(registry, "hostname -f").ran);
+
+    std::cout << "✓ Standard builtins test passed" << std::endl;
+}
+
+void test_register() {
+    BuiltinRegistry registry;
+    assert(!registry.IsBuiltin("greet"));
+    registry.Register("greet", [](const BuiltinCall& call) {
+        if (call.argv.size() != 2) return BuiltinRegistry::kDeclined;
+        call.Write(OutputStream::Stdout, "hello " + call.argv[1] + "\n");
+        return 3;
+    });
+    assert(registry.IsBuiltin("greet"));
+
+    Result result = Run(registry, "greet 'big world'");
+    assert(result.ran && result.exitCode == 3 && result.output == "hello big world\n");
+    assert(!Run(registry, "greet").ran);
+
+    std::cout << "✓ Register test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Native Builtin Tests ===\n" << std::endl;
+
+    test_echo();
+    test_only_simple_commands();
+    test_standard_builtins();
+    test_register();
+
+    std::cout << "\n✅ All native builtin tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include "../include/common/output_buffer.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+using namespace NeuroShell;
+
+// Deterministic text where every offset is distinguishable
+std::string MakeText(size_t size) {
+    std::string text;
+    for (size_t i = 0; text.size() < size; ++i) {
+        text += std::to_string(i) + "\n";
+    }
+    text.resize(size);
+    return text;
+}
+
+void test_small_output_stays_in_memory() {
+    OutputBuffer::SetDefaultLimits(1024, 1024);
+    OutputBuffer buffer;
+    buffer.Append("hello ", 6);
+    buffer.Append("world", 5);
+
+    assert(buffer.Size() == 11);
+    assert(buffer.SpilledBytes() == 0);
+    assert(buffer.Str() == "hello world");
+    assert(buffer.Read(6, 100) == "world");
+
+    std::cout << "✓ Small output test passed" << std::endl;
+}
+
+void test_spills_middle() {
+    OutputBuffer::SetDefaultLimits(1024, 2048);
+    std::string text = MakeText(1000000);
+    OutputBuffer buffer;
+    for (size_t i = 0; i < text.size(); i += 4000) {
+        buffer.Append(text.data() + i, std::min<size_t>(4000, text.size() - i));
+    }
+
+    assert(buffer.Size() == text.size());
+    assert(buffer.Head() == text.substr(0, 1024));
+    assert(buffer.MemoryBytes() <= 1024 + 2 * 2048);
+    assert(buffer.SpilledBytes() > 0);
+    assert(!buffer.HasGap());
+    assert(buffer.Tail() == text.substr(buffer.TailOffset()));
+
+    // Any range comes back intact, including ones straddling head, file and tail
+    assert(buffer.Str() == text);
+    assert(buffer.Read(1000, 50000) == text.substr(1000, 50000));
+    assert(buffer.Read(text.size() - 3000, 5000) == text.substr(text.size() - 3000));
+
+    std::cout << "✓ Spill to disk test passed" << std::endl;
+}
+
+void test_find() {
+    OutputBuffer::SetDefaultLimits(16, 16);
+    std::string text = MakeText(300000) + "needle in the haystack" + MakeText(300000);
+    OutputBuffer buffer(text);
+
+    assert(buffer.Find("needle") == text.find("needle"));
+    assert(buffer.Find("absent") == std::string::npos);
+    assert(buffer.Find("1\n2") == text.find("1\n2"));
+
+    std::cout << "✓ Find test passed" << std::endl;
+}
+
+void test_copy_and_clear() {
+    OutputBuffer::SetDefaultLimits(8, 8);
+    std::string text = MakeText(10000);
+    OutputBuffer buffer(text);
+    OutputBuffer copy = buffer;
+
+    buffer.Append("more", 4);
+    assert(copy.Str() == text);
+    assert(buffer.Str() == text + "more");
+
+    buffer = "replaced";
+    assert(buffer.Str() == "replaced");
+    assert(copy.Str() == text);
+
+    buffer.Clear();
+    assert(buffer.Empty());
+
+    std::cout << "✓ Copy and clear test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Output Buffer Tests ===\n" << std::endl;
+
+    try {
+        test_small_output_stays_in_memory();
+        test_spills_middle();
+        test_find();
+        test_copy_and_clear();
+
+        std::cout << "\n✅ All output buffer tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,153 @@
+#include "../include/terminal/output_throttle.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+using namespace NeuroShell;
+using Clock = OutputThrottle::Clock;
+using std::chrono::milliseconds;
+
+void test_one_batch_per_frame() {
+    OutputThrottle throttle;
+    Clock::time_point start = Clock::now();
+
+    // Output after a quiet spell goes out at once
+    assert(throttle.Add(OutputStream::Stdout, "a", 1, start));
+    assert(throttle.Take(start).size() == 1);
+
+    // Within the frame it is only queued
+    assert(!throttle.Add(OutputStream::Stdout, "b", 1, start + milliseconds(2)));
+    assert(!throttle.Add(OutputStream::Stdout, "c", 1, start + milliseconds(8)));
+    assert(throttle.Add(OutputStream::Stdout, "d", 1, start + milliseconds(16)));
+
+    std::vector<OutputThrottle::Chunk> batch = throttle.Take(start + milliseconds(16));
+    assert(batch.size() == 1);
+    assert(batch[0].data == "bcd");
+    assert(throttle.Take(start + milliseconds(17)).empty());
+
+    std::cout << "✓ One batch per frame test passed" << std::endl;
+}
+
+void test_streams_keep_order() {
+    OutputThrottle throttle;
+    Clock::time_point start = Clock::now();
+    throttle.Take(start);
+    throttle.Add(OutputStream::Stdout, "out1 ", 5, start);
+    throttle.Add(OutputStream::Stdout, "out2 ", 5, start);
+    throttle.Add(OutputStream::Stderr, "err ", 4, start);
+    throttle.Add(OutputStream::Stdout, "out3", 4, start);
+
+    std::vector<OutputThrottle::Chunk> batch = throttle.Take(start);
+    assert(batch.size() == 3);
+    assert(batch[0].stream == OutputStream::Stdout && batch[0].data == "out1 out2 ");
+    assert(batch[1].stream == OutputStream::Stderr && batch[1].data == "err ");
+    assert(batch[2].stream == OutputStream::Stdout && batch[2].data == "out3");
+
+    std::cout << "✓ Streams keep order test passed" << std::endl;
+}
+
+void test_batches_fit_budget() {
+    OutputThrottle throttle;
+    Clock::time_point start = Clock::now();
+    throttle.Take(start);
+    std::string chunk(OutputThrottle::kChunkBytes, 'y');
+    for (int i = 0; i < 8; ++i) {
+        assert(!throttle.Add(OutputStream::Stdout, chunk.data(), chunk.size(), start));
+    }
+
+    // A full batch waiting goes out after the short catch-up gap, not a whole frame
+    assert(throttle.Add(OutputStream::Stdout, "", 0, start + milliseconds(3)));
+    assert(throttle.Take(start + milliseconds(3)).size() == 4);
+
+    // 1 MB took 8 ms to append: aim for half that, smoothed
+    throttle.Published(1024 * 1024, milliseconds(8), start + milliseconds(11));
+    assert(throttle.BatchBytes() == 768 * 1024);
+    assert(throttle.Take(start + milliseconds(14)).size() == 3);
+
+    // Fast appends grow batches, up to the cap
+    for (int i = 0; i < 20; ++i) {
+        throttle.Published(1024 * 1024, std::chrono::microseconds(10), start + milliseconds(14));
+    }
+    assert(throttle.BatchBytes() <= OutputThrottle::kMaxBatchBytes);
+    assert(throttle.BatchBytes() > OutputThrottle::kMaxBatchBytes / 2);
+    assert(throttle.Take(start + milliseconds(20)).size() == 1);
+    assert(throttle.Empty());
+
+    std::cout << "✓ Batches fit budget test passed" << std::endl;
+}
+
+void test_stranded() {
+    OutputThrottle throttle;
+    Clock::time_point start = Clock::now();
+    throttle.Take(start);
+    assert(!throttle.Stranded(start + milliseconds(100)));
+
+    throttle.Add(OutputStream::Stdout, "x", 1, start + milliseconds(1));
+    assert(!throttle.Stranded(start + milliseconds(10)));
+    assert(throttle.Stranded(start + milliseconds(17)));
+    throttle.Take(start + milliseconds(17));
+    assert(!throttle.Stranded(start + milliseconds(40)));
+
+    std::cout << "✓ Stranded output test passed" << std::endl;
+}
+
+void test_full_queue() {
+    OutputThrottle throttle;
+    Clock::time_point start = Clock::now();
+    throttle.Take(start);
+    std::string chunk(OutputThrottle::kMaxQueuedBytes / 2, 'y');
+    assert(!throttle.Add(OutputStream::Stdout, chunk.data(), chunk.size(), start));
+    assert(!throttle.Full());
+    assert(throttle.Add(OutputStream::Stdout, chunk.data(), chunk.size(), start));
+    assert(throttle.Full());
+    throttle.Take(start);
+    assert(!throttle.Full());
+
+    std::cout << "✓ Full queue test passed" << std::endl;
+}
+
+void test_flood_detection() {
+    // 1000 bytes per second is a flood for this one
+    OutputThrottle throttle(1000.0);
+    Clock::time_point start = Clock::now();
+    std::string chunk(100, 'y');
+    assert(!throttle.Flooding());
+
+    // 100 bytes every 50 ms: 2000 bytes per second
+    for (int i = 1; i <= 10; ++i) {
+        throttle.Add(OutputStream::Stdout, chunk.data(), chunk.size(), start + milliseconds(50 * i));
+    }
+    assert(throttle.Flooding());
+    assert(throttle.BytesPerSecond() > 1500.0);
+
+    // Slowing to 600 bytes per second is not enough to leave flood mode
+    Clock::time_point slow = start + milliseconds(500);
+    for (int i = 1; i <= 5; ++i) {
+        throttle.Add(OutputStream::Stdout, chunk.data(), 60, slow + milliseconds(100 * i));
+    }
+    assert(throttle.Flooding());
+
+    // Silence ends it once a window has passed; the caller is told to take it back
+    Clock::time_point quiet = slow + milliseconds(500);
+    throttle.Take(quiet);
+    assert(throttle.Stranded(quiet + milliseconds(300)));
+    throttle.Take(quiet + milliseconds(300));
+    assert(!throttle.Flooding());
+    assert(!throttle.Stranded(quiet + milliseconds(400)));
+
+    std::cout << "✓ Flood detection test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Output Throttle Tests ===\n" << std::endl;
+
+    test_one_batch_per_frame();
+    test_streams_keep_order();
+    test_batches_fit_budget();
+    test_stranded();
+    test_full_queue();
+    test_flood_detection();
+
+    std::cout << "\n✅ All output throttle tests passed!\n" << std::endl;
+    return 0;
+}
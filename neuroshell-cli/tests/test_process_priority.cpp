@@ -0,0 +1,172 @@
+#include "../include/terminal/process_priority.h"
+#include "../include/terminal/process.h"
+#include "../include/terminal/spawn_zygote.h"
+#include <iostream>
+#include <cassert>
+#include <sstream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace NeuroShell;
+
+void test_parse() {
+    ProcessPriority priority;
+    assert(ProcessPriority::Parse("nice:10 io:best-effort:7", priority));
+    assert(priority.nice == 10);
+    assert(priority.ioClass == 2 && priority.ioLevel == 7);
+    assert(!priority.idleScheduling);
+
+    assert(ProcessPriority::Parse("nice:19 io:idle sched:idle", priority));
+    assert(priority.nice == 19 && priority.ioClass == 3 && priority.idleScheduling);
+
+    // Parts left out go back to the defaults
+    assert(ProcessPriority::Parse("io:best-effort", priority));
+    assert(priority.nice == 0 && priority.ioClass == 2 && priority.ioLevel == 4 && !priority.idleScheduling);
+    assert(ProcessPriority::Parse("", priority));
+    assert(!priority.Any());
+
+    // Raising priority, and anything unknown, is refused without touching it
+    priority.nice = 7;
+    assert(!ProcessPriority::Parse("nice:-5", priority));
+    assert(!ProcessPriority::Parse("nice:20", priority));
+    assert(!ProcessPriority::Parse("io:realtime:0", priority));
+    assert(!ProcessPriority::Parse("io:best-effort:8", priority));
+    assert(!ProcessPriority::Parse("io:idle:3", priority));
+    assert(!ProcessPriority::Parse("sched:fifo", priority));
+    assert(!ProcessPriority::Parse("nice 5", priority));
+    assert(!ProcessPriority::Parse("weight:5", priority));
+    assert(priority.nice == 7);
+
+    std::cout << "✓ Parse test passed" << std::endl;
+}
+
+void test_classes() {
+    PriorityClasses classes;
+    assert(!classes.For(CommandOrigin::Interactive).Any());
+    assert(classes.For(CommandOrigin::AIBatch).nice < classes.For(CommandOrigin::Background).nice);
+    assert(classes.For(CommandOrigin::Background).nice < classes.For(CommandOrigin::Speculative).nice);
+    assert(classes.For(CommandOrigin::Speculative).idleScheduling);
+
+    CommandOrigin origin;
+    assert(PriorityClasses::FromName("background", origin) && origin == CommandOrigin::Background);
+    assert(PriorityClasses::FromName("ai", origin) && origin == CommandOrigin::AIBatch);
+    assert(!PriorityClasses::FromName("batch", origin));
+
+    ProcessPriority low;
+    low.nice = 3;
+    classes.Set(CommandOrigin::Interactive, low);
+    assert(classes.For(CommandOrigin::Interactive).nice == 3);
+
+    std::cout << "✓ Priority classes test passed" << std::endl;
+}
+
+void test_apply() {
+#ifdef __linux__
+    ProcessPriority priority;
+    assert(ProcessPriority::Parse("nice:12 io:idle sched:idle", priority));
+
+    // In a child, as between fork and exec; it reports what it ended up with
+    pid_t pid = fork();
+    if (pid == 0) {
+        ApplyPriority(priority);
+        errno = 0;
+        bool ok = getpriority(PRIO_PROCESS, 0) >= 12 && errno == 0;
+        ok = ok && sched_getscheduler(0) == SCHED_IDLE;
+        long ioprio = syscall(SYS_ioprio_get, 1, 0);
+        ok = ok && (ioprio < 0 || (ioprio >> 13) == 3);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    std::cout << "✓ Apply priority test passed" << std::endl;
+#endif
+}
+
+#ifdef __linux__
+// Wait for a child running "cat /proc/self/stat" and return the fields after
+// its name: its nice value is values[16] (field 19), its policy values[38]
+std::vector<std::string> ReadStat(ChildProcess& child) {
+    ProcessExit result = WaitForExit(child);
+    assert(result.exitCode == 0);
+    std::string stat;
+    char buffer[4096];
+    ssize_t got;
+    while ((got = read(child.stdoutFd, buffer, sizeof(buffer))) > 0) {
+        stat.append(buffer, got);
+    }
+    close(child.stdoutFd);
+    close(child.stderrFd);
+
+    std::istringstream fields(stat.substr(stat.rfind(')') + 2));
+    std::vector<std::string> values;
+    std::string value;
+    while (fields >> value) values.push_back(value);
+    assert(values.size() > 38);
+    return values;
+}
+#endif
+
+void test_spawn_lowered() {
+#ifdef __linux__
+    errno = 0;
+    int niceBefore = getpriority(PRIO_PROCESS, 0);
+    int policyBefore = sched_getscheduler(0);
+
+    SpawnOptions options;
+    options.argv = { "cat", "/proc/self/stat" };
+    assert(ProcessPriority::Parse("nice:12 sched:idle", options.limits.priority));
+    ChildProcess child = SpawnProcess(options);
+    std::vector<std::string> values = ReadStat(child);
+    assert(std::stoi(values[16]) == 12);
+    assert(std::stoi(values[38]) == SCHED_IDLE);
+
+    // And the thread that spawned it was left alone
+    assert(getpriority(PRIO_PROCESS, 0) == niceBefore);
+    assert(sched_getscheduler(0) == policyBefore);
+
+    std::cout << "✓ Spawn lowered test passed" << std::endl;
+#endif
+}
+
+void test_zygote_lowered() {
+#ifdef __linux__
+    if (!SpawnZygote::Start()) {
+        std::cout << "✓ Zygote lowered test skipped (no spawn helper)" << std::endl;
+        return;
+    }
+
+    // A lowered priority alone still goes through the helper, which applies it
+    ResourceLimits limits;
+    assert(ProcessPriority::Parse("nice:15 sched:idle", limits.priority));
+    ChildProcess child = SpawnCommand("cat /proc/self/stat", WorkingDirectory(), limits);
+    assert(child.viaZygote);
+    std::vector<std::string> values = ReadStat(child);
+    assert(std::stoi(values[16]) == 15);
+    assert(std::stoi(values[38]) == SCHED_IDLE);
+    SpawnZygote::Stop();
+
+    std::cout << "✓ Zygote lowered test passed" << std::endl;
+#endif
+}
+
+int main() {
+    std::cout << "\n=== Running Process Priority Tests ===\n" << std::endl;
+
+    test_parse();
+    test_classes();
+    test_apply();
+    test_spawn_lowered();
+    test_zygote_lowered();
+
+    std::cout << "\n✅ All process priority tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "../include/terminal/speculative_runner.h"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+
+using namespace NeuroShell;
+namespace fs = std::filesystem;
+
+// Scratch directory removed at the end of each test
+struct TempDir {
+    fs::path path;
+    WorkingDirectory dir;
+    TempDir() : path(fs::temp_directory_path() / ("neuroshell_speculate_" + std::to_string(std::rand()))) {
+        fs::create_directories(path);
+        WorkingDirectory::Current().Resolve(path.string(), dir);
+    }
+    ~TempDir() { std::error_code ec; fs::remove_all(path, ec); }
+};
+
+// Answers every run at once with the command's own text, for half a CPU second
+std::atomic<int> runs{ 0 };
+void FakeRunner(SpeculativeRunner& runner) {
+    runner.SetRunner([](const std::string& command, const WorkingDirectory&,
+                        std::shared_ptr<CancelToken>, SpeculativeRunner::DoneFn done) {
+        runs++;
+        CachedResult result;
+        result.output = command;
+        done(true, result, 0.5);
+    });
+}
+
+// Teach "cd" -> "ls -la" and wait for a speculative run of it to be warm
+void Warm(SpeculativeRunner& runner, const TempDir& temp) {
+    for (int i = 0; i < 2; ++i) {
+        runner.Observe("cd project", true);
+        runner.Observe("ls -la");
+    }
+    size_t warm = runner.GetStats().warm;
+    runner.Speculate("cd elsewhere", temp.dir);
+    for (int i = 0; i < 200 && runner.GetStats().warm == warm; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(runner.GetStats().warm == warm + 1);
+}
+
+void test_predicts_successors() {
+    SpeculativeRunner runner;
+    const char* sessions[][2] = {
+        { "cd a", "git status" }, { "cd b", "git status" }, { "cd c", "ls" },
+        { "make", "rm -f out" }, { "make", "rm -f out" }
+    };
+    for (const auto& session : sessions) {
+        runner.Observe(session[0], session[0][0] == 'c');
+        runner.Observe(session[1]);
+    }
+
+    // Where cd went doesn't matter; one sighting is not enough
+    std::vector<std::string> predictions = runner.Predict("cd somewhere");
+    assert(predictions.size() == 1);
+    assert(predictions[0] == "git status");
+
+    // Frequent, but it writes
+    assert(runner.Predict("make").empty());
+    assert(runner.Predict("unknown").empty());
+
+    std::cout << "✓ Predicts successors test passed" << std::endl;
+}
+
+void test_speculatable() {
+    neuroshell::utils::SafetyChecker safety;
+    assert(safety.isSpeculatable("ls -la"));
+    assert(safety.isSpeculatable("git status"));
+    assert(safety.isSpeculatable("git log --oneline -5"));
+    assert(safety.isSpeculatable("git branch -a"));
+    assert(!safety.isSpeculatable("git branch feature"));
+    assert(!safety.isSpeculatable("git branch -D old"));
+    assert(!safety.isSpeculatable("git log --output=log.txt"));
+    assert(!safety.isSpeculatable("git -c core.pager=x status"));
+    assert(!safety.isSpeculatable("git commit -m x"));
+    assert(!safety.isSpeculatable("date"));
+    assert(!safety.isSpeculatable("rm -f x"));
+
+    assert(SpeculativeRunner::RunnableForm("git status") == "git --no-optional-locks status");
+    assert(SpeculativeRunner::RunnableForm("git log -3") == "git --no-optional-locks log --no-ext-diff --no-textconv -3");
+    assert(SpeculativeRunner::RunnableForm("ls -la") == "ls -la");
+
+    std::cout << "✓ Speculatable commands test passed" << std::endl;
+}
+
+void test_warm_hit() {
+    TempDir temp;
+    SpeculativeRunner runner;
+    FakeRunner(runner);
+    int before = runs;
+    Warm(runner, temp);
+    assert(runs == before + 1);
+
+    // Speculating again doesn't rerun what is already warm
+    runner.Speculate("cd elsewhere", temp.dir);
+    assert(runs == before + 1);
+
+    // Same words, other spacing
+    CachedResult result;
+    assert(!runner.Take("ls -la", "/elsewhere", result));
+    assert(runner.Take("ls  -la", temp.path.string(), result));
+    assert(result.output == "ls -la");
+    assert(!runner.Take("ls -la", temp.path.string(), result));
+
+    SpeculativeRunner::Stats stats = runner.GetStats();
+    assert(stats.started == 1);
+    assert(stats.hits == 1);
+    assert(stats.misses == 2);
+    assert(stats.wasted == 0);
+    assert(stats.cpuSeconds == 0.5);
+
+    std::cout << "✓ Warm hit test passed" << std::endl;
+}
+
+void test_dropped_results() {
+    TempDir temp;
+    SpeculativeRunner runner;
+    FakeRunner(runner);
+    CachedResult result;
+
+    // A command that could write drops what is warm; reads and built-ins don't
+    Warm(runner, temp);
+    runner.Observe("cat notes.txt");
+    runner.Observe("pwd", true);
+    assert(runner.GetStats().warm == 1);
+    runner.Observe("touch notes.txt");
+    assert(runner.GetStats().warm == 0);
+    assert(runner.GetStats().wasted == 1);
+
+    // What it read changed
+    Warm(runner, temp);
+    std::ofstream(temp.path / "new.txt") << "x";
+    assert(!runner.Take("ls -la", temp.path.string(), result));
+    assert(runner.GetStats().wasted == 2);
+
+    // Kept too long
+    runner.SetLimits(20, 2);
+    Warm(runner, temp);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    assert(!runner.Take("ls -la", temp.path.string(), result));
+
+    SpeculativeRunner::Stats stats = runner.GetStats();
+    assert(stats.wasted == 3);
+    assert(stats.wastedCpuSeconds == 1.5);
+    assert(stats.hits == 0);
+
+    std::cout << "✓ Dropped results test passed" << std::endl;
+}
+
+void test_failed_run() {
+    TempDir temp;
+    SpeculativeRunner runner;
+    runner.SetRunner([](const std::string&, const WorkingDirectory&,
+                        std::shared_ptr<CancelToken>, SpeculativeRunner::DoneFn done) {
+        done(false, CachedResult(), 0.25);
+    });
+    for (int i = 0; i < 2; ++i) {
+        runner.Observe("cd project", true);
+        runner.Observe("ls");
+    }
+    runner.Speculate("cd project", temp.dir);
+    for (int i = 0; i < 200 && runner.GetStats().wasted == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    SpeculativeRunner::Stats stats = runner.GetStats();
+    assert(stats.started == 1);
+    assert(stats.wasted == 1);
+    assert(stats.warm == 0);
+    assert(stats.wastedCpuSeconds == 0.25);
+
+    std::cout << "✓ Failed run test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Speculative Runner Tests ===\n" << std::endl;
+
+    test_predicts_successors();
+    test_speculatable();
+    test_warm_hit();
+    test_dropped_results();
+    test_failed_run();
+
+    std::cout << "\n✅ All speculative runner tests passed!\n" << std::endl;
+    return 0;
+}
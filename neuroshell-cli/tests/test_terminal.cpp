@@ -0,0 +1,224 @@
+#include "../include/terminal/terminal.h"
+#include "../include/terminal/process_reactor.h"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <functional>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+
+using namespace NeuroShell;
+namespace fs = std::filesystem;
+
+// Scratch directory removed at the end of each test
+struct TempDir {
+    fs::path path;
+    TempDir() : path(fs::temp_directory_path() / ("neuroshell_terminal_" + std::to_string(std::rand()))) {
+        fs::create_directories(path);
+    }
+    ~TempDir() { std::error_code ec; fs::remove_all(path, ec); }
+};
+
+// Wait up to five seconds for condition, checked under the history lock
+bool WaitFor(Terminal& terminal, const std::function<bool()>& condition) {
+    for (int i = 0; i < 1000; ++i) {
+        {
+            auto lock = terminal.LockHistory();
+            if (condition()) return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+const CommandBlock* Find(Terminal& terminal, uint64_t blockId) {
+    for (const auto& block : terminal.GetHistory()) {
+        if (block.id == blockId) return &block;
+    }
+    return nullptr;
+}
+
+// Run command and wait for its block to finish
+uint64_t Run(Terminal& terminal, const std::string& command) {
+    terminal.ExecuteCommand(command);
+    uint64_t blockId;
+    {
+        auto lock = terminal.LockHistory();
+        blockId = terminal.GetHistory().back().id;
+    }
+    assert(WaitFor(terminal, [&]() { return Find(terminal, blockId)->status != CommandStatus::Running; }));
+    return blockId;
+}
+
+// 200 numbered lines, one of them changed
+std::string WriteLines(const fs::path& file, int changed) {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += i == changed ? "changed line " + std::to_string(i) + "\n" : "line " + std::to_string(i) + "\n";
+    }
+    std::ofstream(file, std::ios::trunc) << text;
+    return text;
+}
+
+void test_unfold_keeps_chain() {
+    TempDir dir;
+    Terminal terminal;
+    terminal.Initialize();
+    Run(terminal, "cd " + dir.path.string());
+
+    // Three runs, each folded into the next: A -> B -> C
+    std::string textA = WriteLines(dir.path / "lines.txt", 10);
+    uint64_t a = Run(terminal, "cat lines.txt");
+    std::string textB = WriteLines(dir.path / "lines.txt", 20);
+    uint64_t b = Run(terminal, "cat lines.txt");
+    assert(WaitFor(terminal, [&]() { return Find(terminal, a)->outputFoldedInto == b; }));
+    WriteLines(dir.path / "lines.txt", 30);
+    uint64_t c = Run(terminal, "cat lines.txt");
+    assert(WaitFor(terminal, [&]() { return Find(terminal, b)->outputFoldedInto == c; }));
+    assert(terminal.RebuildOutput(a) == textA);
+
+    // Watching C unfolds B; A stays folded into B and must still rebuild
+    assert(terminal.StartWatch(c));
+    {
+        auto lock = terminal.LockHistory();
+        assert(Find(terminal, b)->outputFoldedInto == 0);
+        assert(Find(terminal, b)->output.Str() == textB);
+        assert(Find(terminal, a)->outputFoldedInto == b);
+    }
+    assert(terminal.RebuildOutput(a) == textA);
+    terminal.StopWatch(c);
+
+    std::cout << "✓ Unfold keeps chain test passed" << std::endl;
+}
+
+void test_diff_skips_other_directory() {
+    TempDir dir;
+    Terminal terminal;
+    terminal.Initialize();
+    fs::create_directories(dir.path / "other");
+    WriteLines(dir.path / "other" / "lines.txt", 40);
+    Run(terminal, "cd " + dir.path.string());
+
+    // The same command run in another directory in between is passed over
+    WriteLines(dir.path / "lines.txt", 10);
+    uint64_t a = Run(terminal, "cat lines.txt");
+    Run(terminal, "cd other");
+    uint64_t b = Run(terminal, "cat lines.txt");
+    Run(terminal, "cd ..");
+    WriteLines(dir.path / "lines.txt", 20);
+    uint64_t c = Run(terminal, "cat lines.txt");
+    assert(WaitFor(terminal, [&]() { return Find(terminal, c)->diff.baseBlockId == a; }));
+    {
+        auto lock = terminal.LockHistory();
+        assert(Find(terminal, b)->diff.baseBlockId == 0);
+    }
+
+    std::cout << "✓ Diff skips other directory test passed" << std::endl;
+}
+
+void test_watch_rerun_skips_cache() {
+    TempDir dir;
+    Terminal terminal;
+    terminal.Initialize();
+    terminal.SetWatchTiming(20, 0);
+    Run(terminal, "cd " + dir.path.string());
+
+    std::ofstream(dir.path / "value.txt") << "first\n";
+    uint64_t blockId = Run(terminal, "cat value.txt");
+    assert(terminal.StartWatch(blockId));
+
+    // Same size and mtime, so the cache's fingerprint can't tell; the rerun must still run
+    auto mtime = fs::last_write_time(dir.path / "value.txt");
+    std::ofstream(dir.path / "value.txt", std::ios::trunc) << "again\n";
+    fs::last_write_time(dir.path / "value.txt", mtime);
+    assert(WaitFor(terminal, [&]() {
+        const CommandBlock* block = Find(terminal, blockId);
+        return block->watchReruns > 0 && block->status != CommandStatus::Running;
+    }));
+    {
+        auto lock = terminal.LockHistory();
+        assert(Find(terminal, blockId)->output.Str() == "again\n");
+        assert(!Find(terminal, blockId)->fromCache);
+    }
+    terminal.StopWatch(blockId);
+
+    std::cout << "✓ Watch rerun skips cache test passed" << std::endl;
+}
+
+void test_session_closed_while_running() {
+    Terminal terminal;
+    terminal.Initialize();
+    if (!terminal.SetSessionMode(true)) {
+        std::cout << "✓ Session closed while running test skipped (no shell session)" << std::endl;
+        return;
+    }
+
+    // The running command keeps the old shell until it is done
+    terminal.ExecuteCommand("sleep 0.2; echo still here");
+    uint64_t blockId;
+    {
+        auto lock = terminal.LockHistory();
+        blockId = terminal.GetHistory().back().id;
+    }
+    assert(terminal.SetSessionMode(false));
+    assert(!terminal.IsSessionMode());
+    assert(WaitFor(terminal, [&]() { return Find(terminal, blockId)->status != CommandStatus::Running; }));
+    {
+        auto lock = terminal.LockHistory();
+        assert(Find(terminal, blockId)->status == CommandStatus::Success);
+        assert(Find(terminal, blockId)->output.Str().find("still here") != std::string::npos);
+    }
+
+    std::cout << "✓ Session closed while running test passed" << std::endl;
+}
+
+void test_destroy_while_running() {
+    auto start = std::chrono::steady_clock::now();
+    {
+        Terminal terminal;
+        terminal.Initialize();
+        terminal.ExecuteCommand("sleep 30");
+        assert(WaitFor(terminal, [&]() { return terminal.GetHistory().back().status == CommandStatus::Running; }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    // Cancelled and reported before the terminal went away
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+
+    std::cout << "✓ Destroy while running test passed" << std::endl;
+}
+
+void test_reactor_shutdown_gives_up() {
+    // The command ignores SIGINT and SIGTERM; a grandchild in its own session keeps the pipe open
+    ProcessReactor reactor;
+    ChildProcess child = SpawnCommand("trap '' INT TERM; setsid sleep 5 & sleep 30", WorkingDirectory());
+    auto cancel = std::make_shared<CancelToken>();
+    std::atomic<bool> reported(false);
+    assert(reactor.Watch(child, nullptr, [&reported](const ProcessExit&) { reported = true; }, cancel));
+
+    auto start = std::chrono::steady_clock::now();
+    reactor.Shutdown();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(reported);
+    assert(cancel->IsCancelled());
+    assert(elapsed < std::chrono::milliseconds(ProcessReactor::kShutdownGiveUpMs + 1000));
+    assert(reactor.ActiveCount() == 0);
+
+    std::cout << "✓ Reactor shutdown gives up test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running Terminal Tests ===\n" << std::endl;
+
+    test_unfold_keeps_chain();
+    test_diff_skips_other_directory();
+    test_watch_rerun_skips_cache();
+    test_session_closed_while_running();
+    test_destroy_while_running();
+    test_reactor_shutdown_gives_up();
+
+    std::cout << "\n✅ All terminal tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../include/common/thread_pool.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+
+using namespace NeuroShell;
+
+void test_runs_all_tasks() {
+    ThreadPool pool(4);
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 1000; ++i) {
+        assert(pool.Submit([&count]() { count++; }));
+    }
+    pool.Shutdown();
+
+    assert(count == 1000);
+    assert(pool.GetMetrics(TaskPriority::Interactive).completed == 1000);
+
+    std::cout << "✓ Runs all tasks test passed" << std::endl;
+}
+
+void test_interactive_first() {
+    ThreadPool pool(1);
+    std::atomic<bool> release{false};
+    std::string order;
+    std::mutex orderMutex;
+
+    // Hold the only worker so both lanes fill up before anything runs
+    pool.Submit([&release]() { while (!release) std::this_thread::yield(); });
+    for (char c : std::string("bbb")) {
+        pool.Submit([&, c]() { std::lock_guard<std::mutex> lock(orderMutex); order += c; }, TaskPriority::Background);
+    }
+    for (char c : std::string("iii")) {
+        pool.Submit([&, c]() { std::lock_guard<std::mutex> lock(orderMutex); order += c; }, TaskPriority::Interactive);
+    }
+    assert(pool.GetMetrics(TaskPriority::Background).queueDepth == 3);
+
+    release = true;
+    pool.Shutdown();
+
+    assert(order == "iiibbb");
+
+    std::cout << "✓ Interactive-first test passed" << std::endl;
+}
+
+void test_stealing() {
+    ThreadPool pool(4);
+    std::atomic<int> done{0};
+    std::atomic<bool> release{false};
+
+    // A task queues more work on its own worker, then blocks it; others must steal
+    pool.Submit([&]() {
+        for (int i = 0; i < 3; ++i) {
+            pool.Submit([&done]() { done++; });
+        }
+        while (done < 3 && !release) std::this_thread::yield();
+    });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (done < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    release = true;
+    assert(done == 3);
+    pool.Shutdown();
+
+    std::cout << "✓ Work stealing test passed" << std::endl;
+}
+
+void test_background_reserved() {
+    ThreadPool pool(4);
+    assert(pool.GetInteractiveLimit() == 3);
+    std::atomic<bool> release{false};
+    std::atomic<int> running{0};
+    std::atomic<bool> backgroundDone{false};
+
+    // More long interactive tasks than workers; background work still gets through
+    for (int i = 0; i < 5; ++i) {
+        pool.Submit([&]() {
+            running++;
+            while (!release) std::this_thread::yield();
+        });
+    }
+    pool.Submit([&backgroundDone]() { backgroundDone = true; }, TaskPriority::Background);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!backgroundDone && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(backgroundDone);
+    assert(running == 3);
+
+    release = true;
+    pool.Shutdown();
+    assert(running == 5);
+
+    std::cout << "✓ Background reserved test passed" << std::endl;
+}
+
+void test_shutdown() {
+    ThreadPool pool(2);
+    std::atomic<int> count{0};
+
+    for (int i = 0; i < 50; ++i) {
+        pool.Submit([&count]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            count++;
+        }, TaskPriority::Background);
+    }
+    pool.Shutdown();
+
+    assert(count == 50);
+    assert(!pool.Submit([]() {}));
+    pool.Shutdown();    // Second call is harmless
+
+    std::cout << "✓ Shutdown test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Thread Pool Tests ===\n" << std::endl;
+
+    try {
+        test_runs_all_tasks();
+        test_interactive_first();
+        test_stealing();
+        test_background_reserved();
+        test_shutdown();
+
+        std::cout << "\n✅ All thread pool tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,171 @@
+#include "../include/common/utf8_sanitizer.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace NeuroShell;
+
+const std::string kFffd = "\xEF\xBF\xBD";
+
+std::vector<SimdLevel> Levels() {
+    std::vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if (Utf8Sanitizer::BestLevel() >= SimdLevel::Sse2) levels.push_back(SimdLevel::Sse2);
+    if (Utf8Sanitizer::BestLevel() >= SimdLevel::Avx2) levels.push_back(SimdLevel::Avx2);
+    return levels;
+}
+
+std::string Sanitize(const std::string& input, SimdLevel level, size_t chunk = 0) {
+    Utf8Sanitizer sanitizer(level);
+    std::string out;
+    if (chunk == 0) chunk = input.size() + 1;
+    for (size_t i = 0; i < input.size(); i += chunk) {
+        sanitizer.Feed(input.data() + i, std::min(chunk, input.size() - i), out);
+    }
+    sanitizer.Finish(out);
+    return out;
+}
+
+void test_valid_text_unchanged() {
+    std::string text = "plain ascii\twith tabs\n"
+                       "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xE6\x97\xA5\xE6\x9C\xAC\n"
+                       "\x1b[31mred\x1b[0m\r\n";
+    for (int i = 0; i < 6; ++i) text += text;
+
+    for (SimdLevel level : Levels()) {
+        assert(Sanitize(text, level) == text);
+        assert(Sanitize(text, level, 1) == text);
+        assert(Sanitize(text, level, 7) == text);
+    }
+
+    std::cout << "✓ Valid text test passed" << std::endl;
+}
+
+void test_invalid_sequences_replaced() {
+    struct Case {
+        std::string input;
+        std::string expected;
+    };
+    std::vector<Case> cases = {
+        { "a\x80" "b", "a" + kFffd + "b" },                         // Stray continuation
+        { "\xC0\xAF", kFffd + kFffd },                              // Overlong lead
+        { "\xE0\x80\xAF", kFffd + kFffd + kFffd },                  // Overlong 3-byte
+        { "\xED\xA0\x80", kFffd + kFffd + kFffd },                  // Surrogate
+        { "\xF4\x90\x80\x80", kFffd + kFffd + kFffd + kFffd },      // Past U+10FFFF
+        { "\xE2\x82x", kFffd + "x" },                               // Truncated: one replacement
+        { "\xF0\x9F\x98", kFffd },                                  // Truncated at the end
+        { "\xFF\xFE", kFffd + kFffd },
+    };
+
+    for (SimdLevel level : Levels()) {
+        for (const auto& c : cases) {
+            // Also buried in a long ASCII run so the vector paths stop on it
+            std::string padding(100, 'p');
+            assert(Sanitize(c.input, level) == c.expected);
+            assert(Sanitize(padding + c.input + padding, level) == padding + c.expected + padding);
+            for (size_t chunk = 1; chunk < 5; ++chunk) {
+                assert(Sanitize(c.input, level, chunk) == c.expected);
+            }
+        }
+    }
+
+    std::cout << "✓ Invalid sequences test passed" << std::endl;
+}
+
+void test_controls_dropped() {
+    const char raw[] = "a\x00" "b\x08" "c\x7F" "d\x01\x02\x1b[1me\x07\r\n";
+    std::string input(raw, sizeof(raw) - 1);
+    input += std::string(70, 'x') + '\x0c' + std::string(70, 'y');
+
+    for (SimdLevel level : Levels()) {
+        Utf8Sanitizer sanitizer(level);
+        std::string out;
+        sanitizer.Feed(input.data(), input.size(), out);
+        assert(out == "abcd\x1b[1me\x07\r\n" + std::string(70, 'x') + std::string(70, 'y'));
+        assert(sanitizer.DroppedCount() == 6);
+    }
+
+    std::cout << "✓ Control characters test passed" << std::endl;
+}
+
+void test_binary_detection() {
+    std::mt19937 random(42);
+    std::string binary(64 * 1024, '\0');
+    for (char& c : binary) c = static_cast<char>(random() & 0xFF);
+
+    Utf8Sanitizer sanitizer;
+    std::string out;
+    sanitizer.Feed(binary.data(), binary.size(), out);
+    assert(sanitizer.LooksBinary());
+    assert(sanitizer.BytesSeen() == binary.size());
+
+    // A few bad bytes in text don't make it binary, a NUL early on does
+    std::string text(4000, 'a');
+    text[100] = '\xFF';
+    text[200] = '\x01';
+    Utf8Sanitizer mostlyText;
+    out.clear();
+    mostlyText.Feed(text.data(), text.size(), out);
+    assert(!mostlyText.LooksBinary());
+
+    Utf8Sanitizer withNul;
+    out.clear();
+    withNul.Feed("ELF\0", 4, out);
+    assert(withNul.LooksBinary());
+
+    // Past the sniffed prefix, nothing changes the verdict
+    std::string late(Utf8Sanitizer::kSniffBytes, 'a');
+    late += binary;
+    Utf8Sanitizer lateBinary;
+    out.clear();
+    lateBinary.Feed(late.data(), late.size(), out);
+    assert(!lateBinary.LooksBinary());
+
+    std::cout << "✓ Binary detection test passed" << std::endl;
+}
+
+void test_levels_agree() {
+    // Random mixes of ASCII, valid multibyte and garbage give identical output everywhere
+    std::mt19937 random(7);
+    const char* pieces[] = { "hello ", "\n", "\t", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+                             "\x80", "\xC3", "\xE2\x82", "\x00", "\x1b[0m", "\x7F", "\xF5" };
+    const size_t lengths[] = { 6, 1, 1, 2, 3, 4, 1, 1, 2, 1, 4, 1, 1 };
+
+    for (int round = 0; round < 200; ++round) {
+        // Mostly ASCII with frequent damage, or long valid multibyte text with the odd bad byte
+        bool rare = round % 2 == 1;
+        std::string input;
+        while (input.size() < 4000) {
+            size_t index;
+            if (rare) {
+                index = random() % 300 == 0 ? 6 + random() % 7 : random() % 6;
+            } else {
+                index = random() % 4 != 0 ? random() % 3 : random() % 13;
+            }
+            input.append(pieces[index], lengths[index]);
+        }
+        std::string expected = Sanitize(input, SimdLevel::Scalar);
+        for (SimdLevel level : Levels()) {
+            assert(Sanitize(input, level) == expected);
+            assert(Sanitize(input, level, 1 + random() % 64) == expected);
+        }
+    }
+
+    std::cout << "✓ Levels agree test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n=== Running UTF-8 Sanitizer Tests ===\n" << std::endl;
+    std::cout << "Best level: " << Utf8Sanitizer::LevelName(Utf8Sanitizer::BestLevel()) << std::endl;
+
+    test_valid_text_unchanged();
+    test_invalid_sequences_replaced();
+    test_controls_dropped();
+    test_binary_detection();
+    test_levels_agree();
+
+    std::cout << "\n✅ All UTF-8 sanitizer tests passed!\n" << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "../include/terminal/working_directory.h"
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+
+using namespace NeuroShell;
+namespace fs = std::filesystem;
+
+void test_current() {
+    WorkingDirectory dir = WorkingDirectory::Current();
+    assert(dir.IsValid());
+    assert(dir.Path() == fs::current_path().string());
+#ifndef _WIN32
+    assert(dir.Fd() >= 0);
+#endif
+
+    assert(!WorkingDirectory().IsValid());
+
+    std::cout << "✓ Current directory test passed" << std::endl;
+}
+
+void test_resolve() {
+    fs::path base = fs::temp_directory_path() / "neuroshell_wd_test";
+    fs::remove_all(base);
+    fs::create_directories(base / "a" / "b");
+    std::string start = fs::current_path().string();
+
+    WorkingDirectory root, a, b, up;
+    assert(WorkingDirectory::Current().Resolve(base.string(), root));
+    assert(root.Path() == base.string());
+
+    // Relative paths start from the directory they are resolved against
+    assert(root.Resolve("a", a));
+    assert(a.Path() == (base / "a").string());
+    assert(a.Resolve("b/", b));
+    assert(b.Path() == (base / "a" / "b").string());
+    assert(b.Resolve("../..", up));
+    assert(up.Path() == fs::canonical(base).string());
+
+    // Failed lookups leave the result alone
+    WorkingDirectory missing = b;
+    assert(!a.Resolve("nope", missing));
+    assert(missing.Path() == b.Path());
+
+    // The process never moved
+    assert(fs::current_path().string() == start);
+
+    fs::remove_all(base);
+    std::cout << "✓ Resolve test passed" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << "\n=== Running Working Directory Tests ===\n" << std::endl;
+
+    try {
+        test_current();
+        test_resolve();
+
+        std::cout << "\n✅ All working directory tests passed!\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\n❌ Test failed: " << e.what() << std::endl;
+        return 1;
+    }
+}